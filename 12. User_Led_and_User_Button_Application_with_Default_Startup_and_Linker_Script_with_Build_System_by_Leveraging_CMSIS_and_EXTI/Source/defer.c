@@ -0,0 +1,81 @@
+#include <stddef.h>
+#include "defer.h"
+#include "queue.h"
+
+/* Deferred interrupt work
+ * Interrupt handlers only queue a work item (function and argument) with defer_post() and pend a software
+ * interrupt running at the lowest priority. Its handler drains the queue, so the slow part (printf, waiting
+ * for a pin, flash or backup register writes) runs after all other interrupts and never delays them.
+ * The queue accepts producers of any priority. The DWT cycle counter measures the posting handlers and
+ * the work items, the worst cases are kept in the statistics.
+ */
+
+// Queued work item
+typedef struct {
+    defer_fn_t fn; // Function to call
+    uint32_t arg;  // Argument passed to fn
+} defer_item_t;
+
+// Work items, produced by any interrupt and consumed by the software interrupt only
+MPSC_QUEUE_DEFINE(defer_queue, defer_item_t, DEFER_QUEUE_SIZE);
+
+static defer_stats_t defer_stats;
+
+void defer_init(void) {
+    mpsc_queue_init(&defer_queue);
+
+    // Enable the DWT cycle counter for the measurements
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // Lowest priority, every other handler preempts the work items
+    NVIC_SetPriority(DEFER_IRQn, (1U << __NVIC_PRIO_BITS) - 1U);
+    NVIC_EnableIRQ(DEFER_IRQn);
+}
+
+uint8_t defer_post(defer_fn_t fn, uint32_t arg) {
+    defer_item_t item = { .fn = fn, .arg = arg };
+
+    if (!mpsc_queue_push(&defer_queue, &item)) {
+        defer_stats.dropped++;
+        return 0;
+    }
+
+    defer_stats.posted++;
+
+    // Run the work once no other interrupt is active
+    NVIC_SetPendingIRQ(DEFER_IRQn);
+
+    return 1;
+}
+
+void defer_isr_exit(uint32_t start) {
+    uint32_t cycles = DWT->CYCCNT - start;
+
+    if (cycles > defer_stats.max_isr_cycles) {
+        defer_stats.max_isr_cycles = cycles;
+    }
+}
+
+void defer_get_stats(defer_stats_t *stats) {
+    *stats = defer_stats;
+}
+
+void DEFER_IRQHandler(void) {
+    defer_item_t item;
+
+    // Items posted while draining are executed in the same run
+    while (mpsc_queue_pop(&defer_queue, &item)) {
+        uint32_t start = DWT->CYCCNT;
+
+        item.fn(item.arg);
+
+        uint32_t cycles = DWT->CYCCNT - start;
+
+        if (cycles > defer_stats.max_work_cycles) {
+            defer_stats.max_work_cycles = cycles;
+        }
+
+        defer_stats.executed++;
+    }
+}
@@ -0,0 +1,116 @@
+#include <stddef.h>
+#include "event_loop.h"
+#include "systick.h"
+
+/* Event-driven main loop
+ * Interrupt handlers only record what happened with event_post(), an atomic OR into a bitmask, and the
+ * main loop runs the matching handlers in thread context, lowest event number first. When nothing is
+ * pending the core sleeps in WFI. Optionally SLEEPONEXIT keeps it asleep across interrupts that did not
+ * post an event, which saves the return to thread mode; event_post() clears it again to let the loop run.
+ *
+ * The idle percentage is the share of wall time (SysTick based) spent between entering WFI and resuming
+ * the loop, measured since the previous call of event_loop_idle_percent().
+ */
+
+static event_handler_t event_handlers[EVENT_LOOP_MAX_EVENTS];
+static volatile uint32_t events_pending;
+static uint8_t events_sleep_on_exit;
+
+static uint64_t idle_us;
+static uint64_t window_start_us;
+
+void event_loop_init(uint8_t sleep_on_exit) {
+    // The wall clock for the idle measurement
+    systick_init();
+
+    events_sleep_on_exit = sleep_on_exit;
+    window_start_us = micros();
+    idle_us = 0;
+}
+
+void event_register(uint8_t event, event_handler_t handler) {
+    if (event < EVENT_LOOP_MAX_EVENTS) {
+        event_handlers[event] = handler;
+    }
+}
+
+void event_post(uint32_t events) {
+    uint32_t value;
+
+    // Atomic OR: retry when another context wrote the mask between the exclusive load and store
+    do {
+        value = __LDREXW(&events_pending) | events;
+    } while (__STREXW(value, &events_pending) != 0U);
+
+    // Return to the loop after this interrupt instead of going back to sleep
+    SCB->SCR &= ~SCB_SCR_SLEEPONEXIT_Msk;
+}
+
+uint8_t event_loop_dispatch(void) {
+    uint32_t pending = events_pending;
+
+    if (pending == 0U) {
+        return 0;
+    }
+
+    // Highest priority first: the lowest set bit
+    uint32_t event = __CLZ(__RBIT(pending));
+    uint32_t value;
+
+    // Atomically take the event out of the mask
+    do {
+        value = __LDREXW(&events_pending) & ~EVENT_MASK(event);
+    } while (__STREXW(value, &events_pending) != 0U);
+
+    if (event_handlers[event] != NULL) {
+        event_handlers[event]();
+    }
+
+    return 1;
+}
+
+void event_loop_idle(void) {
+    // Mask interrupts so one that posts an event between the check and WFI cannot be missed,
+    // a pending interrupt still ends WFI and is taken when PRIMASK is cleared
+    __disable_irq();
+
+    if (events_pending != 0U) {
+        __enable_irq();
+        return;
+    }
+
+    if (events_sleep_on_exit) {
+        SCB->SCR |= SCB_SCR_SLEEPONEXIT_Msk;
+    }
+
+    uint64_t start = micros();
+
+    __DSB();
+    __WFI();
+
+    // With SLEEPONEXIT the core only gets past this point once an interrupt posted an event
+    __enable_irq();
+
+    idle_us += micros() - start;
+}
+
+void event_loop_run(void) {
+    while (1) {
+        // Handle one event at a time so a newly posted higher-priority event goes first
+        if (!event_loop_dispatch()) {
+            event_loop_idle();
+        }
+    }
+}
+
+uint32_t event_loop_idle_percent(void) {
+    uint64_t now = micros();
+    uint64_t window = now - window_start_us;
+    uint32_t percent = (window != 0U) ? (uint32_t)((idle_us * 100U) / window) : 0U;
+
+    // Start a new measurement window
+    window_start_us = now;
+    idle_us = 0;
+
+    return percent;
+}
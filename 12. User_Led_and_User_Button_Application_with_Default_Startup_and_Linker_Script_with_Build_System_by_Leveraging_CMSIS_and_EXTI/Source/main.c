@@ -2,13 +2,23 @@
  * This code demonstrates how to initialize UART2 for debugging,
  * configure an LED output, and handle an external interrupt on pin PC13
  * using the CMSIS framework on an STM32F4 microcontroller.
+ * The interrupt only queues the button handling as deferred work, which runs in
+ * the lowest priority software interrupt while the main loop sleeps. The deferred work
+ * posts an event for the idle report, which wakes the main loop: with SLEEPONEXIT only
+ * an event brings the core back to thread mode, where the time asleep is accounted.
  */
 #include <stdio.h>
 #include "uart.h"
 #include "gpio.h"
 #include "gpio_exti.h"
+#include "event_loop.h"
+#include "defer.h"
 
-static void exti13_callback(void);
+// Macro to define the event of the idle report
+#define EVENT_IDLE_REPORT 0U
+
+static void exti13_callback(uint32_t arg);
+static void idle_report(void);
 void EXTI15_10_IRQHandler(void);
 
 /**
@@ -21,26 +31,50 @@ int main(void) {
     // Initialize user LED peripheral
     led_init();
 
+    // Handle the button in the deferred work interrupt, the main loop only sleeps
+    defer_init();
+    event_loop_init(1);
+    event_register(EVENT_IDLE_REPORT, idle_report);
+
     // Initialize EXTI 13 peripheral
     pc13_exti13_init();
 
-    while (1) {
-    }
+    // Sleep, the core stays asleep across the interrupts that post no event
+    event_loop_run();
 
     return 0;
 }
 
-static void exti13_callback(void) {
+static void exti13_callback(uint32_t arg) {
+    (void)arg;
+
     printf("An external interrupt occurred (Button is pressed)...\n\r");
     led_toggle();
+
+    // Report the worst case execution time of the button interrupt
+    defer_stats_t stats;
+    defer_get_stats(&stats);
+    printf("EXTI worst case: %lu cycles\n\r", (unsigned long)stats.max_isr_cycles);
+
+    // Let the main loop wake up, account the time it slept and report it
+    event_post(EVENT_MASK(EVENT_IDLE_REPORT));
+}
+
+static void idle_report(void) {
+    // Report how much of the time since the last press the core was asleep
+    printf("Idle: %lu%%\n\r", (unsigned long)event_loop_idle_percent());
 }
 
 void EXTI15_10_IRQHandler(void) {
+    uint32_t start = defer_isr_enter();
+
     if ((EXTI->PR & (LINE13)) != 0) {
         // Clear PR (pending bit) flag
         EXTI->PR |= LINE13;
 
-        // Execute the callback function to handle the external interrupt
-        exti13_callback();
+        // Let the software interrupt execute the callback function
+        defer_post(exti13_callback, 0);
     }
+
+    defer_isr_exit(start);
 }
@@ -3,37 +3,169 @@
 // Macro to enable the SysTick timer
 #define CTRL_ENABLE (1U << 0)
 
+// Macro to enable the SysTick exception request when the counter reaches zero
+#define CTRL_TICKINT (1U << 1)
+
 // Macro to select the internal clock source for the SysTick timer
 #define CTRL_CLKSOURCE (1U << 2)
 
-// Macro to check the COUNTFLAG bit, which indicates when the timer has counted to zero
-#define CTRL_COUNTFLAG (1U << 16)
+// Macro to define the system clock frequency which is 16 MHz (default)
+#define SYS_FREQ 16000000U
 
 // Macro to define the number of clock cycles in 1 millisecond
 // By default, the frequency of the MCU is 16 MHz.
 // 16 MHz / 1000 = 16000 cycles per millisecond
-#define CLK_CYCLES_IN_ONE_MSEC (16000U)
+#define CLK_CYCLES_IN_ONE_MSEC (SYS_FREQ / SYSTICK_TICK_HZ)
+
+// Macro to define the number of clock cycles in 1 microsecond
+#define CLK_CYCLES_IN_ONE_USEC (SYS_FREQ / 1000000U)
+
+// Number of SysTick interrupts since systick_init(), i.e. milliseconds of uptime
+static volatile uint64_t systick_ticks;
+
+static uint8_t systick_is_masked(void);
+static void systick_poll(void);
+
+void systick_init(void) {
+    // The time base is free-running, so it is only started once
+    if (SysTick->CTRL & CTRL_ENABLE) {
+        return;
+    }
 
-void systick_msec_delay(uint32_t delay) {
     // Load the SysTick timer with the number of clock cycles for 1 millisecond
     SysTick->LOAD = CLK_CYCLES_IN_ONE_MSEC - 1;
 
     // Clear SysTick current value register to reset the timer
     SysTick->VAL = 0;
 
-    // Select internal clock source
-    SysTick->CTRL |= CTRL_CLKSOURCE;
+    // Select internal clock source, enable the interrupt and start the timer
+    SysTick->CTRL = CTRL_CLKSOURCE | CTRL_TICKINT | CTRL_ENABLE;
+}
+
+uint64_t systick_get_ticks(void) {
+    uint64_t ticks;
+
+    // The 64-bit counter is read in two halves, so read again if the interrupt updated it in between
+    do {
+        ticks = systick_ticks;
+    } while (ticks != systick_ticks);
+
+    return ticks;
+}
+
+uint32_t millis(void) {
+    return (uint32_t)systick_get_ticks();
+}
+
+uint64_t micros(void) {
+    uint64_t ticks;
+    uint32_t val;
+
+    // Sample the tick counter and the current value register as one consistent pair
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    ticks = systick_ticks;
+    val = SysTick->VAL;
+
+    // The counter may have wrapped after the interrupts were masked, in which case the tick is
+    // still pending and VAL already belongs to the next millisecond
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && (val > (CLK_CYCLES_IN_ONE_MSEC / 2U))) {
+        ticks++;
+    }
+
+    __set_PRIMASK(primask);
+
+    // SysTick counts down, so the elapsed part of the current millisecond is LOAD - VAL
+    return (ticks * 1000U) + ((CLK_CYCLES_IN_ONE_MSEC - 1U - val) / CLK_CYCLES_IN_ONE_USEC);
+}
+
+deadline_t deadline_after_ms(uint32_t msec) {
+    // Make sure the time base is running, the deadline would never expire otherwise
+    systick_init();
+
+    return systick_get_ticks() + msec;
+}
+
+uint8_t deadline_expired(deadline_t deadline) {
+    // Count a pending tick here if the caller masks the SysTick interrupt
+    systick_poll();
+
+    return (systick_get_ticks() >= deadline);
+}
+
+void systick_msec_delay(uint32_t delay) {
+    // Make sure the time base is running
+    systick_init();
+
+    uint64_t start = micros();
+
+    // Wait for the full number of milliseconds independently of the phase of the current tick
+    // A pending tick is counted here if the caller masks the SysTick interrupt, micros() would wrap back otherwise
+    while ((micros() - start) < ((uint64_t)delay * 1000U)) {
+        systick_poll();
+    }
+}
 
-    // Enable SysTick timer
-    SysTick->CTRL |= CTRL_ENABLE;
+void systick_compensate(uint32_t msec) {
+    // Account for time spent with the SysTick clock stopped (Stop mode)
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
 
-    // Handle the specified delay duration
-    for (volatile uint32_t i = 0; i < delay; i++) {
-        // Wait for the COUNTFLAG bit to be set, indicating the timer has counted down
-        while ((SysTick->CTRL & CTRL_COUNTFLAG) == 0) {
-        }
+    systick_ticks += msec;
+
+    __set_PRIMASK(primask);
+}
+
+static uint8_t systick_is_masked(void) {
+    // Interrupts are disabled
+    if (__get_PRIMASK() || __get_FAULTMASK()) {
+        return 1;
     }
 
-    // Disable SysTick timer
-    SysTick->CTRL &= ~CTRL_ENABLE;
+    // The priority field uses the upper bits of the byte, like BASEPRI
+    uint32_t tick_prio = NVIC_GetPriority(SysTick_IRQn) << (8U - __NVIC_PRIO_BITS);
+    uint32_t basepri = __get_BASEPRI();
+
+    if ((basepri != 0U) && (basepri <= tick_prio)) {
+        return 1;
+    }
+
+    uint32_t active = __get_IPSR();
+
+    if (active == 0U) {
+        return 0;
+    }
+
+    // NMI and HardFault have fixed priorities above every configurable one
+    if (active < 4U) {
+        return 1;
+    }
+
+    // The running exception preempts the tick unless its priority is lower (numerically higher)
+    // Exception numbers start 16 below the IRQ numbers
+    return (NVIC_GetPriority((IRQn_Type)((int32_t)active - 16)) << (8U - __NVIC_PRIO_BITS)) <= tick_prio;
+}
+
+static void systick_poll(void) {
+    if (!(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) || !systick_is_masked()) {
+        return;
+    }
+
+    // Take the pending tick over, so that a wait with the interrupt masked still ends. Polling has to
+    // happen at least once per millisecond to lose no tick, as only one tick can be pending.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+        systick_ticks++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void SysTick_Handler(void) {
+    // Advance the time base by one millisecond
+    systick_ticks++;
 }
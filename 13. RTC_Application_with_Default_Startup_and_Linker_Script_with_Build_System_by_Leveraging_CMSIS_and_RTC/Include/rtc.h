@@ -4,6 +4,19 @@
 #include <stdint.h>
 #include "stm32f4xx.h"
 
+// Consistent copy of the calendar taken by rtc_get_snapshot()
+typedef struct {
+    uint16_t year;        // 2000 to 2099
+    uint8_t month;        // 1 to 12
+    uint8_t day;          // 1 to 31
+    uint8_t weekday;      // 1 (Monday) to 7 (Sunday)
+    uint8_t hour;         // 0 to 23, also when the RTC runs in 12-hour format
+    uint8_t minute;       // 0 to 59
+    uint8_t second;       // 0 to 59
+    uint16_t millisecond; // 0 to 999, derived from the sub-second register
+    uint32_t epoch;       // Seconds since 1970-01-01 00:00:00 (calendar taken as UTC)
+} rtc_snapshot_t;
+
 /* Function Declarations */
 void rtc_enable_initialization_mode(void);
 void rtc_disable_initialization_mode(void);
@@ -18,5 +31,7 @@ uint8_t rtc_date_get_current_year(void);
 uint8_t rtc_time_get_current_second(void);
 uint8_t rtc_time_get_current_minute(void);
 uint8_t rtc_time_get_current_hour(void);
+uint32_t rtc_to_epoch(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second);
+void rtc_get_snapshot(rtc_snapshot_t *snapshot);
 
 #endif /* INCLUDE_RTC_H_ */
@@ -9,13 +9,6 @@
 
 static void display_rtc_calendar(void);
 
-// The length of the buffer for storing the time and date string
-#define BUFF_LEN 16
-
-// Arrays that hold the formatted time and date strings
-uint8_t time_buff[BUFF_LEN] = {0};
-uint8_t date_buff[BUFF_LEN] = {0};
-
 /**
  * Main function: Initializes UART2 and RTC, then continuously displays time and date.
  */
@@ -35,18 +28,13 @@ int main(void) {
 }
 
 static void display_rtc_calendar(void) {
-    // Time display format --> HH:MM:SS
-	sprintf((char *)time_buff, "%02d:%02d:%02d",
-	         rtc_time_get_current_hour(),
-	         rtc_time_get_current_minute(),
-	         rtc_time_get_current_second());
-
-    // Date display format --> YYYY-MM-DD
-    sprintf((char *)date_buff, "20%02d-%02d-%02d",
-             rtc_date_get_current_year(),
-             rtc_date_get_current_month(),
-             rtc_date_get_current_day());
-
-    // Print compact combined calendar format --> YYYY-MM-DD HH:MM:SS
-    printf("%s %s\n\r", date_buff, time_buff);
+    rtc_snapshot_t now;
+
+    // Take time and date in one consistent read so they cannot tear across a second rollover
+    rtc_get_snapshot(&now);
+
+    // Print compact combined calendar format --> YYYY-MM-DD HH:MM:SS.mmm
+    printf("%04u-%02u-%02u %02u:%02u:%02u.%03u\n\r",
+           now.year, now.month, now.day,
+           now.hour, now.minute, now.second, now.millisecond);
 }
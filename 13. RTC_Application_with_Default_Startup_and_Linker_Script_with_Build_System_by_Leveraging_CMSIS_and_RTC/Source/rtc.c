@@ -247,3 +247,70 @@ uint8_t rtc_time_get_current_hour(void) {
         return hour;
     }
 }
+
+// Macro to define one row of the BCD lookup table: ten valid codes followed by six invalid ones
+#define BCD_ROW(tens) (tens) * 10U + 0U, (tens) * 10U + 1U, (tens) * 10U + 2U, (tens) * 10U + 3U, \
+                      (tens) * 10U + 4U, (tens) * 10U + 5U, (tens) * 10U + 6U, (tens) * 10U + 7U, \
+                      (tens) * 10U + 8U, (tens) * 10U + 9U, 0U, 0U, 0U, 0U, 0U, 0U
+
+// Macro to define the number of days from 1970-01-01 to 2000-01-01
+#define RTC_EPOCH_DAYS_2000 10957U
+
+// Binary value of every two-digit BCD code
+static const uint8_t bcd2bin_lut[256] = {
+    BCD_ROW(0U), BCD_ROW(1U), BCD_ROW(2U), BCD_ROW(3U), BCD_ROW(4U), BCD_ROW(5U), BCD_ROW(6U), BCD_ROW(7U),
+    BCD_ROW(8U), BCD_ROW(9U), BCD_ROW(0U), BCD_ROW(0U), BCD_ROW(0U), BCD_ROW(0U), BCD_ROW(0U), BCD_ROW(0U)
+};
+
+// Days before the first day of each month in a non-leap year
+static const uint16_t days_before_month[12] = {
+    0U, 31U, 59U, 90U, 120U, 151U, 181U, 212U, 243U, 273U, 304U, 334U
+};
+
+uint32_t rtc_to_epoch(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+    uint32_t y = (uint32_t)year - 2000U;
+
+    // Every fourth year from 2000 to 2099 is a leap year, so (y + 3) / 4 leap days precede year y
+    // and the leap day of year y itself counts from March on
+    uint32_t leap = (uint32_t)((y & 3U) == 0U) & (uint32_t)(month > 2U);
+    uint32_t days = RTC_EPOCH_DAYS_2000 + (y * 365U) + ((y + 3U) >> 2) +
+                    days_before_month[(month - 1U) % 12U] + leap + (uint32_t)day - 1U;
+
+    return (days * 86400U) + ((uint32_t)hour * 3600U) + ((uint32_t)minute * 60U) + second;
+}
+
+void rtc_get_snapshot(rtc_snapshot_t *snapshot) {
+    // Reading SSR locks TR and DR in their shadow registers until DR is read, so the three reads below
+    // belong to the same second even if the calendar rolls over in between
+    uint32_t ssr = RTC->SSR;
+    uint32_t tr = RTC->TR;
+    uint32_t dr = RTC->DR;
+
+    // Decode the BCD fields with one table lookup each
+    uint8_t hour = bcd2bin_lut[(tr >> RTC_TR_HU_Pos) & 0x3FU];
+    snapshot->minute = bcd2bin_lut[(tr >> RTC_TR_MNU_Pos) & 0x7FU];
+    snapshot->second = bcd2bin_lut[(tr >> RTC_TR_SU_Pos) & 0x7FU];
+    snapshot->year = (uint16_t)(2000U + bcd2bin_lut[(dr >> RTC_DR_YU_Pos) & 0xFFU]);
+    snapshot->month = bcd2bin_lut[(dr >> RTC_DR_MU_Pos) & 0x1FU];
+    snapshot->day = bcd2bin_lut[(dr >> RTC_DR_DU_Pos) & 0x3FU];
+    snapshot->weekday = (uint8_t)((dr & RTC_DR_WDU) >> RTC_DR_WDU_Pos);
+
+    // In 12-hour mode map 12 AM to 0 and add 12 for PM hours (TR PM bit only set in 12-hour mode)
+    if (RTC->CR & CR_FMT) {
+        hour = (uint8_t)((hour % 12U) + ((tr & TIME_FORMAT_PM) ? 12U : 0U));
+    }
+
+    snapshot->hour = hour;
+
+    // The sub-second counter runs down from PREDIV_S to 0 once per second
+    uint32_t prediv_s = (RTC->PRER & RTC_PRER_PREDIV_S) >> RTC_PRER_PREDIV_S_Pos;
+
+    if (ssr > prediv_s) {
+        ssr = prediv_s;
+    }
+
+    snapshot->millisecond = (uint16_t)(((prediv_s - ssr) * 1000U) / (prediv_s + 1U));
+
+    snapshot->epoch = rtc_to_epoch(snapshot->year, snapshot->month, snapshot->day,
+                                   snapshot->hour, snapshot->minute, snapshot->second);
+}
@@ -13,12 +13,18 @@
 #include "gpio.h"
 #include "gpio_exti.h"
 #include "iwdg.h"
+#include "systick.h"
+#include "queue.h"
 
 static void check_reset_source(void);
 static void exti13_callback(void);
 void EXTI15_10_IRQHandler(void);
 
-uint8_t g_btn_press;
+// Period of the LED toggling that indicates normal operation in milliseconds
+#define LED_BLINK_PERIOD_MS 100U
+
+// Button presses, produced by the EXTI13 interrupt only
+SPSC_QUEUE_DEFINE(btn_press_queue, uint8_t, 4U);
 
 /**
  * Main function: Initializes UART2, user LED, external interrupt (PC13),
@@ -41,18 +47,29 @@ int main(void) {
     // Initialize IWDG peripheral
     iwdg_init();
 
+    // Start the system tick time base and schedule the first LED toggle
+    systick_init();
+    deadline_t next_toggle = deadline_after_ms(LED_BLINK_PERIOD_MS);
+    uint8_t btn_pressed = 0;
+    uint8_t press;
+
     while (1) {
+        // Latch the first button press reported by the interrupt
+        if (spsc_queue_pop_byte(&btn_press_queue, &press)) {
+            btn_pressed = 1;
+        }
+
     	// Continually check the state of the user button
     	// If the button hasn’t been pressed, it refreshes the IWDG to prevent a system reset
     	// and toggles the LED, providing a visual indicator of system activity.
-        if (g_btn_press != 1) {
+        if (btn_pressed != 1) {
             // Refresh IWDG down-counter to the default value
             IWDG->KR = IWDG_KEY_RELOAD;
 
-            led_toggle();
-
-            // Delay loop for visible blinking in a rapid pace
-            for (volatile int i = 0; i < 90000; i++) {
+            // Toggle the LED in a rapid pace without blocking the loop
+            if (deadline_expired(next_toggle)) {
+                led_toggle();
+                next_toggle += LED_BLINK_PERIOD_MS;
             }
         }
     }
@@ -72,18 +89,17 @@ static void check_reset_source(void) {
 
         printf("The last system reset was caused by IWDG...\n\r");
 
-        // Wait for the user to press the button
-        while (g_btn_press != 1) {
-        }
+        // Wait for the user to press the button, taking the press out of the queue
+        uint8_t press;
 
-        // Clear the button-press state
-        g_btn_press = 0;
+        while (!spsc_queue_pop_byte(&btn_press_queue, &press)) {
+        }
     }
 }
 
 static void exti13_callback(void) {
     printf("An external interrupt occurred (Button is pressed)...\n\r");
-    g_btn_press = 1;
+    spsc_queue_push_byte(&btn_press_queue, 1U);
 }
 
 void EXTI15_10_IRQHandler(void) {
@@ -24,6 +24,10 @@
 #include <stdio.h>
 #include "adc_dma.h"
 #include "uart.h"
+#include "systick.h"
+
+// Period of the sensor value reports in milliseconds
+#define SENSOR_REPORT_PERIOD_MS 100U
 
 extern uint16_t adc1_raw_data[NUM_OF_CHANNELS];
 
@@ -38,13 +42,18 @@ int main_1(void) {
     // Initialize ADC 1 with DMA 2 to continuously read sensor data from ADC 1 channels connected to GPIOA pins
     adc1_dma2_init();
 
+    // Start the system tick time base and schedule the first report
+    systick_init();
+    deadline_t next_report = deadline_after_ms(SENSOR_REPORT_PERIOD_MS);
+
     while (1) {
-    	// Print the values from two sensors stored in the adc1_raw_data array to the console
-        printf("Value from sensor one : %d \n\r ", adc1_raw_data[0]);
-        printf("Value from sensor two : %d \n\r ", adc1_raw_data[1]);
+        // Report the sensor values once per period without blocking the loop
+        if (deadline_expired(next_report)) {
+            next_report += SENSOR_REPORT_PERIOD_MS;
 
-        // Simple delay loop
-        for (volatile int i = 0; i < 90000; i++) {
+            // Print the values from two sensors stored in the adc1_raw_data array to the console
+            printf("Value from sensor one : %d \n\r ", adc1_raw_data[0]);
+            printf("Value from sensor two : %d \n\r ", adc1_raw_data[1]);
         }
     }
 
@@ -56,12 +65,10 @@ int main_1(void) {
 #include <string.h>
 #include "uart_dma.h"
 
-extern uint8_t g_uart_cmplt;
-extern uint8_t g_rx_cmplt;
-extern uint8_t g_tx_cmplt;
-extern char uart2_data_buffer[UART2_DATA_BUFF_SIZE];
 char msg_buff[150] ={'\0'}; // String buffer initialized to zero for UART 2 messages
 
+static void wait_for_uart2_tx_cmplt(void);
+
 /**
  * Main_2 function: Initializes UART2 and DMA1 for communication.
  * Waits for UART messages with 5 characters, echoes them back using
@@ -83,42 +90,55 @@ int main_2(void) {
     dma1_stream6_uart2_tx_config((uint32_t)msg_buff, strlen(msg_buff));
 
     // Wait until transmission is complete
-    while (!g_tx_cmplt) {
-    }
+    wait_for_uart2_tx_cmplt();
 
     // Continuously check whether a UART message has been received
     while (1) {
-        if (g_rx_cmplt) {
-        	// Format the received message into the output buffer
-            sprintf(msg_buff, "Message received : %s \r\n", uart2_data_buffer);
+        uart2_rx_msg_t msg;
 
-            // Reset completion flags before the next transmission
-            g_rx_cmplt = 0;
-            g_tx_cmplt = 0;
-            g_uart_cmplt = 0;
+        if (uart2_dma_receive(&msg)) {
+        	// Format the received message into the output buffer
+            sprintf(msg_buff, "Message received : %.*s \r\n", UART2_DATA_BUFF_SIZE, msg.data);
 
             // Transmit the formatted received UART message using DMA
             dma1_stream6_uart2_tx_config((uint32_t)msg_buff, strlen(msg_buff));
 
             // Wait until transmission is complete
-            while (!g_tx_cmplt) {
-            }
+            wait_for_uart2_tx_cmplt();
         }
     }
 
     return 0;
 }
 
+static void wait_for_uart2_tx_cmplt(void) {
+    uart_dma_event_t event;
+
+    // Wait on the completion flag of DMA1 Stream 6, the event queue can be full of UART TC events and
+    // drop the completion event. Nothing else reads the events here, so drain them meanwhile
+    while (!uart2_dma_tx_complete()) {
+        (void)uart2_dma_get_event(&event);
+    }
+}
+
 /* ================================================================================================================= */
 #include <stdio.h>
 #include "dma.h"
 #include "uart.h"
+#include "queue.h"
 
 #define BUFFER_SIZE 5
 uint16_t sensor_data_arr[BUFFER_SIZE] = {892, 731, 1234, 90, 23};
 uint16_t temp_data_arr[BUFFER_SIZE];
 
-volatile uint8_t g_transfer_cmplt; // DMA2 Stream 0 transfer complete flag to monitor the transfer status
+// Result of a DMA2 Stream 0 transfer
+typedef enum {
+    DMA_TRANSFER_CMPLT,
+    DMA_TRANSFER_ERROR
+} dma_transfer_result_t;
+
+// Transfer results, produced by the DMA2 Stream 0 interrupt only
+SPSC_QUEUE_DEFINE(dma2_result_queue, uint8_t, 4U);
 
 /**
  * Main function: Initializes UART2 for debugging and DMA2 Stream 0 for
@@ -126,9 +146,6 @@ volatile uint8_t g_transfer_cmplt; // DMA2 Stream 0 transfer complete flag to mo
  * buffer using DMA, then prints the transferred data over UART.
  */
 int main(void) {
-	// Initialize the transfer complete flag to zero
-    g_transfer_cmplt = 0;
-
     // Initialize UART 2 peripheral for debugging
     uart2_init();
 
@@ -138,17 +155,20 @@ int main(void) {
     // Start the DMA transfer
     dma2_transfer_start((uint32_t)sensor_data_arr, (uint32_t)temp_data_arr, BUFFER_SIZE);
 
-    // Wait until transmission is complete
-    while (!g_transfer_cmplt) {
-    }
+    // Wait until the transfer has finished, successfully or not
+    uint8_t result;
 
-    // Print the contents of the temp_data_arr to the console, confirming that the data has been successfully transferred
-    for (int i = 0; i < BUFFER_SIZE; i++) {
-        printf("Temporary buffer[%d]: %d\r\n", i, temp_data_arr[i]);
+    while (!spsc_queue_pop_byte(&dma2_result_queue, &result)) {
     }
 
-    // Reset the transfer completion flag
-    g_transfer_cmplt = 0;
+    if (result == DMA_TRANSFER_CMPLT) {
+        // Print the contents of the temp_data_arr to the console, confirming that the data has been successfully transferred
+        for (int i = 0; i < BUFFER_SIZE; i++) {
+            printf("Temporary buffer[%d]: %d\r\n", i, temp_data_arr[i]);
+        }
+    } else {
+        printf("DMA transfer error...\r\n");
+    }
 
     while (1) {
     }
@@ -159,8 +179,8 @@ int main(void) {
 void DMA2_Stream0_IRQHandler(void) {
     // Check if transfer complete interrupt occurred, i.e. the DMA transfer has successfully finished
     if ((DMA2->LISR) & LISR_TCIF0) {
-    	// Set the flag when a transfer complete event occurs on DMA2 Stream 0
-        g_transfer_cmplt = 1;
+    	// Report the transfer complete event of DMA2 Stream 0
+        spsc_queue_push_byte(&dma2_result_queue, DMA_TRANSFER_CMPLT);
 
         // Clear the transfer complete interrupt flag
         DMA2->LIFCR |= LIFCR_CTCIF0;
@@ -168,7 +188,8 @@ void DMA2_Stream0_IRQHandler(void) {
 
     // Check if transfer error interrupt occurred
     if ((DMA2->LISR) & LISR_TEIF0) {
-        // Do something for error handling...
+        // Report the failed transfer
+        spsc_queue_push_byte(&dma2_result_queue, DMA_TRANSFER_ERROR);
 
     	// Clear the transfer error interrupt flag
         DMA2->LIFCR |= LIFCR_CTEIF0;
@@ -1,4 +1,5 @@
 #include "uart_dma.h"
+#include "queue.h"
 
 // Macro to enable the clock for GPIOA (bit 0 in RCC_AHB1ENR)
 #define GPIOAEN (1U << 0)
@@ -93,11 +94,19 @@ static void uart2_set_baudrate(uint32_t periph_clk, uint32_t baudrate);
 // Array to store the incoming UART2 data
 char uart2_data_buffer[UART2_DATA_BUFF_SIZE];
 
-uint8_t g_uart_cmplt; // UART2 event flag
-uint8_t g_rx_cmplt;   // DMA1 Stream 5 event flag (indicates new data has been received)
-uint8_t g_tx_cmplt;   // DMA1 Stream 6 event flag (indicates new data has been transmitted)
+// Received messages, produced by the DMA1 Stream 5 interrupt only
+SPSC_QUEUE_DEFINE(uart2_rx_queue, uart2_rx_msg_t, 4U);
+
+// Driver events, produced by the UART2 and DMA1 Stream 6 interrupts
+MPSC_QUEUE_DEFINE(uart2_event_queue, uint8_t, 8U);
+
+// Set by DMA1 Stream 6 at the end of a transmission, kept apart from the event queue so it cannot be dropped
+static volatile uint8_t uart2_tx_done;
 
 void uart2_rx_tx_init(void) {
+    // Prepare the event queue before any interrupt can use it
+    mpsc_queue_init(&uart2_event_queue);
+
 	/************UART2 GPIOA Pins Configuration**********/
 	// Enable the clock access to GPIOA
     RCC->AHB1ENR |= GPIOAEN;
@@ -211,6 +220,7 @@ void dma1_stream6_uart2_tx_config(uint32_t msg_to_snd, uint32_t msg_len) {
 
     // Clear any existing interrupt flags for DMA1 Stream6
     DMA1->HIFCR = HIFCR_CDMEIF6 | HIFCR_CTEIF6 | HIFCR_CTCIF6;
+    uart2_tx_done = 0;
 
     // Set peripheral address to the UART2 data register
     DMA1_Stream6->PAR = (uint32_t)(&(USART2->DR));
@@ -240,6 +250,26 @@ void dma1_stream6_uart2_tx_config(uint32_t msg_to_snd, uint32_t msg_len) {
     DMA1_Stream6->CR |= DMA_SCR_EN;
 }
 
+uint8_t uart2_dma_receive(uart2_rx_msg_t *msg) {
+    return spsc_queue_pop(&uart2_rx_queue, msg);
+}
+
+uint8_t uart2_dma_tx_complete(void) {
+    return uart2_tx_done;
+}
+
+uint8_t uart2_dma_get_event(uart_dma_event_t *event) {
+    uint8_t value;
+
+    if (!mpsc_queue_pop_byte(&uart2_event_queue, &value)) {
+        return 0;
+    }
+
+    *event = (uart_dma_event_t)value;
+
+    return 1;
+}
+
 static uint16_t compute_uart_bd(uint32_t periph_clk, uint32_t baudrate) {
     return ((periph_clk + (baudrate / 2U)) / baudrate);
 }
@@ -250,8 +280,8 @@ static void uart2_set_baudrate(uint32_t periph_clk, uint32_t baudrate) {
 }
 
 void USART2_IRQHandler(void) {
-	// Set the flag when a UART2 event occurs
-    g_uart_cmplt = 1;
+	// Report the UART2 event
+    mpsc_queue_push_byte(&uart2_event_queue, UART_DMA_EVENT_UART_TC);
 
     // Clear any pending transmission complete flags
     USART2->SR &= ~SR_TC;
@@ -259,8 +289,14 @@ void USART2_IRQHandler(void) {
 
 void DMA1_Stream5_IRQHandler(void) {
     if ((DMA1->HISR) & HIFSR_TCIF5) {
-    	// Set the flag when a transfer complete event occurs on DMA1 Stream 5
-        g_rx_cmplt = 1;
+    	// Copy the message out before the circular transfer overwrites it (dropped if the queue is full)
+        uart2_rx_msg_t msg;
+
+        for (uint32_t i = 0; i < UART2_DATA_BUFF_SIZE; i++) {
+            msg.data[i] = uart2_data_buffer[i];
+        }
+
+        spsc_queue_push(&uart2_rx_queue, &msg);
 
         // Clear the transfer complete interrupt flag
         DMA1->HIFCR |= HIFCR_CTCIF5;
@@ -269,8 +305,9 @@ void DMA1_Stream5_IRQHandler(void) {
 
 void DMA1_Stream6_IRQHandler(void) {
     if ((DMA1->HISR) & HIFSR_TCIF6) {
-    	// Set the flag when a transfer complete event occurs on DMA1 Stream 6
-        g_tx_cmplt = 1;
+    	// Report the transfer complete event of DMA1 Stream 6
+        uart2_tx_done = 1;
+        mpsc_queue_push_byte(&uart2_event_queue, UART_DMA_EVENT_TX_CMPLT);
 
         // Clear the transfer complete interrupt flag
         DMA1->HIFCR |= HIFCR_CTCIF6;
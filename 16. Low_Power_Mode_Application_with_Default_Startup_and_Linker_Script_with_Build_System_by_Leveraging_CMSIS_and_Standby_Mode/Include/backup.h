@@ -0,0 +1,16 @@
+#ifndef INCLUDE_BACKUP_H_
+#define INCLUDE_BACKUP_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the number of payload bytes kept in RTC_BKP3R to RTC_BKP19R
+#define BACKUP_MAX_PAYLOAD 68U
+
+/* Function Declarations */
+void backup_init(void);
+uint8_t backup_save(uint8_t version, const void *data, uint8_t len);
+uint8_t backup_restore(uint8_t version, void *data, uint8_t len);
+void backup_invalidate(void);
+
+#endif /* INCLUDE_BACKUP_H_ */
@@ -0,0 +1,19 @@
+#ifndef INCLUDE_BENCH_H_
+#define INCLUDE_BENCH_H_
+
+#include <stdint.h>
+#include "profile.h"
+
+// A registered micro-benchmark
+typedef struct {
+    const char *name;      // Name printed in the result table
+    void (*setup)(void);   // Optional preparation executed once before the runs (may be NULL)
+    void (*run)(void);     // Code under test, executed once per iteration
+    uint32_t iterations;   // Number of measured iterations
+} bench_t;
+
+/* Function Declarations */
+void bench_run(const bench_t *benches, uint32_t count);
+void bench_print_probe(const profile_probe_t *probe);
+
+#endif /* INCLUDE_BENCH_H_ */
@@ -0,0 +1,7 @@
+#ifndef INCLUDE_BENCH_DRIVERS_H_
+#define INCLUDE_BENCH_DRIVERS_H_
+
+/* Function Declarations */
+void bench_run_drivers(void);
+
+#endif /* INCLUDE_BENCH_DRIVERS_H_ */
@@ -0,0 +1,46 @@
+#ifndef INCLUDE_BITBAND_H_
+#define INCLUDE_BITBAND_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/* Cortex-M4 bit-band access
+ * The first 1 MB of the SRAM and of the peripheral region is mirrored word per bit into an alias region:
+ * a word write to the alias of a bit sets or clears only that bit, and the bus performs the read-modify-write
+ * of the register as one locked transfer an interrupt cannot split. A single-bit update then needs no
+ * interrupt masking:
+ *
+ *     BITBAND_PERIPH_CLEAR(DMA1_Stream5->CR, DMA_SCR_EN);
+ *     while (BITBAND_PERIPH_TEST(DMA1_Stream5->CR, DMA_SCR_EN)) {
+ *     }
+ *
+ * For a register and a mask known at compile time the alias address is a constant, so the access compiles
+ * to a single store or load. Flag words must be statically allocated in SRAM1 (0x20000000-0x2001FFFF).
+ *
+ * The bus still writes the whole register back, so bit-band must not be used on registers holding flags
+ * that are cleared by writing 1 (rc_w1) or 0 (rc_w0) while the hardware may set them, e.g. USART_SR or
+ * EXTI_PR: a flag raised between the read and the write would be lost. Clear those with a direct write.
+ */
+
+// Macro to convert a single-bit mask into its bit number (constant for a constant mask)
+#define BITBAND_BIT(mask) ((uint32_t)__builtin_ctz(mask))
+
+// Macros to compute the alias address of a bit in the peripheral region and in SRAM1
+#define BITBAND_PERIPH_ALIAS(addr, bit) (PERIPH_BB_BASE + (((uint32_t)(addr) - PERIPH_BASE) * 32U) + ((uint32_t)(bit) * 4U))
+#define BITBAND_SRAM_ALIAS(addr, bit)   (SRAM_BB_BASE + (((uint32_t)(addr) - SRAM_BASE) * 32U) + ((uint32_t)(bit) * 4U))
+
+// Macros to access the alias word of a bit number in a peripheral register or an SRAM word
+#define BITBAND_PERIPH(addr, bit) (*(volatile uint32_t *)BITBAND_PERIPH_ALIAS((addr), (bit)))
+#define BITBAND_SRAM(addr, bit)   (*(volatile uint32_t *)BITBAND_SRAM_ALIAS((addr), (bit)))
+
+// Macros to set, clear and test a single-bit mask in a peripheral register
+#define BITBAND_PERIPH_SET(reg, mask)   (BITBAND_PERIPH(&(reg), BITBAND_BIT(mask)) = 1U)
+#define BITBAND_PERIPH_CLEAR(reg, mask) (BITBAND_PERIPH(&(reg), BITBAND_BIT(mask)) = 0U)
+#define BITBAND_PERIPH_TEST(reg, mask)  (BITBAND_PERIPH(&(reg), BITBAND_BIT(mask)) != 0U)
+
+// Macros to set, clear and test a single-bit mask in a flag word in SRAM
+#define BITBAND_SRAM_SET(word, mask)   (BITBAND_SRAM(&(word), BITBAND_BIT(mask)) = 1U)
+#define BITBAND_SRAM_CLEAR(word, mask) (BITBAND_SRAM(&(word), BITBAND_BIT(mask)) = 0U)
+#define BITBAND_SRAM_TEST(word, mask)  (BITBAND_SRAM(&(word), BITBAND_BIT(mask)) != 0U)
+
+#endif /* INCLUDE_BITBAND_H_ */
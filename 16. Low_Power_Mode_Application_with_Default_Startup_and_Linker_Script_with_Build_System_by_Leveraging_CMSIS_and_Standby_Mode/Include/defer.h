@@ -0,0 +1,40 @@
+#ifndef INCLUDE_DEFER_H_
+#define INCLUDE_DEFER_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the number of work items that can be pending (power of two)
+#define DEFER_QUEUE_SIZE 16U
+
+// Macro to select the interrupt used as software interrupt to drain the queue (SPI5 is not used)
+#define DEFER_IRQn SPI5_IRQn
+
+// Macro to name the handler of the software interrupt
+#define DEFER_IRQHandler SPI5_IRQHandler
+
+// Work function executed by the software interrupt
+typedef void (*defer_fn_t)(uint32_t arg);
+
+// Statistics of the deferred work queue
+typedef struct {
+    uint32_t posted;          // Number of queued work items
+    uint32_t dropped;         // Number of items lost because the queue was full
+    uint32_t executed;        // Number of executed work items
+    uint32_t max_isr_cycles;  // Longest interrupt handler measured with defer_isr_enter()/defer_isr_exit()
+    uint32_t max_work_cycles; // Longest work item
+} defer_stats_t;
+
+/* Function Declarations */
+void defer_init(void);
+uint8_t defer_post(defer_fn_t fn, uint32_t arg);
+void defer_isr_exit(uint32_t start);
+void defer_get_stats(defer_stats_t *stats);
+void DEFER_IRQHandler(void);
+
+// Start measuring an interrupt handler, pass the result to defer_isr_exit() at its end
+static inline uint32_t defer_isr_enter(void) {
+    return DWT->CYCCNT;
+}
+
+#endif /* INCLUDE_DEFER_H_ */
@@ -0,0 +1,23 @@
+#ifndef INCLUDE_EEPROM_H_
+#define INCLUDE_EEPROM_H_
+
+#include <stdint.h>
+#include "i2c.h"
+
+// Macro to define the 7-bit address of a 24Cxx EEPROM with its A2..A0 pins tied to ground
+#define EEPROM_24CXX_ADDR 0x50U
+
+// Description of a 24Cxx-style I2C EEPROM connected to I2C1
+typedef struct {
+    uint8_t saddr;      // 7-bit address of the device
+    uint8_t addr_bytes; // Memory address length: 1 for 24C01..24C16, 2 for 24C32 and larger
+    uint16_t page_size; // Size of a write page in bytes (e.g. 16 for 24C02, 64 for 24C256)
+    uint32_t capacity;  // Total size of the memory array in bytes
+} eeprom_t;
+
+/* Function Declarations */
+i2c_status_t eeprom_read(const eeprom_t *dev, uint32_t addr, uint32_t n, uint8_t *data);
+i2c_status_t eeprom_write(const eeprom_t *dev, uint32_t addr, uint32_t n, const uint8_t *data);
+i2c_status_t eeprom_wait_ready(const eeprom_t *dev);
+
+#endif /* INCLUDE_EEPROM_H_ */
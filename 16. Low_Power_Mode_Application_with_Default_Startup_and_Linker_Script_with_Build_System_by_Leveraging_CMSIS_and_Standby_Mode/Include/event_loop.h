@@ -0,0 +1,25 @@
+#ifndef INCLUDE_EVENT_LOOP_H_
+#define INCLUDE_EVENT_LOOP_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the number of events (one bit each, event 0 has the highest priority)
+#define EVENT_LOOP_MAX_EVENTS 32U
+
+// Macro to build the mask of one event for event_post()
+#define EVENT_MASK(event) (1UL << (event))
+
+// Function running in thread context when its event is pending
+typedef void (*event_handler_t)(void);
+
+/* Function Declarations */
+void event_loop_init(uint8_t sleep_on_exit);
+void event_register(uint8_t event, event_handler_t handler);
+void event_post(uint32_t events);
+uint8_t event_loop_dispatch(void);
+void event_loop_idle(void);
+void event_loop_run(void);
+uint32_t event_loop_idle_percent(void);
+
+#endif /* INCLUDE_EVENT_LOOP_H_ */
@@ -1,11 +1,32 @@
 #ifndef INCLUDE_GPIO_EXTI_H_
 #define INCLUDE_GPIO_EXTI_H_
 
+#include <stdint.h>
 #include "stm32f4xx.h"
 
-#define LINE13 (1U << 13)
+// Macro to define the number of GPIO EXTI lines (EXTI0-EXTI15)
+#define EXTI_GPIO_LINES 16U
+
+// Edges that trigger a line
+typedef enum {
+    EXTI_EDGE_RISING = 1,  // Low to high transition
+    EXTI_EDGE_FALLING = 2, // High to low transition
+    EXTI_EDGE_BOTH = 3     // Any transition
+} exti_edge_t;
+
+// Callback of a line, called in interrupt context with the pin number and its (settled) level
+typedef void (*exti_callback_t)(uint8_t pin, uint8_t level);
 
 /* Function Declarations */
-void pc13_exti13_init(void);
+uint8_t exti_register(GPIO_TypeDef *port, uint8_t pin, exti_edge_t edge, uint16_t debounce_ms, exti_callback_t callback);
+void exti_unregister(uint8_t pin);
+void EXTI0_IRQHandler(void);
+void EXTI1_IRQHandler(void);
+void EXTI2_IRQHandler(void);
+void EXTI3_IRQHandler(void);
+void EXTI4_IRQHandler(void);
+void EXTI9_5_IRQHandler(void);
+void EXTI15_10_IRQHandler(void);
+void TIM1_TRG_COM_TIM11_IRQHandler(void);
 
 #endif /* INCLUDE_GPIO_EXTI_H_ */
@@ -0,0 +1,135 @@
+#ifndef INCLUDE_GPIO_PIN_H_
+#define INCLUDE_GPIO_PIN_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/* Compile-time GPIO pin configuration
+ * The pins of one port are listed once as an X-macro, each entry X(pin, mode, otype, speed, pull, af):
+ *
+ *     #define UART2_PINS(X) \
+ *         X(2, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 7) \
+ *         X(3, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 7)
+ *
+ *     static const gpio_port_cfg_t uart2_pins = GPIO_PORT_CFG(A, UART2_PINS);
+ *
+ * GPIO_PORT_CFG() folds the list into one mask and one value per register as constant expressions, so
+ * gpio_port_apply() needs a single read-modify-write per register, whatever the number of pins.
+ * Output changes go through BSRR only, which is a single write that cannot race with other pins.
+ */
+
+// Pin modes (MODERy[1:0])
+#define GPIO_MODE_INPUT  0U
+#define GPIO_MODE_OUTPUT 1U
+#define GPIO_MODE_AF     2U
+#define GPIO_MODE_ANALOG 3U
+
+// Output types (OTy)
+#define GPIO_OTYPE_PP 0U // Push-pull
+#define GPIO_OTYPE_OD 1U // Open-drain
+
+// Output speeds (OSPEEDRy[1:0])
+#define GPIO_SPEED_LOW    0U
+#define GPIO_SPEED_MEDIUM 1U
+#define GPIO_SPEED_FAST   2U
+#define GPIO_SPEED_HIGH   3U
+
+// Pull-up/pull-down resistors (PUPDRy[1:0])
+#define GPIO_PULL_NONE 0U
+#define GPIO_PULL_UP   1U
+#define GPIO_PULL_DOWN 2U
+
+// Folded configuration of one port
+typedef struct {
+    GPIO_TypeDef *port;    // Port the pins belong to
+    uint32_t clock;        // Clock enable bit of the port in RCC_AHB1ENR
+    uint32_t moder_mask;   // MODER bits owned by the listed pins
+    uint32_t moder;        // MODER value of the listed pins
+    uint32_t otyper_mask;  // OTYPER bits owned by the listed pins
+    uint32_t otyper;       // OTYPER value of the listed pins
+    uint32_t ospeedr_mask; // OSPEEDR bits owned by the listed pins
+    uint32_t ospeedr;      // OSPEEDR value of the listed pins
+    uint32_t pupdr_mask;   // PUPDR bits owned by the listed pins
+    uint32_t pupdr;        // PUPDR value of the listed pins
+    uint32_t afr_mask[2];  // AFRL/AFRH bits owned by the listed alternate function pins
+    uint32_t afr[2];       // AFRL/AFRH value of the listed alternate function pins
+} gpio_port_cfg_t;
+
+// Macros to contribute the fields of one pin to the folded registers
+#define GPIO_CFG_2BIT_MASK(pin, mode, otype, speed, pull, af) | (3UL << ((pin) * 2U))
+#define GPIO_CFG_MODER(pin, mode, otype, speed, pull, af)     | ((uint32_t)(mode) << ((pin) * 2U))
+#define GPIO_CFG_OTYPER_MASK(pin, mode, otype, speed, pull, af) | (1UL << (pin))
+#define GPIO_CFG_OTYPER(pin, mode, otype, speed, pull, af)    | ((uint32_t)(otype) << (pin))
+#define GPIO_CFG_OSPEEDR(pin, mode, otype, speed, pull, af)   | ((uint32_t)(speed) << ((pin) * 2U))
+#define GPIO_CFG_PUPDR(pin, mode, otype, speed, pull, af)     | ((uint32_t)(pull) << ((pin) * 2U))
+#define GPIO_CFG_AFRL_MASK(pin, mode, otype, speed, pull, af) | (((mode) == GPIO_MODE_AF && (pin) < 8U) ? (0xFUL << (((pin) & 7U) * 4U)) : 0UL)
+#define GPIO_CFG_AFRL(pin, mode, otype, speed, pull, af)      | (((mode) == GPIO_MODE_AF && (pin) < 8U) ? ((uint32_t)(af) << (((pin) & 7U) * 4U)) : 0UL)
+#define GPIO_CFG_AFRH_MASK(pin, mode, otype, speed, pull, af) | (((mode) == GPIO_MODE_AF && (pin) >= 8U) ? (0xFUL << (((pin) & 7U) * 4U)) : 0UL)
+#define GPIO_CFG_AFRH(pin, mode, otype, speed, pull, af)      | (((mode) == GPIO_MODE_AF && (pin) >= 8U) ? ((uint32_t)(af) << (((pin) & 7U) * 4U)) : 0UL)
+
+// Macro to fold an X-macro pin list of port GPIO<letter> into a gpio_port_cfg_t initializer
+#define GPIO_PORT_CFG(letter, list) {                          \
+    .port = GPIO##letter,                                      \
+    .clock = RCC_AHB1ENR_GPIO##letter##EN,                     \
+    .moder_mask = 0UL list(GPIO_CFG_2BIT_MASK),                \
+    .moder = 0UL list(GPIO_CFG_MODER),                         \
+    .otyper_mask = 0UL list(GPIO_CFG_OTYPER_MASK),             \
+    .otyper = 0UL list(GPIO_CFG_OTYPER),                       \
+    .ospeedr_mask = 0UL list(GPIO_CFG_2BIT_MASK),              \
+    .ospeedr = 0UL list(GPIO_CFG_OSPEEDR),                     \
+    .pupdr_mask = 0UL list(GPIO_CFG_2BIT_MASK),                \
+    .pupdr = 0UL list(GPIO_CFG_PUPDR),                         \
+    .afr_mask = { 0UL list(GPIO_CFG_AFRL_MASK), 0UL list(GPIO_CFG_AFRH_MASK) }, \
+    .afr = { 0UL list(GPIO_CFG_AFRL), 0UL list(GPIO_CFG_AFRH) } \
+}
+
+// Macro to build the BSRR/IDR mask of a pin
+#define GPIO_PIN_MASK(pin) (1UL << (pin))
+
+// Apply a folded port configuration with one read-modify-write per register
+static inline void gpio_port_apply(const gpio_port_cfg_t *cfg) {
+    GPIO_TypeDef *port = cfg->port;
+
+    // Enable the clock access to the port
+    RCC->AHB1ENR |= cfg->clock;
+
+    // Select the alternate functions and the output stage first, so the pins never drive a wrong level
+    // once MODER switches them
+    if (cfg->afr_mask[0] != 0U) {
+        port->AFR[0] = (port->AFR[0] & ~cfg->afr_mask[0]) | cfg->afr[0];
+    }
+
+    if (cfg->afr_mask[1] != 0U) {
+        port->AFR[1] = (port->AFR[1] & ~cfg->afr_mask[1]) | cfg->afr[1];
+    }
+
+    port->OTYPER = (port->OTYPER & ~cfg->otyper_mask) | cfg->otyper;
+    port->OSPEEDR = (port->OSPEEDR & ~cfg->ospeedr_mask) | cfg->ospeedr;
+    port->PUPDR = (port->PUPDR & ~cfg->pupdr_mask) | cfg->pupdr;
+    port->MODER = (port->MODER & ~cfg->moder_mask) | cfg->moder;
+}
+
+// Drive the pins high (single BSRR write)
+static inline void gpio_set(GPIO_TypeDef *port, uint32_t pins) {
+    port->BSRR = pins;
+}
+
+// Drive the pins low (single BSRR write)
+static inline void gpio_clear(GPIO_TypeDef *port, uint32_t pins) {
+    port->BSRR = pins << 16;
+}
+
+// Invert the pins: the high ones are reset and the low ones set in the same BSRR write, so an interrupt
+// changing other pins of the port between the ODR read and the write is not overwritten
+static inline void gpio_toggle(GPIO_TypeDef *port, uint32_t pins) {
+    uint32_t odr = port->ODR;
+
+    port->BSRR = ((odr & pins) << 16) | (~odr & pins);
+}
+
+// Read the input level of a pin
+static inline uint32_t gpio_read(const GPIO_TypeDef *port, uint32_t pin_mask) {
+    return port->IDR & pin_mask;
+}
+
+#endif /* INCLUDE_GPIO_PIN_H_ */
@@ -4,10 +4,47 @@
 #include <stdint.h>
 #include "stm32f4xx.h"
 
+// Result of an I2C1 bus operation
+typedef enum {
+    I2C_OK = 0,        // The operation completed successfully
+    I2C_ERR_TIMEOUT,   // A flag did not change state within I2C_TIMEOUT_MS
+    I2C_ERR_BERR,      // Misplaced start or stop condition detected on the bus
+    I2C_ERR_ARLO,      // Arbitration lost to another master
+    I2C_ERR_AF,        // The slave did not acknowledge (address or data byte)
+    I2C_ERR_OVR,       // Overrun/underrun of the data register
+    I2C_ERR_INVALID    // The request is invalid (e.g. an address outside of the device)
+} i2c_status_t;
+
+// Per-bus error counters
+typedef struct {
+    uint32_t timeouts;           // Number of I2C_ERR_TIMEOUT events
+    uint32_t bus_errors;         // Number of I2C_ERR_BERR events
+    uint32_t arbitration_losses; // Number of I2C_ERR_ARLO events
+    uint32_t nacks;              // Number of I2C_ERR_AF events
+    uint32_t overruns;           // Number of I2C_ERR_OVR events
+    uint32_t recoveries;         // Number of bus recovery sequences performed
+} i2c_error_stats_t;
+
+// Descriptor of a single register read inside a chained (repeated start) I2C1 transaction
+typedef struct {
+    uint8_t saddr;  // 7-bit address of the slave device
+    uint8_t maddr;  // Memory/register address inside the slave device
+    uint32_t n;     // Number of bytes to read (must be at least 1)
+    uint8_t *data;  // Destination buffer for the received bytes
+} i2c1_read_req_t;
+
 /* Function Declarations */
 void i2c1_gpiob_init(void);
-void i2c1_single_byte_read(uint8_t saddr, uint8_t maddr, uint8_t *data);
-void i2c1_multiple_bytes_read(uint8_t saddr, uint8_t maddr, uint32_t n, uint8_t *data);
-void i2c1_multiple_bytes_write(uint8_t saddr, uint8_t maddr, uint32_t n, uint8_t *data);
+i2c_status_t i2c1_single_byte_read(uint8_t saddr, uint8_t maddr, uint8_t *data);
+i2c_status_t i2c1_multiple_bytes_read(uint8_t saddr, uint8_t maddr, uint32_t n, uint8_t *data);
+i2c_status_t i2c1_multiple_bytes_write(uint8_t saddr, uint8_t maddr, uint32_t n, uint8_t *data);
+i2c_status_t i2c1_mem_read(uint8_t saddr, uint16_t maddr, uint8_t maddr_len, uint32_t n, uint8_t *data);
+i2c_status_t i2c1_mem_write(uint8_t saddr, uint16_t maddr, uint8_t maddr_len, uint32_t n, const uint8_t *data);
+i2c_status_t i2c1_is_device_ready(uint8_t saddr);
+i2c_status_t i2c1_chained_read(const i2c1_read_req_t *reqs, uint32_t count);
+void i2c1_bus_recover(void);
+void i2c1_get_error_stats(i2c_error_stats_t *stats);
+void i2c1_clear_error_stats(void);
+void i2c1_wait_hook(void);
 
 #endif /* INCLUDE_I2C_H_ */
@@ -0,0 +1,31 @@
+#ifndef INCLUDE_I2C_SCHED_H_
+#define INCLUDE_I2C_SCHED_H_
+
+#include <stdint.h>
+#include "i2c.h"
+
+// Macro to define the maximum number of periodic jobs held in the scheduler table
+#define I2C_SCHED_MAX_JOBS 8
+
+// Macro to define the value returned when a job cannot be added to the table
+#define I2C_SCHED_INVALID_JOB (-1)
+
+// Per-job timing statistics
+typedef struct {
+    uint32_t runs;            // Number of completed reads
+    uint32_t misses;          // Number of periods skipped because the job was serviced too late
+    uint32_t errors;          // Number of batches containing this job that failed on the bus
+    uint32_t last_latency_ms; // Delay between the due time and the service time of the last read
+    uint32_t max_latency_ms;  // Worst delay between the due time and the service time
+} i2c_sched_stats_t;
+
+/* Function Declarations */
+void i2c_sched_init(void);
+int8_t i2c_sched_add(uint8_t saddr, uint8_t maddr, uint8_t len, uint32_t period_ms, uint8_t *dest, uint32_t now_ms);
+uint32_t i2c_sched_run(uint32_t now_ms);
+const uint8_t *i2c_sched_get_data(int8_t job_id);
+uint8_t i2c_sched_copy_data(int8_t job_id, uint8_t *out);
+void i2c_sched_get_stats(int8_t job_id, i2c_sched_stats_t *stats);
+void i2c_sched_clear_stats(void);
+
+#endif /* INCLUDE_I2C_SCHED_H_ */
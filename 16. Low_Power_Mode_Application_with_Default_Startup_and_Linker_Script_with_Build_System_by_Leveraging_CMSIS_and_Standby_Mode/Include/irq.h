@@ -0,0 +1,75 @@
+#ifndef INCLUDE_IRQ_H_
+#define INCLUDE_IRQ_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the priority grouping (PRIGROUP = 4: 3 bits preempt priority, 1 bit sub-priority)
+#define IRQ_PRIORITY_GROUP 4U
+
+// Macro to define the number of preempt priority bits resulting from IRQ_PRIORITY_GROUP
+#define IRQ_PREEMPT_BITS (7U - IRQ_PRIORITY_GROUP)
+
+// Preempt priority levels of the interrupt plan (0 is the most urgent)
+#define IRQ_PRIO_REALTIME 0U // Streaming refills with a hard deadline (waveform DMA)
+#define IRQ_PRIO_DMA      1U // DMA completion handling
+#define IRQ_PRIO_TICK     2U // SysTick time base and kernel timeouts
+#define IRQ_PRIO_COMM     3U // UART events
+#define IRQ_PRIO_TIMER    4U // RTC wake-up and alarms
+#define IRQ_PRIO_USER     5U // Buttons and other user input
+#define IRQ_PRIO_DEFERRED 6U // Deferred work from interrupt handlers
+#define IRQ_PRIO_LOWEST   7U // Context switching (PendSV)
+
+// Macro to define the most urgent level from which blocking calls (printf, delays) are still allowed
+#define IRQ_PRIO_MAY_BLOCK IRQ_PRIO_USER
+
+// Compile-time checks of the plan: every level fits the preempt bits and latency-critical handlers
+// preempt everything that may block
+_Static_assert(IRQ_PRIO_LOWEST < (1U << IRQ_PREEMPT_BITS), "IRQ priority levels exceed the preempt priority bits");
+_Static_assert(IRQ_PRIO_REALTIME < IRQ_PRIO_MAY_BLOCK, "Realtime interrupts must not be allowed to block");
+_Static_assert(IRQ_PRIO_DMA < IRQ_PRIO_MAY_BLOCK, "DMA interrupts must not be allowed to block");
+_Static_assert(IRQ_PRIO_COMM < IRQ_PRIO_MAY_BLOCK, "UART interrupts must not be allowed to block");
+
+// Macro to check at compile time that a handler running at the given level may call blocking functions
+#define IRQ_STATIC_ASSERT_MAY_BLOCK(level) \
+    _Static_assert((level) >= IRQ_PRIO_MAY_BLOCK, "Blocking call from a latency-critical interrupt level")
+
+// Macro to convert a preempt level into a BASEPRI value (the priority field uses the upper bits of the byte)
+#define IRQ_BASEPRI(level) ((uint32_t)(level) << (8U - IRQ_PREEMPT_BITS))
+
+// Macro to check at run time that the current context may block
+#define IRQ_ASSERT_MAY_BLOCK() \
+    do { if (__get_IPSR() != 0U) { irq_check_may_block(); } } while (0)
+
+// Priority of one interrupt in the plan
+typedef struct {
+    IRQn_Type irq;   // Interrupt or system exception number
+    uint8_t preempt; // Preempt priority level (IRQ_PRIO_...)
+    uint8_t sub;     // Sub-priority, orders pending interrupts of the same level
+} irq_plan_entry_t;
+
+/* Function Declarations */
+void irq_init(void);
+void irq_apply(IRQn_Type irq);
+void irq_enable(IRQn_Type irq);
+void irq_check_may_block(void);
+uint32_t irq_get_violations(void);
+
+// Mask all interrupts of the given level and below, more urgent ones still run; returns the previous mask
+// (level 0 cannot be masked by BASEPRI, use __disable_irq() for that)
+static inline uint32_t irq_lock(uint32_t level) {
+    uint32_t basepri = __get_BASEPRI();
+
+    // BASEPRI_MAX only ever raises the masking, so nested sections cannot lower it
+    __set_BASEPRI_MAX(IRQ_BASEPRI(level));
+    __ISB();
+
+    return basepri;
+}
+
+// Restore the mask returned by irq_lock()
+static inline void irq_unlock(uint32_t basepri) {
+    __set_BASEPRI(basepri);
+}
+
+#endif /* INCLUDE_IRQ_H_ */
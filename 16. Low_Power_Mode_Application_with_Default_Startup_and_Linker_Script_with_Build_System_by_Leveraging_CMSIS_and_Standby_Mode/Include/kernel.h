@@ -0,0 +1,92 @@
+#ifndef INCLUDE_KERNEL_H_
+#define INCLUDE_KERNEL_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "profile.h"
+
+// Macro to define the maximum number of tasks, including the internal idle task
+#define KERNEL_MAX_TASKS 8U
+
+// Macro to define the smallest accepted task stack in 32-bit words (context frame with FPU registers plus margin)
+#define KERNEL_MIN_STACK_WORDS 128U
+
+// Macro to define the lowest priority a task can use (0 is the highest, 255 belongs to the idle task)
+#define KERNEL_LOWEST_PRIO 254U
+
+// Macro to return immediately from a blocking call
+#define KERNEL_NO_WAIT 0U
+
+// Macro to block without a timeout
+#define KERNEL_WAIT_FOREVER UINT32_MAX
+
+// Macro to define a statically allocated, 8-byte aligned task stack
+#define KERNEL_STACK_DEFINE(name, words) static uint32_t name[(words)] __attribute__((aligned(8)))
+
+// Result of the kernel calls
+typedef enum {
+    KERNEL_OK = 0,       // The operation completed successfully
+    KERNEL_ERR_TIMEOUT,  // The timeout elapsed before the object became available
+    KERNEL_ERR_PARAM,    // Invalid argument (e.g. a too small stack or an unknown task)
+    KERNEL_ERR_NO_TASK,  // All task slots are in use
+    KERNEL_ERR_FULL,     // The semaphore already holds its maximum count
+    KERNEL_ERR_CONTEXT,  // The call may only block from a task, outside of irq_lock() sections
+    KERNEL_ERR_NOT_OWNER // The mutex is not held by the calling task
+} kernel_status_t;
+
+// Macro to select the tickless idle task, which sleeps in Stop mode until the next task delay expires
+// (requires stop_mode_init() before kernel_start())
+// #define KERNEL_TICKLESS
+
+// Task handle (index into the task table)
+typedef uint8_t kernel_task_t;
+
+// Task entry function, a task that returns is deleted
+typedef void (*kernel_task_fn_t)(void *arg);
+
+// Counting semaphore
+typedef struct {
+    volatile uint32_t count; // Number of available units
+    uint32_t max;            // Upper bound of count
+} kernel_sem_t;
+
+// Mutex with priority inheritance
+typedef struct {
+    volatile uint8_t owner; // Owning task or KERNEL_TASK_NONE
+    uint8_t depth;          // Recursive lock count of the owner
+} kernel_mutex_t;
+
+// Message queue of fixed-size items
+typedef struct {
+    uint8_t *buffer;    // Storage for capacity * item_size bytes
+    uint32_t item_size; // Size of one message in bytes
+    uint32_t capacity;  // Number of messages the buffer holds
+    uint32_t head;      // Index of the next message to receive
+    uint32_t tail;      // Index of the next free slot
+    kernel_sem_t items; // Number of queued messages
+    kernel_sem_t slots; // Number of free slots
+} kernel_msgq_t;
+
+// Macro to mark a mutex without owner
+#define KERNEL_TASK_NONE 0xFFU
+
+/* Function Declarations */
+kernel_status_t kernel_task_create(kernel_task_fn_t fn, void *arg, uint8_t prio, uint32_t *stack, uint32_t words, kernel_task_t *task);
+void kernel_start(void) __attribute__((noreturn));
+uint8_t kernel_is_running(void);
+kernel_task_t kernel_task_self(void);
+uint32_t kernel_stack_free(kernel_task_t task);
+void kernel_yield(void);
+void kernel_delay(uint32_t msec);
+void kernel_sem_init(kernel_sem_t *sem, uint32_t initial, uint32_t max);
+kernel_status_t kernel_sem_take(kernel_sem_t *sem, uint32_t timeout_ms);
+kernel_status_t kernel_sem_give(kernel_sem_t *sem);
+void kernel_mutex_init(kernel_mutex_t *mutex);
+kernel_status_t kernel_mutex_lock(kernel_mutex_t *mutex, uint32_t timeout_ms);
+kernel_status_t kernel_mutex_unlock(kernel_mutex_t *mutex);
+void kernel_msgq_init(kernel_msgq_t *queue, void *buffer, uint32_t item_size, uint32_t capacity);
+kernel_status_t kernel_msgq_send(kernel_msgq_t *queue, const void *msg, uint32_t timeout_ms);
+kernel_status_t kernel_msgq_receive(kernel_msgq_t *queue, void *msg, uint32_t timeout_ms);
+const profile_probe_t *kernel_get_switch_probe(void);
+
+#endif /* INCLUDE_KERNEL_H_ */
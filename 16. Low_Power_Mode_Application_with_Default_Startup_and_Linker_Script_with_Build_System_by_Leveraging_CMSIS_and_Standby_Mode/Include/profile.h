@@ -0,0 +1,68 @@
+#ifndef INCLUDE_PROFILE_H_
+#define INCLUDE_PROFILE_H_
+
+#include <stdint.h>
+
+/* Cycle-accurate profiling on top of the DWT cycle counter (DWT->CYCCNT)
+ * When PROFILE_HOST is defined the module builds without the device headers and reads a stub
+ * counter instead (profile_host_cycles), so the statistics code can be compiled and exercised
+ * on a PC.
+ */
+#ifdef PROFILE_HOST
+extern volatile uint32_t profile_host_cycles;
+#else
+#include "stm32f4xx.h"
+#endif
+
+// Accumulated statistics of one measured code section
+typedef struct {
+    const char *name; // Name printed in reports
+    uint32_t start;   // Cycle counter value captured by profile_start()
+    uint32_t count;   // Number of recorded samples
+    uint32_t min;     // Shortest sample in cycles
+    uint32_t max;     // Longest sample in cycles
+    uint64_t total;   // Sum of all samples in cycles
+} profile_probe_t;
+
+// Macro to statically initialize a probe
+#define PROFILE_PROBE_INIT(probe_name) { .name = (probe_name), .start = 0U, .count = 0U, .min = UINT32_MAX, .max = 0U, .total = 0U }
+
+// Macro to measure the rest of the enclosing block with a probe
+// The measurement is stopped automatically when the block is left (GCC cleanup attribute).
+#define PROFILE_SCOPE(probe) \
+    profile_probe_t *profile_scope_##probe __attribute__((cleanup(profile_scope_exit), unused)) = profile_start_scope(&(probe))
+
+/* Function Declarations */
+void profile_init(void);
+void profile_probe_reset(profile_probe_t *probe, const char *name);
+void profile_record(profile_probe_t *probe, uint32_t cycles);
+uint32_t profile_mean(const profile_probe_t *probe);
+uint32_t profile_get_overhead(void);
+void profile_scope_exit(profile_probe_t **probe);
+
+// Read the free-running cycle counter
+static inline uint32_t profile_cycles(void) {
+#ifdef PROFILE_HOST
+    return profile_host_cycles;
+#else
+    return DWT->CYCCNT;
+#endif
+}
+
+// Begin a measurement
+static inline void profile_start(profile_probe_t *probe) {
+    probe->start = profile_cycles();
+}
+
+// End a measurement and add it to the statistics of the probe
+static inline void profile_stop(profile_probe_t *probe) {
+    profile_record(probe, profile_cycles() - probe->start);
+}
+
+// Begin a measurement and return the probe for PROFILE_SCOPE()
+static inline profile_probe_t *profile_start_scope(profile_probe_t *probe) {
+    profile_start(probe);
+    return probe;
+}
+
+#endif /* INCLUDE_PROFILE_H_ */
@@ -0,0 +1,97 @@
+#ifndef INCLUDE_PT_H_
+#define INCLUDE_PT_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "systick.h"
+#include "ramfunc.h"
+
+/* Stackless coroutines (protothreads)
+ * A thread is a function that is called again and again and continues after the point where it last
+ * returned: PT_BEGIN() is a switch on the line number stored in the pt_t, every wait point stores its
+ * own line and returns. No stack is kept between the calls, so local variables do not survive a wait
+ * point (use static variables or the argument) and switch statements cannot span one. Two wait points
+ * must not share a source line.
+ */
+
+// Thread states returned by a thread function
+#define PT_WAITING 0U // Blocked on a condition or an event
+#define PT_YIELDED 1U // Gave up the CPU voluntarily
+#define PT_EXITED  2U // Left with PT_EXIT()
+#define PT_ENDED   3U // Reached PT_END()
+
+// Driver completion events for PT_AWAIT_EVENT() (one bit each, bits 8-31 are free for the application)
+#define PT_EVENT_UART2_RX (1UL << 0) // DMA1 Stream 5 received a UART2 message
+#define PT_EVENT_UART2_TX (1UL << 1) // DMA1 Stream 6 finished a UART2 transmission
+#define PT_EVENT_UART2_TC (1UL << 2) // UART2 shifted out the last frame
+
+// Continuation of one thread
+typedef struct {
+    uint16_t lc;    // Line to continue at (0: start of the thread)
+    uint32_t wait;  // Events the thread waits for, 0 when it only polls
+    uint32_t until; // Deadline of PT_DELAY() in milliseconds
+} pt_t;
+
+// Thread function, returns one of the PT_ states
+typedef uint8_t (*pt_thread_t)(pt_t *pt, void *arg);
+
+// Entry of the run queue
+typedef struct {
+    pt_t pt;        // Continuation of the thread
+    pt_thread_t fn; // Thread function
+    void *arg;      // Argument passed on every call
+} pt_task_t;
+
+// Events being delivered by the current pt_sched_run() pass
+extern uint32_t pt_sched_events;
+
+// Macro to (re)start a thread at its beginning
+#define PT_INIT(pt) do { (pt)->lc = 0U; (pt)->wait = 0U; } while (0)
+
+// Macro to open the body of a thread function
+#define PT_BEGIN(pt) { uint8_t pt_yielded = 1U; (void)pt_yielded; switch ((pt)->lc) { case 0U:
+
+// Macro to close the body of a thread function, the thread restarts when it is called again
+#define PT_END(pt) } PT_INIT(pt); return PT_ENDED; }
+
+// Macro to store the current line as the continuation point
+#define PT_SET(pt) (pt)->lc = __LINE__; __attribute__((fallthrough)); case __LINE__:
+
+// Macro to wait until a condition is true, it is evaluated on every call
+#define PT_WAIT_UNTIL(pt, cond) do { PT_SET(pt) if (!(cond)) { return PT_WAITING; } } while (0)
+
+// Macro to wait while a condition is true
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL((pt), !(cond))
+
+// Macro to wait for one of the events, the thread is not called until pt_sched_signal() posts one
+// (start the operation before awaiting it, an event posted before the wait point is lost). The thread
+// always returns at the wait point, events of the current pass were posted before it was reached.
+#define PT_AWAIT_EVENT(pt, events) \
+    do { \
+        (pt)->wait = (events); (pt)->lc = __LINE__; return PT_WAITING; case __LINE__: \
+        if ((pt_sched_events & (pt)->wait) == 0U) { return PT_WAITING; } \
+        (pt)->wait = 0U; \
+    } while (0)
+
+// Macro to wait for the given number of milliseconds
+#define PT_DELAY(pt, msec) \
+    do { (pt)->until = millis() + (msec); PT_WAIT_UNTIL((pt), (int32_t)(millis() - (pt)->until) >= 0); } while (0)
+
+// Macro to give the other threads a turn
+#define PT_YIELD(pt) do { pt_yielded = 0U; PT_SET(pt) if (pt_yielded == 0U) { return PT_YIELDED; } } while (0)
+
+// Macro to run a child thread to completion, the parent waits for the same events as the child
+#define PT_SPAWN(pt, child, thread) \
+    do { PT_INIT(child); PT_SET(pt) if ((thread) < PT_EXITED) { (pt)->wait = (child)->wait; return PT_WAITING; } (pt)->wait = 0U; } while (0)
+
+// Macro to leave the thread, it restarts when it is called again
+#define PT_EXIT(pt) do { PT_INIT(pt); return PT_EXITED; } while (0)
+
+/* Function Declarations */
+void pt_sched_init(void);
+uint8_t pt_sched_add(pt_task_t *task, pt_thread_t fn, void *arg);
+RAMFUNC void pt_sched_signal(uint32_t events);
+uint32_t pt_sched_run(void);
+uint32_t pt_sched_count(void);
+
+#endif /* INCLUDE_PT_H_ */
@@ -0,0 +1,45 @@
+#ifndef INCLUDE_PWM_H_
+#define INCLUDE_PWM_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the TIM1-TIM4 kernel clock, APB1/APB2 run undivided from the 16 MHz HSI (default)
+#define PWM_TIM_CLK 16000000U
+
+// Macro to define the duty cycle scale (10000 = 100.00 %)
+#define PWM_DUTY_FULL 10000U
+
+// Macro to define the largest auto-reload value used for PWM (16-bit counters)
+#define PWM_ARR_MAX 0xFFFFU
+
+// Counter alignment
+typedef enum {
+    PWM_ALIGN_EDGE,  // Up-counting, one update per period
+    PWM_ALIGN_CENTER // Up/down counting (center-aligned mode 1), symmetric pulses
+} pwm_align_t;
+
+// Prescaler and auto-reload pair computed for a requested frequency
+typedef struct {
+    uint16_t psc;   // Value for TIMx_PSC
+    uint16_t arr;   // Value for TIMx_ARR
+    uint32_t steps; // Number of distinct duty cycle steps (resolution)
+} pwm_timing_t;
+
+/* Function Declarations */
+uint8_t pwm_compute_timing(uint32_t clk_hz, uint32_t freq_hz, pwm_align_t align, pwm_timing_t *timing);
+uint32_t pwm_timing_frequency(uint32_t clk_hz, const pwm_timing_t *timing, pwm_align_t align);
+uint32_t pwm_duty_to_compare(uint32_t arr, pwm_align_t align, uint16_t duty);
+uint8_t pwm_deadtime_to_dtg(uint32_t clk_hz, uint32_t deadtime_ns);
+void pwm_pin_init(GPIO_TypeDef *port, uint8_t pin, uint8_t af);
+uint8_t pwm_init(TIM_TypeDef *tim, uint32_t freq_hz, pwm_align_t align);
+void pwm_channel_enable(TIM_TypeDef *tim, uint8_t channel);
+void pwm_channel_disable(TIM_TypeDef *tim, uint8_t channel);
+void pwm_set_duty(TIM_TypeDef *tim, uint8_t channel, uint16_t duty);
+void pwm_tim1_complementary_enable(uint8_t channel, uint32_t deadtime_ns);
+// The table holds 'channels' compare values per period, so len should be a multiple of 'channels'
+uint8_t pwm_dma_burst_start(TIM_TypeDef *tim, uint8_t first_channel, uint8_t channels,
+                            const uint16_t *table, uint16_t len);
+void pwm_dma_burst_stop(TIM_TypeDef *tim);
+
+#endif /* INCLUDE_PWM_H_ */
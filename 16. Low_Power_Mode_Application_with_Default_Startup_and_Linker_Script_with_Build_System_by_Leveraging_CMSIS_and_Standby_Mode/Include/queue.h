@@ -0,0 +1,245 @@
+#ifndef INCLUDE_QUEUE_H_
+#define INCLUDE_QUEUE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/* Lock-free queues for handing data from interrupt handlers to thread context
+ *
+ * spsc_queue_t: one producer (e.g. one ISR) and one consumer (e.g. the main loop). Head and tail are
+ * free-running counters, each written by one side only, so no read-modify-write is needed; a barrier
+ * orders the element copy against the index update.
+ *
+ * mpsc_queue_t: several producers (ISRs of different priorities and thread code) and one consumer.
+ * Every slot carries a sequence number. A producer claims a slot by advancing the head with an
+ * exclusive load/store (LDREX/STREX) and publishes it by writing the slot sequence, so a producer
+ * interrupted between claim and publish only delays the consumer at that slot, it never corrupts it.
+ *
+ * Both come as fixed-size element queues (any element type) and as byte queues, the capacity is a
+ * power of two checked at compile time. On a host the atomics fall back to the GCC __atomic builtins.
+ */
+
+#if defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_7M__)
+#include "stm32f4xx.h"
+
+// Macro to order memory accesses between the two sides of a queue
+#define QUEUE_BARRIER() __DMB()
+
+// Compare-and-swap on a 32-bit word, returns 1 when the word held 'expected' and now holds 'desired'
+static inline uint8_t queue_cas(volatile uint32_t *word, uint32_t expected, uint32_t desired) {
+    if (__LDREXW(word) != expected) {
+        __CLREX();
+        return 0;
+    }
+
+    return (__STREXW(desired, word) == 0U);
+}
+#else
+// Macro to order memory accesses between the two sides of a queue
+#define QUEUE_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+// Compare-and-swap on a 32-bit word, returns 1 when the word held 'expected' and now holds 'desired'
+static inline uint8_t queue_cas(volatile uint32_t *word, uint32_t expected, uint32_t desired) {
+    return __atomic_compare_exchange_n(word, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#endif
+
+// Macro to check at compile time that a capacity is a power of two of at least 2
+#define QUEUE_CHECK_CAPACITY(capacity) \
+    _Static_assert((((capacity) & ((capacity) - 1U)) == 0U) && ((capacity) >= 2U), \
+                   "queue capacity must be a power of two")
+
+// Single-producer/single-consumer queue
+typedef struct {
+    volatile uint32_t head; // Elements pushed so far, written by the producer only
+    volatile uint32_t tail; // Elements popped so far, written by the consumer only
+    uint32_t mask;          // Capacity - 1
+    uint32_t elem_size;     // Size of one element in bytes
+    uint8_t *storage;       // capacity * elem_size bytes
+} spsc_queue_t;
+
+// Multi-producer/single-consumer queue
+typedef struct {
+    volatile uint32_t head; // Slots claimed by producers
+    volatile uint32_t tail; // Slots released by the consumer
+    uint32_t mask;          // Capacity - 1
+    uint32_t elem_size;     // Size of one element in bytes
+    uint8_t *storage;       // capacity * elem_size bytes
+    volatile uint32_t *seq; // Per-slot sequence number, equal to the position when the slot is free
+                            // and to position + 1 when it holds a published element
+} mpsc_queue_t;
+
+// Macro to define a static SPSC queue holding 'capacity' elements of 'type'
+#define SPSC_QUEUE_DEFINE(name, type, capacity) \
+    QUEUE_CHECK_CAPACITY(capacity); \
+    static type name##_storage[(capacity)]; \
+    static spsc_queue_t name = { 0U, 0U, (capacity) - 1U, sizeof(type), (uint8_t *)name##_storage }
+
+// Macro to define a static MPSC queue holding 'capacity' elements of 'type' (call mpsc_queue_init() before use)
+#define MPSC_QUEUE_DEFINE(name, type, capacity) \
+    QUEUE_CHECK_CAPACITY(capacity); \
+    static type name##_storage[(capacity)]; \
+    static volatile uint32_t name##_seq[(capacity)]; \
+    static mpsc_queue_t name = { 0U, 0U, (capacity) - 1U, sizeof(type), (uint8_t *)name##_storage, name##_seq }
+
+/* SPSC queue */
+
+static inline uint32_t spsc_queue_count(const spsc_queue_t *q) {
+    return q->head - q->tail;
+}
+
+static inline uint8_t spsc_queue_push(spsc_queue_t *q, const void *elem) {
+    uint32_t head = q->head;
+
+    if ((head - q->tail) > q->mask) {
+        return 0;
+    }
+
+    memcpy(&q->storage[(head & q->mask) * q->elem_size], elem, q->elem_size);
+
+    // The element must be complete before the consumer can see the new head
+    QUEUE_BARRIER();
+    q->head = head + 1U;
+
+    return 1;
+}
+
+/* In-place push for producers that must not call memcpy() (interrupt handlers running from SRAM)
+ * spsc_queue_claim() returns the free slot at the head, or NULL when the queue is full; the producer fills
+ * it with a copy of fixed size and makes it visible with spsc_queue_publish(). Both are forced inline, so
+ * they are emitted into the caller's section at -O0 as well.
+ */
+
+static inline __attribute__((always_inline)) void *spsc_queue_claim(spsc_queue_t *q) {
+    uint32_t head = q->head;
+
+    if ((head - q->tail) > q->mask) {
+        return NULL;
+    }
+
+    return &q->storage[(head & q->mask) * q->elem_size];
+}
+
+static inline __attribute__((always_inline)) void spsc_queue_publish(spsc_queue_t *q) {
+    // The element must be complete before the consumer can see the new head
+    QUEUE_BARRIER();
+    q->head = q->head + 1U;
+}
+
+static inline uint8_t spsc_queue_pop(spsc_queue_t *q, void *elem) {
+    uint32_t tail = q->tail;
+
+    if (q->head == tail) {
+        return 0;
+    }
+
+    // Read the element only after seeing the head that published it
+    QUEUE_BARRIER();
+    memcpy(elem, &q->storage[(tail & q->mask) * q->elem_size], q->elem_size);
+
+    // The copy must be finished before the producer may reuse the slot
+    QUEUE_BARRIER();
+    q->tail = tail + 1U;
+
+    return 1;
+}
+
+static inline uint8_t spsc_queue_push_byte(spsc_queue_t *q, uint8_t byte) {
+    uint32_t head = q->head;
+
+    if ((head - q->tail) > q->mask) {
+        return 0;
+    }
+
+    q->storage[head & q->mask] = byte;
+
+    QUEUE_BARRIER();
+    q->head = head + 1U;
+
+    return 1;
+}
+
+static inline uint8_t spsc_queue_pop_byte(spsc_queue_t *q, uint8_t *byte) {
+    uint32_t tail = q->tail;
+
+    if (q->head == tail) {
+        return 0;
+    }
+
+    QUEUE_BARRIER();
+    *byte = q->storage[tail & q->mask];
+
+    QUEUE_BARRIER();
+    q->tail = tail + 1U;
+
+    return 1;
+}
+
+/* MPSC queue */
+
+static inline void mpsc_queue_init(mpsc_queue_t *q) {
+    // Every slot starts free for the position it will be used at first
+    for (uint32_t i = 0; i <= q->mask; i++) {
+        q->seq[i] = i;
+    }
+
+    q->head = 0;
+    q->tail = 0;
+}
+
+static inline uint8_t mpsc_queue_push(mpsc_queue_t *q, const void *elem) {
+    uint32_t pos;
+
+    // Claim the slot at the head, retrying when another producer claimed it first
+    while (1) {
+        pos = q->head;
+        int32_t diff = (int32_t)(q->seq[pos & q->mask] - pos);
+
+        // The slot still holds an element of the previous round: the queue is full
+        if (diff < 0) {
+            return 0;
+        }
+
+        // A zero difference means the slot is free for this position, otherwise the head is stale
+        if ((diff == 0) && queue_cas(&q->head, pos, pos + 1U)) {
+            break;
+        }
+    }
+
+    memcpy(&q->storage[(pos & q->mask) * q->elem_size], elem, q->elem_size);
+
+    // Publish the element once it is complete
+    QUEUE_BARRIER();
+    q->seq[pos & q->mask] = pos + 1U;
+
+    return 1;
+}
+
+static inline uint8_t mpsc_queue_pop(mpsc_queue_t *q, void *elem) {
+    uint32_t pos = q->tail;
+
+    // Empty, or the producer of the next slot has not published it yet
+    if (q->seq[pos & q->mask] != (pos + 1U)) {
+        return 0;
+    }
+
+    QUEUE_BARRIER();
+    memcpy(elem, &q->storage[(pos & q->mask) * q->elem_size], q->elem_size);
+
+    // Hand the slot back to producers for the next round
+    QUEUE_BARRIER();
+    q->seq[pos & q->mask] = pos + q->mask + 1U;
+    q->tail = pos + 1U;
+
+    return 1;
+}
+
+static inline uint8_t mpsc_queue_push_byte(mpsc_queue_t *q, uint8_t byte) {
+    return mpsc_queue_push(q, &byte);
+}
+
+static inline uint8_t mpsc_queue_pop_byte(mpsc_queue_t *q, uint8_t *byte) {
+    return mpsc_queue_pop(q, byte);
+}
+
+#endif /* INCLUDE_QUEUE_H_ */
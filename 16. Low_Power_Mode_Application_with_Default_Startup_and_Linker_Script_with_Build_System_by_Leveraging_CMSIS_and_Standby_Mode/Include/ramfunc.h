@@ -0,0 +1,26 @@
+#ifndef INCLUDE_RAMFUNC_H_
+#define INCLUDE_RAMFUNC_H_
+
+/* Code executed from SRAM
+ * Functions marked RAMFUNC are linked into the .ramfunc section, which runs from SRAM and is copied from FLASH
+ * by Reset_Handler through the copy table of the linker script, together with the vector table (VTOR points to
+ * the SRAM copy once main() runs).
+ *
+ * Flash needs wait states above 30 MHz (3 at 100 MHz) and the ART accelerator only hides them on cache hits and
+ * sequential fetches, while SRAM answers in one cycle. At the default 16 MHz flash runs without wait states and
+ * SRAM code, fetched over the system bus it shares with data accesses, is not faster. Mark only short, hot code
+ * (interrupt handlers with a deadline, inner loops) and check the gain with bench_run_drivers().
+ *
+ * SRAM is out of the +-16 MB range of a BL instruction from flash, so RAMFUNC functions are called through a
+ * register (long_call). They must not be inlined into flash callers, which would defeat the placement.
+ */
+
+#if defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_7M__)
+// Macro to place a function in SRAM
+#define RAMFUNC __attribute__((section(".ramfunc"), noinline, long_call))
+#else
+// Host builds (tests) have no SRAM section, the functions stay ordinary ones
+#define RAMFUNC
+#endif
+
+#endif /* INCLUDE_RAMFUNC_H_ */
@@ -0,0 +1,40 @@
+#ifndef INCLUDE_RTC_ALARM_H_
+#define INCLUDE_RTC_ALARM_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the number of logical alarms handled by the alarm scheduler
+#define RTC_SCHED_MAX_ALARMS 16U
+
+// Macro to define the handle returned when no logical alarm could be added
+#define RTC_SCHED_INVALID_ALARM (-1)
+
+// Macro to make a hardware alarm match on every day of the month
+#define RTC_ALARM_ANY_DAY 0U
+
+// Hardware alarms of the RTC
+typedef enum {
+    RTC_ALARM_A,
+    RTC_ALARM_B
+} rtc_alarm_t;
+
+// Function called from the RTC interrupt handlers
+typedef void (*rtc_event_callback_t)(void);
+
+// Function called from rtc_sched_process() when a logical alarm is due
+typedef void (*rtc_sched_callback_t)(void *arg);
+
+/* Function Declarations */
+uint8_t rtc_wakeup_start(uint64_t period_us, rtc_event_callback_t callback);
+void rtc_wakeup_stop(void);
+uint8_t rtc_alarm_set(rtc_alarm_t alarm, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second,
+                      rtc_event_callback_t callback);
+void rtc_alarm_disable(rtc_alarm_t alarm);
+int8_t rtc_sched_add(uint32_t due_epoch, uint32_t period_s, rtc_sched_callback_t callback, void *arg);
+uint8_t rtc_sched_cancel(int8_t id);
+uint32_t rtc_sched_process(void);
+void RTC_WKUP_IRQHandler(void);
+void RTC_Alarm_IRQHandler(void);
+
+#endif /* INCLUDE_RTC_ALARM_H_ */
@@ -0,0 +1,34 @@
+#ifndef INCLUDE_SOFT_TIMER_H_
+#define INCLUDE_SOFT_TIMER_H_
+
+#include <stdint.h>
+
+// Macro to define the number of timers in the static pool (at most 65535)
+#ifndef SOFT_TIMER_POOL_SIZE
+#define SOFT_TIMER_POOL_SIZE 256U
+#endif
+
+// Macro to define the number of wheel slots (must be a power of two)
+#ifndef SOFT_TIMER_WHEEL_SLOTS
+#define SOFT_TIMER_WHEEL_SLOTS 256U
+#endif
+
+// Macro to define the handle returned when no timer could be started
+#define SOFT_TIMER_INVALID 0U
+
+// Handle of a running timer (pool index and generation, so stale handles are detected)
+typedef uint32_t soft_timer_id_t;
+
+// Function called in the context of soft_timer_process() when a timer expires
+typedef void (*soft_timer_callback_t)(void *arg);
+
+/* Function Declarations */
+void soft_timer_init(void);
+soft_timer_id_t soft_timer_start(uint32_t delay_ms, uint32_t period_ms, soft_timer_callback_t callback, void *arg);
+uint8_t soft_timer_cancel(soft_timer_id_t id);
+uint8_t soft_timer_is_active(soft_timer_id_t id);
+uint32_t soft_timer_process(void);
+uint32_t soft_timer_get_active_count(void);
+uint32_t soft_timer_ms_until_next(uint32_t limit_ms);
+
+#endif /* INCLUDE_SOFT_TIMER_H_ */
@@ -4,9 +4,19 @@
 #include <stdint.h>
 #include "stm32f4xx.h"
 
+// Macro to enter Stop mode with the main regulator on when the CPU enters deepsleep
+#define PWR_MODE_STOP_MAIN_REGULATOR (0U)
+
+// Macro to enter Stop mode with the low-power regulator when the CPU enters deepsleep
+#define PWR_MODE_STOP_LOW_POWER_REGULATOR (PWR_CR_LPDS)
+
+// Macro to additionally power down the flash in Stop mode (slower wake-up)
+#define PWR_MODE_FLASH_POWER_DOWN (PWR_CR_FPDS)
+
 /* Function Declarations */
 void pa0_wakeup_pin_init(void);
 void standby_pa0_wakeup_pin_setup(void);
 uint32_t get_pa0_wakeup_pin_state(void);
+void set_low_power_mode(uint32_t pwr_mode);
 
 #endif /* INCLUDE_STANDBY_MODE_H_ */
@@ -0,0 +1,30 @@
+#ifndef INCLUDE_STOP_MODE_H_
+#define INCLUDE_STOP_MODE_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the shortest idle period worth entering Stop mode for (in ms), shorter ones use Sleep
+#define STOP_MODE_MIN_SLEEP_MS 3U
+
+// Macro to define the longest single Stop mode period (in ms), the caller simply idles again afterwards;
+// up to 32 s the wakeup timer runs from RTCCLK/16 (~0.5 ms steps), longer periods would switch it to
+// whole seconds of ck_spre and the tick compensation would drift by up to a second
+#define STOP_MODE_MAX_SLEEP_MS 32000U
+
+// Statistics of the idle manager
+typedef struct {
+    uint32_t stop_entries;  // Number of Stop mode periods
+    uint32_t sleep_entries; // Number of plain Sleep mode periods
+    uint32_t early_wakeups; // Stop periods ended by another interrupt before the RTC wakeup
+    uint64_t stop_ms;       // Total time spent in Stop mode
+} stop_mode_stats_t;
+
+/* Function Declarations */
+void stop_mode_init(uint32_t pwr_mode);
+void stop_mode_idle(void);
+void stop_mode_idle_limit(uint32_t limit_ms);
+void stop_mode_sleep(uint32_t sleep_ms);
+void stop_mode_get_stats(stop_mode_stats_t *stats);
+
+#endif /* INCLUDE_STOP_MODE_H_ */
@@ -4,7 +4,21 @@
 #include <stdint.h>
 #include "stm32f4xx.h"
 
+// Macro to define the frequency of the SysTick interrupt (1 tick = 1 ms)
+#define SYSTICK_TICK_HZ 1000U
+
+// Point in time (in milliseconds since systick_init()) at which a timeout expires
+typedef uint64_t deadline_t;
+
 /* Function Declarations */
+void systick_init(void);
+uint64_t systick_get_ticks(void);
+uint32_t millis(void);
+uint64_t micros(void);
+deadline_t deadline_after_ms(uint32_t msec);
+uint8_t deadline_expired(deadline_t deadline);
 void systick_msec_delay(uint32_t delay);
+void systick_compensate(uint32_t msec);
+void systick_tick_hook(void);
 
 #endif /* INCLUDE_SYSTICK_H_ */
@@ -0,0 +1,52 @@
+#ifndef INCLUDE_TIMESTAMP_H_
+#define INCLUDE_TIMESTAMP_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the TIM2/TIM5 kernel clock, APB1 runs undivided from the 16 MHz HSI (default)
+#define TIMESTAMP_TIM_CLK 16000000U
+
+// Counter rate of the timestamp timers
+typedef enum {
+    TIMESTAMP_RATE_1MHZ,   // 1 us per count, wraps after ~71.6 minutes
+    TIMESTAMP_RATE_SYSCLK  // 62.5 ns per count, wraps after ~268 seconds
+} timestamp_rate_t;
+
+// Edge(s) on which an input capture channel records a timestamp
+typedef enum {
+    CAPTURE_EDGE_RISING,
+    CAPTURE_EDGE_FALLING,
+    CAPTURE_EDGE_BOTH
+} capture_edge_t;
+
+// Ring of edge timestamps filled by a circular DMA stream
+typedef struct {
+    DMA_Stream_TypeDef *stream; // DMA stream writing into the buffer
+    uint32_t *buffer;           // Timestamp storage, written by DMA only
+    uint16_t size;              // Number of entries in the buffer
+    uint16_t tail;              // Next entry to be read
+    uint32_t last;              // Last timestamp read, used to compute intervals
+    uint8_t has_last;           // 1 once last holds a valid timestamp
+} capture_ring_t;
+
+/* Function Declarations */
+void tim2_timestamp_init(timestamp_rate_t rate);
+void tim5_timestamp_init(timestamp_rate_t rate);
+void tim2_ch3_capture_init(capture_ring_t *ring, uint32_t *buffer, uint16_t size, capture_edge_t edge);
+void tim5_ch2_capture_init(capture_ring_t *ring, uint32_t *buffer, uint16_t size, capture_edge_t edge);
+uint16_t capture_available(const capture_ring_t *ring);
+uint8_t capture_read(capture_ring_t *ring, uint32_t *timestamp);
+uint8_t capture_read_interval(capture_ring_t *ring, uint32_t *interval);
+
+// Read the free-running TIM2 counter
+static inline uint32_t tim2_timestamp(void) {
+    return TIM2->CNT;
+}
+
+// Read the free-running TIM5 counter
+static inline uint32_t tim5_timestamp(void) {
+    return TIM5->CNT;
+}
+
+#endif /* INCLUDE_TIMESTAMP_H_ */
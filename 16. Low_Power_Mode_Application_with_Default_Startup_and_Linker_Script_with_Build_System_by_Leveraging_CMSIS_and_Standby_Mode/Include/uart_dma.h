@@ -3,13 +3,31 @@
 
 #include <stdint.h>
 #include "stm32f4xx.h"
+#include "ramfunc.h"
 
 #define UART2_DATA_BUFF_SIZE 6
 
+// Events reported by the UART2 DMA driver
+typedef enum {
+    UART_DMA_EVENT_TX_CMPLT, // DMA1 Stream 6 finished a transmission
+    UART_DMA_EVENT_UART_TC   // UART2 shifted out the last frame
+} uart_dma_event_t;
+
+// Message received by DMA1 Stream 5, copied out of the circular buffer
+typedef struct {
+    char data[UART2_DATA_BUFF_SIZE];
+} uart2_rx_msg_t;
+
 /* Function Declarations */
 void uart2_rx_tx_init(void);
 void dma1_init(void);
 void dma1_stream5_uart2_rx_config(void);
 void dma1_stream6_uart2_tx_config(uint32_t msg_to_snd, uint32_t msg_len);
+uint8_t uart2_dma_receive(uart2_rx_msg_t *msg);
+uint8_t uart2_dma_get_event(uart_dma_event_t *event);
+
+// Reception work of DMA1_Stream5_IRQHandler linked into SRAM and into flash, to compare both placements
+RAMFUNC void uart2_dma_rx_complete_sram(void);
+void uart2_dma_rx_complete_flash(void);
 
 #endif /* INCLUDE_UART_DMA_H_ */
@@ -0,0 +1,42 @@
+#ifndef INCLUDE_WAVEFORM_H_
+#define INCLUDE_WAVEFORM_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+// Macro to define the number of GPIO words in each of the two DMA buffers
+#define WAVEFORM_CHUNK_SLOTS 192U
+
+// Macro to define the number of lanes (pins of one port) that can be driven in parallel
+#define WAVEFORM_MAX_LANES 16U
+
+// Macro to compute the buffer size in words needed to pre-encode a frame of 'bytes' bytes per lane
+#define WAVEFORM_FRAME_WORDS(bytes, slots_per_bit) \
+    (((((bytes) * 8U * (slots_per_bit)) + WAVEFORM_CHUNK_SLOTS - 1U) / WAVEFORM_CHUNK_SLOTS) * WAVEFORM_CHUNK_SLOTS)
+
+// Shape of one encoded bit: every bit is split into slots of equal length,
+// all lanes go high in slot 0 and return low after zero_high_slots or one_high_slots
+typedef struct {
+    GPIO_TypeDef *port;      // Port of the driven pins
+    uint16_t pin_mask;       // Pins driven by the engine, one lane per pin
+    uint16_t slot_ticks;     // Slot length in TIM1 clocks (16 MHz)
+    uint8_t slots_per_bit;   // Slots per bit, must divide WAVEFORM_CHUNK_SLOTS
+    uint8_t zero_high_slots; // High time of a 0 bit in slots
+    uint8_t one_high_slots;  // High time of a 1 bit in slots
+    uint16_t reset_slots;    // Low time appended after a frame (latch / frame gap)
+} waveform_timing_t;
+
+// Macro to define WS2812 timing: 437.5 ns slots, T0H 437.5 ns, T1H 875 ns, bit 1.31 us, 300 us latch
+#define WAVEFORM_WS2812(port_, mask_) { (port_), (mask_), 7U, 3U, 1U, 2U, 686U }
+
+// Macro to define DShot150 timing: 812.5 ns slots, T0H 2.44 us, T1H 4.88 us, bit 6.5 us
+#define WAVEFORM_DSHOT150(port_, mask_) { (port_), (mask_), 13U, 8U, 3U, 6U, 16U }
+
+/* Function Declarations */
+uint8_t waveform_init(const waveform_timing_t *timing);
+void waveform_set_frame_buffer(uint32_t *buffer, uint32_t words);
+uint32_t waveform_refill_cycles(void);
+uint8_t waveform_start(const uint8_t *const lanes[WAVEFORM_MAX_LANES], uint32_t bytes);
+uint8_t waveform_busy(void);
+
+#endif /* INCLUDE_WAVEFORM_H_ */
@@ -0,0 +1,134 @@
+#include <stddef.h>
+#include "backup.h"
+
+/* State persistence in the RTC backup registers
+ * The 20 backup registers (80 bytes) keep their content in Stop and Standby mode and across resets
+ * as long as VDD or VBAT is present. BKP0R belongs to rtc_init(), the rest holds one record:
+ *   BKP1R        magic (bits 31:16), version (bits 15:8), payload length in bytes (bits 7:0)
+ *   BKP2R        CRC-32 of BKP1R and the payload words, computed by the CRC unit
+ *   BKP3R-BKP19R payload, packed little-endian and padded with zeros
+ * The RTC clock must be enabled (rtc_init()) before the registers are accessed.
+ */
+
+// Macro to enable the clock for PWR (power controller) (bit 28 in RCC_APB1ENR)
+#define PWREN (1U << 28)
+
+// Macro to enable write access to RTC and RTC backup registers (bit 8 in PWR_CR)
+#define CR_DBP (1U << 8)
+
+// Macro to enable the clock for the CRC calculation unit (bit 12 in RCC_AHB1ENR)
+#define CRCEN (1U << 12)
+
+// Macro to reset the CRC calculation unit (bit 0 in CRC_CR)
+#define CRC_CR_RESET_BIT (1U << 0)
+
+// Macro to define the marker identifying a record in BKP1R
+#define BACKUP_MAGIC 0xB5A7U
+
+// Macro to define the index of the header register
+#define BACKUP_HEADER_REG 1U
+
+// Macro to define the index of the CRC register
+#define BACKUP_CRC_REG 2U
+
+// Macro to define the index of the first payload register
+#define BACKUP_PAYLOAD_REG 3U
+
+// Macro to define the number of payload registers
+#define BACKUP_PAYLOAD_WORDS (BACKUP_MAX_PAYLOAD / 4U)
+
+static volatile uint32_t *backup_reg(uint32_t index);
+static uint32_t backup_crc(uint32_t header, const uint32_t *words, uint32_t count);
+
+void backup_init(void) {
+	// Enable the clock access to PWR
+    RCC->APB1ENR |= PWREN;
+
+    // Enable write access to RTC and RTC backup registers
+    PWR->CR |= CR_DBP;
+
+    // Enable the clock access to the CRC unit
+    RCC->AHB1ENR |= CRCEN;
+}
+
+uint8_t backup_save(uint8_t version, const void *data, uint8_t len) {
+    uint32_t words[BACKUP_PAYLOAD_WORDS] = {0};
+
+    if ((data == NULL) || (len > BACKUP_MAX_PAYLOAD)) {
+        return 0;
+    }
+
+    // Pack the payload into words
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (uint32_t i = 0; i < len; i++) {
+        words[i >> 2] |= ((uint32_t)bytes[i] << ((i & 3U) * 8U));
+    }
+
+    uint32_t count = (len + 3U) / 4U;
+    uint32_t header = ((uint32_t)BACKUP_MAGIC << 16) | ((uint32_t)version << 8) | len;
+
+    // Invalidate the record first, so a reset in the middle of the update cannot leave a mixed record
+    *backup_reg(BACKUP_HEADER_REG) = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        *backup_reg(BACKUP_PAYLOAD_REG + i) = words[i];
+    }
+
+    *backup_reg(BACKUP_CRC_REG) = backup_crc(header, words, count);
+    *backup_reg(BACKUP_HEADER_REG) = header;
+
+    return 1;
+}
+
+uint8_t backup_restore(uint8_t version, void *data, uint8_t len) {
+    uint32_t words[BACKUP_PAYLOAD_WORDS];
+    uint32_t header = *backup_reg(BACKUP_HEADER_REG);
+
+    // Only accept a record with the expected layout version and size
+    if ((data == NULL) || ((header >> 16) != BACKUP_MAGIC) || (((header >> 8) & 0xFFU) != version) ||
+        ((header & 0xFFU) != len) || (len > BACKUP_MAX_PAYLOAD)) {
+        return 0;
+    }
+
+    uint32_t count = (len + 3U) / 4U;
+
+    for (uint32_t i = 0; i < count; i++) {
+        words[i] = *backup_reg(BACKUP_PAYLOAD_REG + i);
+    }
+
+    if (backup_crc(header, words, count) != *backup_reg(BACKUP_CRC_REG)) {
+        return 0;
+    }
+
+    // Unpack the payload into the caller's structure
+    uint8_t *bytes = (uint8_t *)data;
+
+    for (uint32_t i = 0; i < len; i++) {
+        bytes[i] = (uint8_t)(words[i >> 2] >> ((i & 3U) * 8U));
+    }
+
+    return 1;
+}
+
+void backup_invalidate(void) {
+    *backup_reg(BACKUP_HEADER_REG) = 0;
+}
+
+static volatile uint32_t *backup_reg(uint32_t index) {
+    // BKP0R to BKP19R are consecutive registers
+    return &RTC->BKP0R + index;
+}
+
+static uint32_t backup_crc(uint32_t header, const uint32_t *words, uint32_t count) {
+    // Start a new CRC-32 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF)
+    CRC->CR = CRC_CR_RESET_BIT;
+
+    CRC->DR = header;
+
+    for (uint32_t i = 0; i < count; i++) {
+        CRC->DR = words[i];
+    }
+
+    return CRC->DR;
+}
@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include "bench.h"
+
+/* Micro-benchmark runner
+ * Each benchmark runs once to warm up, then <iterations> times under a profiling probe.
+ * The results are printed as a table through printf(), which is retargeted to UART2 on
+ * the target and goes to stdout on the host.
+ */
+
+static void bench_print_header(void);
+
+void bench_run(const bench_t *benches, uint32_t count) {
+    profile_probe_t probe;
+
+    // Make sure the cycle counter is running and the probe overhead is known
+    profile_init();
+
+    bench_print_header();
+
+    for (uint32_t i = 0; i < count; i++) {
+        const bench_t *bench = &benches[i];
+
+        profile_probe_reset(&probe, bench->name);
+
+        if (bench->setup != NULL) {
+            bench->setup();
+        }
+
+        // Warm-up run, so that the first sample does not include one-time effects
+        bench->run();
+
+        for (uint32_t j = 0; j < bench->iterations; j++) {
+            profile_start(&probe);
+            bench->run();
+            profile_stop(&probe);
+        }
+
+        bench_print_probe(&probe);
+    }
+}
+
+void bench_print_probe(const profile_probe_t *probe) {
+    printf("%-32s %8" PRIu32 " %10" PRIu32 " %10" PRIu32 " %10" PRIu32 "\n\r",
+           probe->name, probe->count,
+           (probe->count != 0U) ? probe->min : 0U, probe->max, profile_mean(probe));
+}
+
+static void bench_print_header(void) {
+    printf("\n\rBenchmark (probe overhead %" PRIu32 " cycles removed)\n\r", profile_get_overhead());
+    printf("%-32s %8s %10s %10s %10s\n\r", "Name", "Iter", "Min", "Max", "Mean");
+}
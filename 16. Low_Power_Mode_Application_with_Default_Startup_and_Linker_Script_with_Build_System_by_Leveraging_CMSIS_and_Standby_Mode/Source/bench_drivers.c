@@ -0,0 +1,213 @@
+#include <stddef.h>
+#include "bench.h"
+#include "bench_drivers.h"
+#include "uart.h"
+#include "adc.h"
+#include "gpio.h"
+#include "gpio_pin.h"
+#include "systick.h"
+#include "uart_dma.h"
+#include "ramfunc.h"
+
+/* Registered on-target micro-benchmarks of the drivers
+ * Call bench_run_drivers() after uart2_init() to print the cycle counts over UART2.
+ * The "bit-wise" entries replay the former single-bit read-modify-write pin setup for comparison with
+ * the folded gpio_port_apply() configuration.
+ *
+ * The "SRAM" and "flash" entries run the same code linked into .ramfunc and into flash. They run once with
+ * the current flash latency and once with the 3 wait states needed at 100 MHz, since flash needs no wait
+ * states at the default 16 MHz.
+ */
+
+// Macro to define the number of taps of the benchmarked FIR filter
+#define BENCH_FIR_TAPS 16U
+
+// Macro to define the number of output samples computed per FIR run
+#define BENCH_FIR_SAMPLES 32U
+
+// Macro to define the flash latency used to emulate a 100 MHz system clock
+#define BENCH_FLASH_LATENCY_100MHZ FLASH_ACR_LATENCY_3WS
+
+// PA2 as UART2_TX (AF7), the pin setup of uart2_init()
+#define BENCH_UART2_PINS(X) \
+    X(2, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 7)
+
+static const gpio_port_cfg_t bench_uart2_pin_cfg = GPIO_PORT_CFG(A, BENCH_UART2_PINS);
+
+// Q15 low-pass coefficients (Hamming-windowed sinc, cut-off fs/8, DC gain 1.0), kept in SRAM so both
+// placements read the same data
+static int16_t bench_fir_coeffs[BENCH_FIR_TAPS] = {
+    -42, -177, -406, -352, 669, 2961, 5846, 7885, 7885, 5846, 2961, 669, -352, -406, -177, -42
+};
+
+static int16_t bench_fir_input[BENCH_FIR_SAMPLES + BENCH_FIR_TAPS - 1U];
+static int16_t bench_fir_output[BENCH_FIR_SAMPLES];
+
+static void bench_adc1_setup(void);
+static void bench_adc1_read(void);
+static void bench_uart_formatted_string(void);
+static void bench_led_setup(void);
+static void bench_led_toggle(void);
+static void bench_led_toggle_bitwise(void);
+static void bench_led_init_bitwise(void);
+static void bench_uart2_pins(void);
+static void bench_uart2_pins_bitwise(void);
+static void bench_millis(void);
+static void bench_micros(void);
+static void bench_fir_setup(void);
+static void bench_fir_flash(void);
+static RAMFUNC void bench_fir_sram(void);
+static inline void bench_fir_q15(void) __attribute__((always_inline));
+static void bench_uart2_rx_flash(void);
+static void bench_uart2_rx_sram(void);
+
+// Number of cycles that Reset_Handler spent before main() was called
+extern uint32_t g_reset_handler_cycles;
+
+static const bench_t driver_benches[] = {
+    { "uart_write_formatted_string", NULL, bench_uart_formatted_string, 16 },
+    { "adc1_read (continuous)", bench_adc1_setup, bench_adc1_read, 64 },
+    { "led_toggle", bench_led_setup, bench_led_toggle, 256 },
+    { "led_toggle (bit-wise ODR ^=)", bench_led_setup, bench_led_toggle_bitwise, 256 },
+    { "led_init", NULL, led_init, 64 },
+    { "led_init (bit-wise)", NULL, bench_led_init_bitwise, 64 },
+    { "uart2 pins", NULL, bench_uart2_pins, 64 },
+    { "uart2 pins (bit-wise)", NULL, bench_uart2_pins_bitwise, 64 },
+    { "millis", systick_init, bench_millis, 256 },
+    { "micros", systick_init, bench_micros, 256 },
+};
+
+static const bench_t ramfunc_benches[] = {
+    { "DMA1_Stream5 rx work (flash)", NULL, bench_uart2_rx_flash, 64 },
+    { "DMA1_Stream5 rx work (SRAM)", NULL, bench_uart2_rx_sram, 64 },
+    { "FIR q15 16x32 (flash)", bench_fir_setup, bench_fir_flash, 32 },
+    { "FIR q15 16x32 (SRAM)", bench_fir_setup, bench_fir_sram, 32 },
+};
+
+void bench_run_drivers(void) {
+    bench_run(driver_benches, sizeof(driver_benches) / sizeof(driver_benches[0]));
+
+    // Reset_Handler runs once per boot, so it is reported as a single sample
+    profile_probe_t reset_probe = PROFILE_PROBE_INIT("Reset_Handler (boot to main)");
+    reset_probe.count = 1;
+    reset_probe.min = g_reset_handler_cycles;
+    reset_probe.max = g_reset_handler_cycles;
+    reset_probe.total = g_reset_handler_cycles;
+    bench_print_probe(&reset_probe);
+
+    // Flash versus SRAM execution, first with the current flash latency, then with the latency of 100 MHz
+    uint32_t flash_acr = FLASH->ACR;
+
+    // The rx benchmarks push into the SPSC queue of DMA1_Stream5_IRQHandler, so the handler must not run
+    // meanwhile: a second producer would corrupt the queue
+    uint32_t rx_irq_enabled = NVIC_GetEnableIRQ(DMA1_Stream5_IRQn);
+    NVIC_DisableIRQ(DMA1_Stream5_IRQn);
+
+    bench_run(ramfunc_benches, sizeof(ramfunc_benches) / sizeof(ramfunc_benches[0]));
+
+    FLASH->ACR = (flash_acr & ~FLASH_ACR_LATENCY_Msk) | BENCH_FLASH_LATENCY_100MHZ;
+    bench_run(ramfunc_benches, sizeof(ramfunc_benches) / sizeof(ramfunc_benches[0]));
+
+    FLASH->ACR = flash_acr;
+
+    // A transfer completed meanwhile stays pending and is handled now
+    if (rx_irq_enabled) {
+        NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+    }
+}
+
+static void bench_adc1_setup(void) {
+    pa1_adc1_init();
+    start_adc1_conversion();
+}
+
+static void bench_adc1_read(void) {
+    (void)adc1_read();
+}
+
+static void bench_uart_formatted_string(void) {
+    uart_write_formatted_string("%5d\r", 12345);
+}
+
+static void bench_led_setup(void) {
+    led_init();
+}
+
+static void bench_led_toggle(void) {
+    led_toggle();
+}
+
+static void bench_led_toggle_bitwise(void) {
+    GPIOA->ODR ^= (1U << 5);
+}
+
+static void bench_led_init_bitwise(void) {
+    RCC->AHB1ENR |= (1U << 0);
+    GPIOA->MODER |= (1U << 10);
+    GPIOA->MODER &= ~(1U << 11);
+}
+
+static void bench_uart2_pins(void) {
+    gpio_port_apply(&bench_uart2_pin_cfg);
+}
+
+static void bench_uart2_pins_bitwise(void) {
+    RCC->AHB1ENR |= (1U << 0);
+    GPIOA->MODER &= ~(1U << 4);
+    GPIOA->MODER |= (1U << 5);
+    GPIOA->AFR[0] |= (1U << 8);
+    GPIOA->AFR[0] |= (1U << 9);
+    GPIOA->AFR[0] |= (1U << 10);
+    GPIOA->AFR[0] &= ~(1U << 11);
+}
+
+static void bench_millis(void) {
+    (void)millis();
+}
+
+static void bench_micros(void) {
+    (void)micros();
+}
+
+static void bench_fir_setup(void) {
+    // Fill the delay line with a full-scale square wave
+    for (uint32_t i = 0; i < (BENCH_FIR_SAMPLES + BENCH_FIR_TAPS - 1U); i++) {
+        bench_fir_input[i] = (i & 4U) ? 16384 : -16384;
+    }
+}
+
+static void bench_fir_flash(void) {
+    bench_fir_q15();
+}
+
+static RAMFUNC void bench_fir_sram(void) {
+    bench_fir_q15();
+}
+
+static inline void bench_fir_q15(void) {
+    for (uint32_t n = 0; n < BENCH_FIR_SAMPLES; n++) {
+        int32_t acc = 0;
+
+        for (uint32_t k = 0; k < BENCH_FIR_TAPS; k++) {
+            acc += (int32_t)bench_fir_coeffs[k] * bench_fir_input[n + k];
+        }
+
+        bench_fir_output[n] = (int16_t)(acc >> 15);
+    }
+}
+
+static void bench_uart2_rx_flash(void) {
+    uart2_rx_msg_t msg;
+
+    // Drain the message again, so that every run pushes into a queue with free space
+    uart2_dma_rx_complete_flash();
+    (void)uart2_dma_receive(&msg);
+}
+
+static void bench_uart2_rx_sram(void) {
+    uart2_rx_msg_t msg;
+
+    // Drain the message again, so that every run pushes into a queue with free space
+    uart2_dma_rx_complete_sram();
+    (void)uart2_dma_receive(&msg);
+}
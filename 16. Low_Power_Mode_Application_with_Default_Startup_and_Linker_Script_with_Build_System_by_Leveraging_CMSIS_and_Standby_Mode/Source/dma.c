@@ -1,4 +1,6 @@
 #include "dma.h"
+#include "irq.h"
+#include "bitband.h"
 
 // Macro to enable clock for DMA2 controller (bit 22 in RCC_AHB1ENR register)
 #define DMA2EN (1U << 22)
@@ -26,45 +28,45 @@ void dma2_stream0_mem2mem_config(void) {
     RCC->AHB1ENR |= DMA2EN;
 
     // Disable DMA2 stream before making any configurations
-    DMA2_Stream0->CR &= ~DMA_SCR_EN;
+    BITBAND_PERIPH_CLEAR(DMA2_Stream0->CR, DMA_SCR_EN);
 
     // Wait until DMA2 Stream0 is disabled before configuring it
-    while ((DMA2_Stream0->CR & (DMA_SCR_EN))) {
+    while (BITBAND_PERIPH_TEST(DMA2_Stream0->CR, DMA_SCR_EN)) {
     }
 
     // Set memory data size to half-word (16-bit)
-    DMA2_Stream0->CR |= (1U << 13);
-    DMA2_Stream0->CR &= ~(1U << 14);
+    BITBAND_PERIPH_SET(DMA2_Stream0->CR, (1U << 13));
+    BITBAND_PERIPH_CLEAR(DMA2_Stream0->CR, (1U << 14));
 
     // Set peripheral data size to half-word (16-bit)
-    DMA2_Stream0->CR |= (1U << 11);
-    DMA2_Stream0->CR &= ~(1U << 12);
+    BITBAND_PERIPH_SET(DMA2_Stream0->CR, (1U << 11));
+    BITBAND_PERIPH_CLEAR(DMA2_Stream0->CR, (1U << 12));
 
     // Enable memory address increment mode
-    DMA2_Stream0->CR |= DMA_SCR_MINC;
+    BITBAND_PERIPH_SET(DMA2_Stream0->CR, DMA_SCR_MINC);
 
     // Enable peripheral address increment mode
-    DMA2_Stream0->CR |= DMA_SCR_PINC;
+    BITBAND_PERIPH_SET(DMA2_Stream0->CR, DMA_SCR_PINC);
 
     // Set data transfer direction as memory-to-memory
-    DMA2_Stream0->CR &= ~(1U << 6);
-    DMA2_Stream0->CR |= (1U << 7);
+    BITBAND_PERIPH_CLEAR(DMA2_Stream0->CR, (1U << 6));
+    BITBAND_PERIPH_SET(DMA2_Stream0->CR, (1U << 7));
 
     // Enable the transfer complete interrupt
-    DMA2_Stream0->CR |= DMA_SCR_TCIE;
+    BITBAND_PERIPH_SET(DMA2_Stream0->CR, DMA_SCR_TCIE);
 
     // Enable the transfer error interrupt
-    DMA2_Stream0->CR |= DMA_SCR_TEIE;
+    BITBAND_PERIPH_SET(DMA2_Stream0->CR, DMA_SCR_TEIE);
 
     // Disable direct mode to use FIFO mode
-    DMA2_Stream0->FCR |= DMA_SFCR_DMDIS;
+    BITBAND_PERIPH_SET(DMA2_Stream0->FCR, DMA_SFCR_DMDIS);
 
     // Set DMA2 FIFO threshold to full FIFO, i.e. transfer only when FIFO is completely full
-    DMA2_Stream0->FCR |= (1U << 0);
-    DMA2_Stream0->FCR |= (1U << 1);
+    BITBAND_PERIPH_SET(DMA2_Stream0->FCR, (1U << 0));
+    BITBAND_PERIPH_SET(DMA2_Stream0->FCR, (1U << 1));
 
     // Enable the DMA2_Stream0 interrupt line in the NVIC to handle DMA2-related interrupts
-    NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+    irq_enable(DMA2_Stream0_IRQn);
 }
 
 void dma2_transfer_start(uint32_t src_buff, uint32_t dest_buff, uint32_t len) {
@@ -78,5 +80,5 @@ void dma2_transfer_start(uint32_t src_buff, uint32_t dest_buff, uint32_t len) {
     DMA2_Stream0->NDTR = len;
 
     // Enable DMA2 stream to start the data transfer from the source to the destination
-    DMA2_Stream0->CR |= DMA_SCR_EN;
+    BITBAND_PERIPH_SET(DMA2_Stream0->CR, DMA_SCR_EN);
 }
@@ -0,0 +1,116 @@
+#include "eeprom.h"
+
+/* 24Cxx I2C EEPROM driver
+ * Writes are split on page boundaries, because a page write that crosses the end of a page
+ * wraps around to the start of the same page and overwrites data. After each page the end of
+ * the internal write cycle is detected with acknowledge polling: the device does not acknowledge
+ * its address while it is programming, so it is addressed repeatedly until it answers again.
+ * This replaces the worst-case 5 ms delay after every write with the actual write cycle time.
+ */
+
+// Macro to define the maximum number of address polls while waiting for a write cycle
+// One poll (start, address byte, stop) takes about 100 us at 100 kHz, so 100 polls cover 10 ms,
+// twice the 5 ms maximum write cycle time of the 24Cxx family.
+#define EEPROM_MAX_READY_POLLS 100U
+
+// Macro to define the size of a memory block addressed with a single address byte
+// Devices up to 24C16 take the upper address bits from the block select bits of the device address.
+#define EEPROM_BLOCK_SIZE_1_BYTE_ADDR 256U
+
+// Macro to define the size of a memory block addressed with two address bytes
+#define EEPROM_BLOCK_SIZE_2_BYTE_ADDR 65536U
+
+static uint32_t eeprom_block_size(const eeprom_t *dev);
+static uint8_t eeprom_device_address(const eeprom_t *dev, uint32_t addr);
+static uint8_t is_eeprom_range_valid(const eeprom_t *dev, uint32_t addr, uint32_t n);
+
+i2c_status_t eeprom_read(const eeprom_t *dev, uint32_t addr, uint32_t n, uint8_t *data) {
+    i2c_status_t status;
+    uint32_t block_size = eeprom_block_size(dev);
+
+    if (!is_eeprom_range_valid(dev, addr, n)) {
+        return I2C_ERR_INVALID;
+    }
+
+    while (n > 0U) {
+        // A sequential read may run up to the end of the current address block
+        uint32_t chunk = block_size - (addr % block_size);
+
+        if (chunk > n) {
+            chunk = n;
+        }
+
+        status = i2c1_mem_read(eeprom_device_address(dev, addr), (uint16_t)addr, dev->addr_bytes, chunk, data);
+        if (status != I2C_OK) {
+            return status;
+        }
+
+        addr += chunk;
+        data += chunk;
+        n -= chunk;
+    }
+
+    return I2C_OK;
+}
+
+i2c_status_t eeprom_write(const eeprom_t *dev, uint32_t addr, uint32_t n, const uint8_t *data) {
+    i2c_status_t status;
+
+    if (!is_eeprom_range_valid(dev, addr, n)) {
+        return I2C_ERR_INVALID;
+    }
+
+    while (n > 0U) {
+        // Never let a page write run past the end of the page it starts in
+        uint32_t chunk = dev->page_size - (addr % dev->page_size);
+
+        if (chunk > n) {
+            chunk = n;
+        }
+
+        status = i2c1_mem_write(eeprom_device_address(dev, addr), (uint16_t)addr, dev->addr_bytes, chunk, data);
+        if (status != I2C_OK) {
+            return status;
+        }
+
+        // Wait for the internal write cycle of this page to finish
+        status = eeprom_wait_ready(dev);
+        if (status != I2C_OK) {
+            return status;
+        }
+
+        addr += chunk;
+        data += chunk;
+        n -= chunk;
+    }
+
+    return I2C_OK;
+}
+
+i2c_status_t eeprom_wait_ready(const eeprom_t *dev) {
+    i2c_status_t status = I2C_ERR_AF;
+
+    // Address the device until it acknowledges, i.e. until its write cycle is complete
+    for (uint32_t polls = 0; polls < EEPROM_MAX_READY_POLLS; polls++) {
+        status = i2c1_is_device_ready(dev->saddr);
+
+        if (status != I2C_ERR_AF) {
+            break;
+        }
+    }
+
+    return (status == I2C_ERR_AF) ? I2C_ERR_TIMEOUT : status;
+}
+
+static uint32_t eeprom_block_size(const eeprom_t *dev) {
+    return (dev->addr_bytes > 1U) ? EEPROM_BLOCK_SIZE_2_BYTE_ADDR : EEPROM_BLOCK_SIZE_1_BYTE_ADDR;
+}
+
+static uint8_t eeprom_device_address(const eeprom_t *dev, uint32_t addr) {
+    // Place the address bits above the memory address bytes into the block select bits (A2..A0)
+    return (uint8_t)(dev->saddr | ((addr / eeprom_block_size(dev)) & 0x07U));
+}
+
+static uint8_t is_eeprom_range_valid(const eeprom_t *dev, uint32_t addr, uint32_t n) {
+    return ((dev->page_size != 0U) && (addr <= dev->capacity) && (n <= (dev->capacity - addr)));
+}
@@ -1,64 +1,58 @@
 #include "gpio.h"
-
-// Bit mask for enabling GPIOA (bit 0) clock
-#define GPIOAEN (1U << 0)
-
-// Bit mask of bit-set operation for setting the pin to high
-#define LED_BS5 (1U << 5)  // Bit-set for Pin 5
-
-// Bit mask of bit-reset operation for resetting the pin to low
-#define LED_BR5 (1U << 21) // Bit-reset for Pin 5
+#include "gpio_pin.h"
+#include "bitband.h"
 
 // Bit mask for GPIOA Pin 5
-#define PIN5 (1U << 5)
+#define PIN5 GPIO_PIN_MASK(5)
 
 // Alias for the pin representing the LED connected to GPIO PA5
 #define LED_PIN PIN5
 
-// Bit mask for enabling GPIOC (bit 2) clock
-#define GPIOCEN (1U << 2)
-
 // Bit mask for GPIOC Pin 13
-#define BTN_PIN (1U << 13)
+#define BTN_PIN GPIO_PIN_MASK(13)
 
-void led_init(void) {
-	// Enable the clock access to GPIOA
-    RCC->AHB1ENR |= GPIOAEN;
+// PA5 drives the user LED
+#define LED_PINS(X) \
+    X(5, GPIO_MODE_OUTPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 0)
 
-    // Configure GPIOA Pin 5 as a general-purpose output pin (MODER5[1:0] = 01)
-    GPIOA->MODER |= (1U << 10);  // Set bit 10 to 1
-    GPIOA->MODER &= ~(1U << 11); // Set bit 11 to 0
+// PC13 reads the user button (external pull-up on the board)
+#define BUTTON_PINS(X) \
+    X(13, GPIO_MODE_INPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 0)
+
+static const gpio_port_cfg_t led_pins = GPIO_PORT_CFG(A, LED_PINS);
+static const gpio_port_cfg_t button_pins = GPIO_PORT_CFG(C, BUTTON_PINS);
+
+void led_init(void) {
+	// Enable the clock access to GPIOA and configure Pin 5 as a general-purpose output pin (MODER5[1:0] = 01)
+    gpio_port_apply(&led_pins);
 }
 
 void led_on(void) {
 	// Set PA5 high
-    GPIOA->BSRR |= LED_BS5;
+    gpio_set(GPIOA, LED_PIN);
 }
 
 void led_off(void) {
 	// Set PA5 low
-    GPIOA->BSRR |= LED_BR5;
+    gpio_clear(GPIOA, LED_PIN);
 }
 
 void led_toggle(void) {
-	// Toggle PA5 (LED_PIN)
-    GPIOA->ODR ^= LED_PIN;
+	// Toggle PA5 (LED_PIN) with a single BSRR write (the bit-band alias of ODR5 would need a separate read
+	// and write, which an interrupt can split)
+    gpio_toggle(GPIOA, LED_PIN);
 }
 
 void button_init(void) {
-	// Enable the clock access to GPIOC
-    RCC->AHB1ENR |= GPIOCEN;
-
-    // Configure GPIOC Pin 13 as an input pin (MODER13[1:0] = 00)
-    GPIOC->MODER &= ~(1U << 26); // Set bit 26 to 0
-    GPIOC->MODER &= ~(1U << 27); // Set bit 27 to 0
+	// Enable the clock access to GPIOC and configure Pin 13 as an input pin (MODER13[1:0] = 00)
+    gpio_port_apply(&button_pins);
 }
 
 bool get_button_state(void) {
 	// Note: The button is internally connected as an active-low input.
 
-    // Check if button is pressed or not
-    if (GPIOC->IDR & (BTN_PIN)) {
+    // Check if button is pressed or not (single load from the bit-band alias of IDR13)
+    if (BITBAND_PERIPH_TEST(GPIOC->IDR, BTN_PIN)) {
         return false; // If the bit is set, the button is not pressed.
     } else {
         return true;  // If the bit is not set, the button is pressed.
@@ -1,42 +1,285 @@
+#include <stddef.h>
 #include "gpio_exti.h"
+#include "systick.h"
+#include "irq.h"
+#include "bitband.h"
+#include "defer.h"
 
-// Macro to enable the clock for GPIOC (bit 2 in RCC_AHB1ENR)
-#define GPIOCEN (1U << 2)
+/* EXTI dispatcher for the GPIO lines EXTI0-EXTI15
+ * exti_register() maps a pin of any port to its line through SYSCFG_EXTICR, selects the edges and stores
+ * the callback. All line handlers, including the shared EXTI9_5 and EXTI15_10 vectors, clear the pending
+ * lines in one write and walk them with CLZ, so the cost per line does not depend on the line number.
+ *
+ * Lines with a debounce time are masked on their first edge instead of waiting in the handler. TIM11
+ * ticks every millisecond while a line is settling; once its debounce time has elapsed the line is unmasked
+ * again and the callback runs if the settled level matches the selected edge. TIM11 shares the interrupt
+ * level of the EXTI handlers, so they never preempt each other.
+ *
+ * The mask and debounce bits of a line are updated through their bit-band aliases, so removing a line from
+ * thread mode is a sequence of single atomic stores and needs no interrupt masking.
+ *
+ * Both the edge and the debounce handlers report their duration to defer_isr_exit(), callbacks included.
+ */
 
-// Macro to enable the clock for SYSCFG (bit 14 in RCC_APB2ENR))
+// Macro to enable the clock for SYSCFG (bit 14 in RCC_APB2ENR)
 #define SYSCFGEN (1U << 14)
 
-void pc13_exti13_init(void) {
-	// Disable global interrupts to ensure that the configuration process is not
-	// interrupted, which is crucial for maintaining consistency and avoiding race
-	// conditions
-	__disable_irq();
+// Macro to enable the clock for TIM11 (bit 18 in RCC_APB2ENR)
+#define TIM11EN (1U << 18)
 
-	// Enable the clock access to GPIOC
-    RCC->AHB1ENR |= GPIOCEN;
+// Macro to enable the counter (bit 0 in TIMx_CR1)
+#define CR1_CEN (1U << 0)
 
-    // Configure GPIOC Pin 13 to operate in input mode (MODER13[1:0] = 00)
-    GPIOC->MODER &= ~(1U << 26);  // Set bit 26 to 0
-    GPIOC->MODER &= ~(1U << 27);  // Set bit 27 to 0
+// Macro to enable the update interrupt (bit 0 in TIMx_DIER)
+#define DIER_UIE (1U << 0)
 
-    // Enable the clock access to SYSCFG (system configuration controller)
+// Macro to check the update interrupt flag (bit 0 in TIMx_SR)
+#define SR_UIF (1U << 0)
+
+// Macro to define the TIM11 prescaler for a 10 kHz counter clock at 16 MHz
+#define TIM11_PSC (1600U - 1U)
+
+// Macro to define the TIM11 auto-reload value for a 1 ms update period
+#define TIM11_ARR (10U - 1U)
+
+// Macro to select the lines served by EXTI9_5_IRQHandler
+#define EXTI_LINES_9_5 (0x1FU << 5)
+
+// Macro to select the lines served by EXTI15_10_IRQHandler
+#define EXTI_LINES_15_10 (0x3FU << 10)
+
+// Configuration of one line
+typedef struct {
+    GPIO_TypeDef *port;       // Port mapped to the line
+    exti_callback_t callback; // Function called on a (debounced) edge
+    uint32_t deadline;        // millis() value at which a settling line is sampled
+    uint16_t debounce_ms;     // Settling time, 0 calls the callback directly from the edge interrupt
+    uint8_t edge;             // Selected exti_edge_t
+} exti_line_t;
+
+static exti_line_t exti_lines[EXTI_GPIO_LINES];
+
+// Lines that are masked until their level has settled (also written through its bit-band alias)
+static volatile uint32_t exti_debouncing;
+
+static void exti_dispatch(uint32_t lines);
+static void exti_handle(uint32_t line);
+static void exti_debounce_timer_init(void);
+static IRQn_Type exti_irq_of(uint8_t pin);
+static uint8_t exti_level_matches(const exti_line_t *line, uint8_t level);
+
+uint8_t exti_register(GPIO_TypeDef *port, uint8_t pin, exti_edge_t edge, uint16_t debounce_ms, exti_callback_t callback) {
+    if ((pin >= EXTI_GPIO_LINES) || (callback == NULL)) {
+        return 0;
+    }
+
+    // Ports are 0x400 apart, starting with GPIOA
+    uint32_t port_index = ((uint32_t)port - GPIOA_BASE) >> 10;
+    uint32_t line = 1U << pin;
+
+    // Keep the interrupts masked if the caller already did
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // Enable the clock access to the port and configure the pin as input
+    RCC->AHB1ENR |= (1U << port_index);
+    port->MODER &= ~(3U << (pin * 2U));
+
+    // Map the line to the port, four lines per SYSCFG_EXTICR register
     RCC->APB2ENR |= SYSCFGEN;
+    SYSCFG->EXTICR[pin >> 2] = (SYSCFG->EXTICR[pin >> 2] & ~(0xFU << ((pin & 3U) * 4U))) | (port_index << ((pin & 3U) * 4U));
+
+    exti_lines[pin].port = port;
+    exti_lines[pin].callback = callback;
+    exti_lines[pin].debounce_ms = debounce_ms;
+    exti_lines[pin].edge = (uint8_t)edge;
+
+    if (debounce_ms != 0U) {
+        systick_init();
+        exti_debounce_timer_init();
+    }
+
+    // Select the edges, drop a stale request and unmask the line
+    if (edge & EXTI_EDGE_RISING) {
+        EXTI->RTSR |= line;
+    } else {
+        EXTI->RTSR &= ~line;
+    }
+
+    if (edge & EXTI_EDGE_FALLING) {
+        EXTI->FTSR |= line;
+    } else {
+        EXTI->FTSR &= ~line;
+    }
+
+    EXTI->PR = line;
+    EXTI->IMR |= line;
+
+    irq_enable(exti_irq_of(pin));
+
+    __set_PRIMASK(primask);
+
+    return 1;
+}
+
+void exti_unregister(uint8_t pin) {
+    if (pin >= EXTI_GPIO_LINES) {
+        return;
+    }
+
+    // Stop the debounce first, TIM11 would otherwise unmask the line again
+    BITBAND_SRAM(&exti_debouncing, pin) = 0U;
+
+    // The shared vectors stay enabled, a masked line cannot raise them
+    BITBAND_PERIPH(&EXTI->IMR, pin) = 0U;
+    BITBAND_PERIPH(&EXTI->RTSR, pin) = 0U;
+    BITBAND_PERIPH(&EXTI->FTSR, pin) = 0U;
+    EXTI->PR = 1U << pin;
+
+    exti_lines[pin].callback = NULL;
+}
+
+void EXTI0_IRQHandler(void) {
+    exti_dispatch(1U << 0);
+}
+
+void EXTI1_IRQHandler(void) {
+    exti_dispatch(1U << 1);
+}
+
+void EXTI2_IRQHandler(void) {
+    exti_dispatch(1U << 2);
+}
+
+void EXTI3_IRQHandler(void) {
+    exti_dispatch(1U << 3);
+}
 
-    // Configure the SYSCFG external interrupt configuration register 4 to map
-    // EXTI line 13 to Port C (GPIOC Pin 13 will be selected the source input for
-    // the EXTI13 external interrupt.)
-    SYSCFG->EXTICR[3] |= (1U << 5);
+void EXTI4_IRQHandler(void) {
+    exti_dispatch(1U << 4);
+}
+
+void EXTI9_5_IRQHandler(void) {
+    exti_dispatch(EXTI_LINES_9_5);
+}
+
+void EXTI15_10_IRQHandler(void) {
+    exti_dispatch(EXTI_LINES_15_10);
+}
+
+void TIM1_TRG_COM_TIM11_IRQHandler(void) {
+    if (!(TIM11->SR & SR_UIF)) {
+        return;
+    }
+
+    uint32_t start = defer_isr_enter();
+
+    TIM11->SR = ~SR_UIF;
+
+    uint32_t now = millis();
+    uint32_t settling = exti_debouncing;
+
+    while (settling != 0U) {
+        uint32_t pin = 31U - __CLZ(settling);
+        uint32_t line = 1U << pin;
+        exti_line_t *entry = &exti_lines[pin];
+
+        settling &= ~line;
+
+        if ((int32_t)(now - entry->deadline) < 0) {
+            continue;
+        }
+
+        // The level is stable, re-arm the line and ignore the bounces recorded while it was masked
+        BITBAND_SRAM(&exti_debouncing, pin) = 0U;
+        EXTI->PR = line;
+        BITBAND_PERIPH(&EXTI->IMR, pin) = 1U;
+
+        uint8_t level = (entry->port->IDR & line) ? 1U : 0U;
+
+        if (exti_level_matches(entry, level)) {
+            entry->callback((uint8_t)pin, level);
+        }
+    }
+
+    // Stop ticking once all lines have settled
+    if (exti_debouncing == 0U) {
+        TIM11->CR1 &= ~CR1_CEN;
+    }
+
+    defer_isr_exit(start);
+}
 
-    // Unmask EXTI13 line to allow the line to generate interrupt requests
-    EXTI->IMR |= (1U << 13);
+static void exti_dispatch(uint32_t lines) {
+    uint32_t start = defer_isr_enter();
 
-    // Enable falling-edge trigger for input line to detect the signal transitions from high to low
-    EXTI->FTSR |= (1U << 13);
-    EXTI->RTSR &= ~(1U << 13);
+    // Clear all pending lines of this vector with one write (rc_w1), then serve them highest line first
+    uint32_t pending = EXTI->PR & lines;
+    EXTI->PR = pending;
+
+    while (pending != 0U) {
+        uint32_t line = 31U - __CLZ(pending);
+        pending &= ~(1U << line);
+
+        exti_handle(line);
+    }
+
+    defer_isr_exit(start);
+}
+
+static void exti_handle(uint32_t pin) {
+    exti_line_t *entry = &exti_lines[pin];
+
+    if (entry->callback == NULL) {
+        return;
+    }
+
+    if (entry->debounce_ms == 0U) {
+        entry->callback((uint8_t)pin, (entry->port->IDR & (1U << pin)) ? 1U : 0U);
+        return;
+    }
+
+    // Mask the line while it bounces and sample it once the debounce time has elapsed
+    BITBAND_PERIPH(&EXTI->IMR, pin) = 0U;
+    entry->deadline = millis() + entry->debounce_ms + 1U;
+    BITBAND_SRAM(&exti_debouncing, pin) = 1U;
+
+    TIM11->CR1 |= CR1_CEN;
+}
+
+static void exti_debounce_timer_init(void) {
+    if (RCC->APB2ENR & TIM11EN) {
+        return;
+    }
+
+    // Enable the clock access to TIM11 and let it tick every millisecond, it only runs while a line settles
+    RCC->APB2ENR |= TIM11EN;
+
+    TIM11->PSC = TIM11_PSC;
+    TIM11->ARR = TIM11_ARR;
+    TIM11->CNT = 0;
+    TIM11->SR = 0;
+    TIM11->DIER |= DIER_UIE;
+
+    irq_enable(TIM1_TRG_COM_TIM11_IRQn);
+}
+
+static IRQn_Type exti_irq_of(uint8_t pin) {
+    if (pin <= 4U) {
+        // EXTI0_IRQn to EXTI4_IRQn are consecutive
+        return (IRQn_Type)(EXTI0_IRQn + pin);
+    } else if (pin <= 9U) {
+        return EXTI9_5_IRQn;
+    } else {
+        return EXTI15_10_IRQn;
+    }
+}
 
-    // Enable the EXTI15_10 interrupt line in the NVIC
-    NVIC_EnableIRQ(EXTI15_10_IRQn);
+static uint8_t exti_level_matches(const exti_line_t *line, uint8_t level) {
+    // A falling edge settles low, a rising edge settles high, both edges report either level
+    if (line->edge == EXTI_EDGE_BOTH) {
+        return 1;
+    }
 
-    // Enable global interrupts to allow the microcontroller to respond to interrupts
-    __enable_irq();
+    return (line->edge == EXTI_EDGE_RISING) ? level : !level;
 }
@@ -1,12 +1,17 @@
+#include <string.h>
 #include "i2c.h"
+#include "systick.h"
+#include "gpio_pin.h"
 
 /* I2C1 Pinout
  * PB8 ----> SCL
  * PB9 ----> SDA
  */
 
-// Macro to enable the clock for GPIOB (bit 1 in RCC_AHB1ENR)
-#define GPIOBEN (1U << 1)
+// PB8 and PB9 are I2C1_SCL and I2C1_SDA (AF4), open-drain with pull-ups
+#define I2C1_PINS(X) \
+    X(8, GPIO_MODE_AF, GPIO_OTYPE_OD, GPIO_SPEED_LOW, GPIO_PULL_UP, 4) \
+    X(9, GPIO_MODE_AF, GPIO_OTYPE_OD, GPIO_SPEED_LOW, GPIO_PULL_UP, 4)
 
 // Macro to enable the clock for I2C1 (bit 21 in RCC_APB1ENR)
 #define I2C1EN (1U << 21)
@@ -50,49 +55,76 @@
 // Macro to represent the BTF (byte transfer finished) bit (bit 2 in I2C_SR1)
 #define SR1_BTF (1U << 2)
 
+// Macro to represent the SWRST (software reset) bit (bit 15 in I2C_CR1)
+#define CR1_SWRST (1U << 15)
+
+// Macro to represent the BERR (bus error) bit (bit 8 in I2C_SR1)
+#define SR1_BERR (1U << 8)
+
+// Macro to represent the ARLO (arbitration lost) bit (bit 9 in I2C_SR1)
+#define SR1_ARLO (1U << 9)
+
+// Macro to represent the AF (acknowledge failure) bit (bit 10 in I2C_SR1)
+#define SR1_AF (1U << 10)
+
+// Macro to represent the OVR (overrun/underrun) bit (bit 11 in I2C_SR1)
+#define SR1_OVR (1U << 11)
+
+// Macro to group all the error flags of I2C_SR1 that abort a transfer
+#define SR1_ERRORS (SR1_BERR | SR1_ARLO | SR1_AF | SR1_OVR)
+
+// Macro to represent the SCL line (GPIOB Pin 8) when it is driven as a GPIO during bus recovery
+#define SCL_PIN (1U << 8)
+
+// Macro to represent the SDA line (GPIOB Pin 9) when it is driven as a GPIO during bus recovery
+#define SDA_PIN (1U << 9)
+
+// Macro to define the longest time in milliseconds that any I2C1 flag is waited for
+#define I2C_TIMEOUT_MS 10U
+
+// Macro to define the number of clock pulses that release a slave stuck in the middle of a byte
+#define I2C_RECOVERY_CLOCK_PULSES 9U
+
+// Macro to define the length of half an SCL period (about 5 us at 100 kHz) as delay loop iterations
+#define I2C_RECOVERY_HALF_PERIOD 8U
+
+static void i2c1_config(void);
+static i2c_status_t i2c1_check_errors(void);
+static i2c_status_t i2c1_wait_sr1_flag(uint32_t flag);
+static i2c_status_t i2c1_wait_bus_idle(void);
+static i2c_status_t i2c1_abort(i2c_status_t status);
+static i2c_status_t i2c1_send_register_address(uint8_t saddr, uint16_t maddr, uint8_t maddr_len);
+static i2c_status_t i2c1_start_read(uint8_t saddr);
+static i2c_status_t i2c1_receive(uint32_t n, uint8_t *data, uint32_t end_condition);
+static void i2c1_recovery_delay(void);
+
+// Error counters of the I2C1 bus
+static i2c_error_stats_t i2c1_error_stats;
+
+static const gpio_port_cfg_t i2c1_pins = GPIO_PORT_CFG(B, I2C1_PINS);
+
 void i2c1_gpiob_init(void) {
-    // Enable the clock access to GPIOB
-    RCC->AHB1ENR |= GPIOBEN;
-
-    // Configure GPIOB Pin 8, 9 to operate in alternate function mode (MODERx[1:0] = 10)
-    // PB8
-    GPIOB->MODER &= ~(1U << 16);  // Set bit 16 to 0
-    GPIOB->MODER |= (1U << 17);   // Set bit 17 to 1
-    // PB9
-    GPIOB->MODER &= ~(1U << 18);  // Set bit 18 to 0
-    GPIOB->MODER |= (1U << 19);   // Set bit 19 to 1
-
-    // Configure the pins as output open-drain, which is required for I2C communication
-    GPIOB->OTYPER |= (1U << 8);
-    GPIOB->OTYPER |= (1U << 9);
-
-    // Enable pull-up resistors for the I2C1 pins (PUPDRx = 01)
-    GPIOB->PUPDR |= (1U << 16);
-    GPIOB->PUPDR &= ~(1U << 17);
-    GPIOB->PUPDR |= (1U << 18);
-    GPIOB->PUPDR &= ~(1U << 19);
-
-    // Set alternate function type to AF4 (0b0100)
-    // PB8 (I2C1_SCL)
-    GPIOB->AFR[1] &= ~(1U << 0);
-    GPIOB->AFR[1] &= ~(1U << 1);
-    GPIOB->AFR[1] |= (1U << 2);
-    GPIOB->AFR[1] &= ~(1U << 3);
-    // PB9 (I2C1_SDA)
-    GPIOB->AFR[1] &= ~(1U << 4);
-    GPIOB->AFR[1] &= ~(1U << 5);
-    GPIOB->AFR[1] |= (1U << 6);
-    GPIOB->AFR[1] &= ~(1U << 7);
+    // Enable the clock access to GPIOB and configure Pin 8, 9 as I2C1 (alternate function mode, AF4),
+    // open-drain as required for I2C communication and with pull-up resistors
+    gpio_port_apply(&i2c1_pins);
+
+    // Start the system tick, which bounds every wait of the driver
+    systick_init();
 
     // Enable the clock access to I2C1
     RCC->APB1ENR |= I2C1EN;
 
     // Enter the software reset mode (i.e., reset the I2C1 peripheral)
-    I2C1->CR1 |= (1U << 15);
+    I2C1->CR1 |= CR1_SWRST;
 
     // Come out of the software reset mode
-    I2C1->CR1 &= ~(1U << 15);
+    I2C1->CR1 &= ~CR1_SWRST;
 
+    // Configure the bus timing and enable I2C1 module
+    i2c1_config();
+}
+
+static void i2c1_config(void) {
     // Set APB1 peripheral clock frequency to 16 MHz
     I2C1->CR2 = (1U << 4);
 
@@ -108,46 +140,169 @@ void i2c1_gpiob_init(void) {
     I2C1->CR1 |= CR1_PE;
 }
 
-void i2c1_single_byte_read(uint8_t saddr, uint8_t maddr, uint8_t *data) {
-	uint16_t temp;
 
-    // Ensure the I2C1 bus is not busy before continuing
-    while (I2C1->SR2 & (SR2_BUSY)) {
+static i2c_status_t i2c1_check_errors(void) {
+    uint32_t sr1 = I2C1->SR1;
+
+    if ((sr1 & SR1_ERRORS) == 0U) {
+        return I2C_OK;
     }
 
-    // Initiate a start condition on the I2C1 bus to begin communication with the slave device
-    I2C1->CR1 |= CR1_START;
+    // Clear the error flags (they are cleared by writing 0 to them)
+    I2C1->SR1 = ~(sr1 & SR1_ERRORS) & 0xFFFFU;
+
+    // Decode the error, the most severe one first
+    if (sr1 & SR1_BERR) {
+        return I2C_ERR_BERR;
+    } else if (sr1 & SR1_ARLO) {
+        return I2C_ERR_ARLO;
+    } else if (sr1 & SR1_AF) {
+        return I2C_ERR_AF;
+    } else {
+        return I2C_ERR_OVR;
+    }
+}
+
+static i2c_status_t i2c1_wait_sr1_flag(uint32_t flag) {
+    deadline_t deadline = deadline_after_ms(I2C_TIMEOUT_MS);
+
+    // Wait until the flag is set, an error is reported or the timeout elapses
+    while (!deadline_expired(deadline)) {
+        i2c_status_t status = i2c1_check_errors();
+
+        if (status != I2C_OK) {
+            return status;
+        }
+
+        if (I2C1->SR1 & flag) {
+            return I2C_OK;
+        }
+
+        // Give the CPU away while the hardware is busy
+        i2c1_wait_hook();
+    }
+
+    return I2C_ERR_TIMEOUT;
+}
+
+static i2c_status_t i2c1_wait_bus_idle(void) {
+    deadline_t deadline = deadline_after_ms(I2C_TIMEOUT_MS);
+
+    // Wait until the bus is released, e.g. by a slave that still holds SDA low
+    while (!deadline_expired(deadline)) {
+        if (!(I2C1->SR2 & (SR2_BUSY))) {
+            return I2C_OK;
+        }
+
+        i2c1_wait_hook();
+    }
+
+    return I2C_ERR_TIMEOUT;
+}
+
+static i2c_status_t i2c1_abort(i2c_status_t status) {
+    switch (status) {
+    case I2C_ERR_TIMEOUT:
+        i2c1_error_stats.timeouts++;
+
+        // The bus or the peripheral is stuck, so clock the slave free and restart I2C1
+        i2c1_bus_recover();
+        break;
+
+    case I2C_ERR_BERR:
+        i2c1_error_stats.bus_errors++;
+
+        // A misplaced start/stop condition leaves the bus in an unknown state
+        i2c1_bus_recover();
+        break;
+
+    case I2C_ERR_ARLO:
+        i2c1_error_stats.arbitration_losses++;
+
+        // I2C1 has already switched to slave mode, the other master owns the bus
+        break;
+
+    case I2C_ERR_AF:
+        i2c1_error_stats.nacks++;
+
+        // Release the bus after the slave refused the address or a data byte
+        I2C1->CR1 |= CR1_STOP;
+        break;
+
+    case I2C_ERR_OVR:
+        i2c1_error_stats.overruns++;
+
+        // Release the bus, the data of this transfer cannot be trusted anymore
+        I2C1->CR1 |= CR1_STOP;
+        break;
+
+    default:
+        break;
+    }
+
+    // Leave the acknowledge bit in its reset state for the next transfer
+    I2C1->CR1 &= ~CR1_ACK;
+
+    return status;
+}
+
+static i2c_status_t i2c1_send_register_address(uint8_t saddr, uint16_t maddr, uint8_t maddr_len) {
+    i2c_status_t status;
+    uint16_t temp;
 
     // Wait until the start condition is generated
-    while (!(I2C1->SR1 & (SR1_SB))) {
+    status = i2c1_wait_sr1_flag(SR1_SB);
+    if (status != I2C_OK) {
+        return status;
     }
 
     // Transmit the slave address with the write bit, which is 0
     I2C1->DR = saddr << 1;
 
     // Wait until the end of slave address transmission from master device
-    while (!(I2C1->SR1 & (SR1_ADDR))) {
+    status = i2c1_wait_sr1_flag(SR1_ADDR);
+    if (status != I2C_OK) {
+        return status;
     }
 
     // Clear the address flag (ADDR bit) by simply reading I2C1 status register 2
     temp = I2C1->SR2;
+    (void)temp;
 
     // Wait until the data register is empty
-    while (!(I2C1->SR1 & (SR1_TXE))) {
+    status = i2c1_wait_sr1_flag(SR1_TXE);
+    if (status != I2C_OK) {
+        return status;
     }
 
-    // Transmit the memory address to read from the slave device
-    I2C1->DR = maddr;
+    // Transmit the high byte first when the slave uses two-byte memory addresses (e.g. 24C32 and larger EEPROMs)
+    if (maddr_len > 1U) {
+        I2C1->DR = (uint8_t)(maddr >> 8);
 
-    // Wait until the data register is empty
-    while (!(I2C1->SR1 & (SR1_TXE))) {
+        // Wait until the data register is empty
+        status = i2c1_wait_sr1_flag(SR1_TXE);
+        if (status != I2C_OK) {
+            return status;
+        }
     }
 
+    // Transmit the memory address to access in the slave device
+    I2C1->DR = (uint8_t)maddr;
+
+    // Wait until the data register is empty
+    return i2c1_wait_sr1_flag(SR1_TXE);
+}
+
+static i2c_status_t i2c1_start_read(uint8_t saddr) {
+    i2c_status_t status;
+
     // Initiate a restart condition on the I2C1 bus
     I2C1->CR1 |= CR1_START;
 
     // Wait until the restart condition is generated
-    while (!(I2C1->SR1 & (SR1_SB))) {
+    status = i2c1_wait_sr1_flag(SR1_SB);
+    if (status != I2C_OK) {
+        return status;
     }
 
     // Transmit the slave address with the read bit, which is 1, to
@@ -155,168 +310,299 @@ void i2c1_single_byte_read(uint8_t saddr, uint8_t maddr, uint8_t *data) {
     I2C1->DR = saddr << 1 | (1U);
 
     // Wait until the end of slave address transmission from master device
-    while (!(I2C1->SR1 & (SR1_ADDR))) {
-    }
+    // The ADDR flag is left set, it is cleared by i2c1_receive().
+    return i2c1_wait_sr1_flag(SR1_ADDR);
+}
 
-    // Disable the acknowledge bit to prepare for a stop condition
-    I2C1->CR1 &= ~CR1_ACK;
+static i2c_status_t i2c1_receive(uint32_t n, uint8_t *data, uint32_t end_condition) {
+    i2c_status_t status;
+    uint16_t temp;
 
-    // Clear the address flag (ADDR bit) by simply reading I2C1 status register 2
-    temp = I2C1->SR2;
+    if (n <= (1U)) {
+        // Disable the acknowledge bit before the single byte is received
+        I2C1->CR1 &= ~CR1_ACK;
 
-    // Initiate a stop condition on the I2C1 bus
-    I2C1->CR1 |= CR1_STOP;
+        // Clear the address flag (ADDR bit) by simply reading I2C1 status register 2
+        temp = I2C1->SR2;
+    } else {
+        // Clear the address flag (ADDR bit) by simply reading I2C1 status register 2
+        temp = I2C1->SR2;
+
+        // Enable the acknowledge bit returned after a byte is received
+        I2C1->CR1 |= CR1_ACK;
+
+        while (n > (1U)) {
+            // Wait until the receive buffer is not empty, indicating that new data has been
+            // received and is available in the data register
+            status = i2c1_wait_sr1_flag(SR1_RXNE);
+            if (status != I2C_OK) {
+                return status;
+            }
 
-    // Wait until the receive buffer is not empty, indicating that new data has been
-    // received and is available in the data register
-    while (!(I2C1->SR1 & (SR1_RXNE))) {
+            // Read the received byte of data
+            (*data++) = I2C1->DR;
+
+            // Decrement the byte counter
+            n--;
+        }
+
+        // Disable the acknowledge bit so that the last byte is not acknowledged
+        I2C1->CR1 &= ~CR1_ACK;
+    }
+
+    // Request either a stop condition or the repeated start of a following transfer
+    I2C1->CR1 |= end_condition;
+
+    // Wait until the last byte is received
+    status = i2c1_wait_sr1_flag(SR1_RXNE);
+    if (status != I2C_OK) {
+        return status;
     }
 
     // Read the received byte of data
-    (*data++) = I2C1->DR;
+    *data = I2C1->DR;
 
     (void)temp;
+
+    return I2C_OK;
 }
 
-void i2c1_multiple_bytes_read(uint8_t saddr, uint8_t maddr, uint32_t n, uint8_t *data) {
-    uint16_t temp;
+i2c_status_t i2c1_single_byte_read(uint8_t saddr, uint8_t maddr, uint8_t *data) {
+    return i2c1_multiple_bytes_read(saddr, maddr, 1U, data);
+}
+
+i2c_status_t i2c1_multiple_bytes_read(uint8_t saddr, uint8_t maddr, uint32_t n, uint8_t *data) {
+    return i2c1_mem_read(saddr, maddr, 1U, n, data);
+}
+
+i2c_status_t i2c1_multiple_bytes_write(uint8_t saddr, uint8_t maddr, uint32_t n, uint8_t *data) {
+    return i2c1_mem_write(saddr, maddr, 1U, n, data);
+}
+
+i2c_status_t i2c1_mem_read(uint8_t saddr, uint16_t maddr, uint8_t maddr_len, uint32_t n, uint8_t *data) {
+    i2c_status_t status;
+
+    if (n == 0U) {
+        return I2C_OK;
+    }
 
     // Ensure the I2C1 bus is not busy before continuing
-    while (I2C1->SR2 & (SR2_BUSY)) {
+    status = i2c1_wait_bus_idle();
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
     // Initiate a start condition on the I2C1 bus to begin communication with the slave device
     I2C1->CR1 |= CR1_START;
 
-    // Wait until the start condition is generated
-    while (!(I2C1->SR1 & (SR1_SB))) {
+    // Select the register to read from
+    status = i2c1_send_register_address(saddr, maddr, maddr_len);
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
-    // Transmit the slave address with the write bit, which is 0
-    I2C1->DR = saddr << 1;
-
-    // Wait until the end of slave address transmission from master device
-    while (!(I2C1->SR1 & (SR1_ADDR))) {
+    // Address the slave again in read mode
+    status = i2c1_start_read(saddr);
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
-    // Clear the address flag (ADDR bit) by simply reading I2C1 status register 2
-    temp = I2C1->SR2;
-
-    // Wait until the data register is empty
-    while (!(I2C1->SR1 & (SR1_TXE))) {
+    // Read the requested bytes and end the transfer with a stop condition
+    status = i2c1_receive(n, data, CR1_STOP);
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
-    // Transmit the memory address to read from the slave device
-    I2C1->DR = maddr;
+    return I2C_OK;
+}
 
-    // Wait until the data register is empty
-    while (!(I2C1->SR1 & (SR1_TXE))) {
+i2c_status_t i2c1_mem_write(uint8_t saddr, uint16_t maddr, uint8_t maddr_len, uint32_t n, const uint8_t *data) {
+    i2c_status_t status;
+
+    // Ensure the I2C1 bus is not busy before continuing
+    status = i2c1_wait_bus_idle();
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
-    // Initiate a restart condition on the I2C1 bus
+    // Initiate a start condition on the I2C1 bus to begin communication with the slave device
     I2C1->CR1 |= CR1_START;
 
-    // Wait until the restart condition is generated
-    while (!(I2C1->SR1 & (SR1_SB))) {
+    // Select the register to write to
+    status = i2c1_send_register_address(saddr, maddr, maddr_len);
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
-    // Transmit the slave address with the read bit, which is 1, to
-    // communicate with the slave device, requesting to read data from it
-    I2C1->DR = saddr << 1 | (1U);
+    for (uint32_t i = 0; i < n; i++) {
+        // Transmit one byte to the specified memory address of the slave device
+        I2C1->DR = *data++;
 
-    // Wait until the end of slave address transmission from master device
-    while (!(I2C1->SR1 & (SR1_ADDR))) {
+        // Wait until the data register is empty
+        status = i2c1_wait_sr1_flag(SR1_TXE);
+        if (status != I2C_OK) {
+            return i2c1_abort(status);
+        }
     }
 
-    // Clear the address flag (ADDR bit) by simply reading I2C1 status register 2
-    temp = I2C1->SR2;
+    // Wait until the byte transfer has fully completed (both data register and shift register are empty)
+    status = i2c1_wait_sr1_flag(SR1_BTF);
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
+    }
 
-    // Enable the acknowledge bit returned after a byte is received
-    I2C1->CR1 |= CR1_ACK;
+    // Initiate a stop condition on the I2C1 bus
+    I2C1->CR1 |= CR1_STOP;
 
-    while (n > (0U)) {
-        // A single-byte read:
-        if (n == (1U)) {
-            // Disable the acknowledge bit to prepare for a stop condition
-            I2C1->CR1 &= ~CR1_ACK;
+    return I2C_OK;
+}
 
-            // Initiate a stop condition on the I2C1 bus
-            I2C1->CR1 |= CR1_STOP;
+i2c_status_t i2c1_chained_read(const i2c1_read_req_t *reqs, uint32_t count) {
+    i2c_status_t status;
 
-            // Wait until the receive buffer is not empty, indicating that new data has been
-            // received and is available in the data register
-            while (!(I2C1->SR1 & (SR1_RXNE))) {
-            }
+    if (count == 0U) {
+        return I2C_OK;
+    }
 
-            // Read the received byte of data
-            *data++ = I2C1->DR;
+    // Ensure the I2C1 bus is not busy before continuing
+    status = i2c1_wait_bus_idle();
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
+    }
 
-            break;
+    // Initiate a start condition on the I2C1 bus for the first request of the chain
+    // Every following request starts with the repeated start requested at the end of the previous one.
+    I2C1->CR1 |= CR1_START;
+
+    for (uint32_t i = 0; i < count; i++) {
+        // The last request releases the bus with a stop condition, the others keep it with a repeated start
+        uint32_t end_condition = (i == (count - 1U)) ? CR1_STOP : CR1_START;
+
+        // Select the register to read from
+        status = i2c1_send_register_address(reqs[i].saddr, reqs[i].maddr, 1U);
+        if (status != I2C_OK) {
+            return i2c1_abort(status);
         }
-        // A multiple-byte read:
-        else {
-            // Wait until the receive buffer is not empty, indicating that new data has been
-            // received and is available in the data register
-            while (!(I2C1->SR1 & (SR1_RXNE))) {
-            }
 
-            // Read the received byte of data
-            (*data++) = I2C1->DR;
+        // Address the slave again in read mode
+        status = i2c1_start_read(reqs[i].saddr);
+        if (status != I2C_OK) {
+            return i2c1_abort(status);
+        }
 
-            // Decrement the byte counter
-            n--;
+        // Read the requested bytes and chain into the next request
+        status = i2c1_receive(reqs[i].n, reqs[i].data, end_condition);
+        if (status != I2C_OK) {
+            return i2c1_abort(status);
         }
     }
 
-    (void)temp;
+    return I2C_OK;
 }
 
-void i2c1_multiple_bytes_write(uint8_t saddr, uint8_t maddr, uint32_t n, uint8_t *data) {
+i2c_status_t i2c1_is_device_ready(uint8_t saddr) {
+    i2c_status_t status;
     uint16_t temp;
 
     // Ensure the I2C1 bus is not busy before continuing
-    while (I2C1->SR2 & (SR2_BUSY)) {
+    status = i2c1_wait_bus_idle();
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
-    // Initiate a start condition on the I2C1 bus to begin communication with the slave device
+    // Initiate a start condition on the I2C1 bus
     I2C1->CR1 |= CR1_START;
 
     // Wait until the start condition is generated
-    while (!(I2C1->SR1 & (SR1_SB))) {
+    status = i2c1_wait_sr1_flag(SR1_SB);
+    if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
     // Transmit the slave address with the write bit, which is 0
     I2C1->DR = saddr << 1;
 
-    // Wait until the end of slave address transmission from master device
-    while (!(I2C1->SR1 & (SR1_ADDR))) {
+    // Wait until the slave acknowledges its address
+    status = i2c1_wait_sr1_flag(SR1_ADDR);
+
+    if (status == I2C_ERR_AF) {
+        // A busy slave (e.g. an EEPROM in its internal write cycle) is expected to refuse the address,
+        // so this is not counted as a bus error
+        I2C1->CR1 |= CR1_STOP;
+        return I2C_ERR_AF;
+    } else if (status != I2C_OK) {
+        return i2c1_abort(status);
     }
 
     // Clear the address flag (ADDR bit) by simply reading I2C1 status register 2
     temp = I2C1->SR2;
+    (void)temp;
 
-    // Wait until the data register is empty
-    while (!(I2C1->SR1 & (SR1_TXE))) {
-    }
+    // Initiate a stop condition on the I2C1 bus
+    I2C1->CR1 |= CR1_STOP;
 
-    // Transmit the memory address to write in the slave device
-    I2C1->DR = maddr;
+    return I2C_OK;
+}
 
-    for (uint32_t i = 0; i < n; i++) {
-        // Wait until the data register is empty
-        while (!(I2C1->SR1 & (SR1_TXE))) {
+void i2c1_bus_recover(void) {
+    i2c1_error_stats.recoveries++;
+
+    // Disable I2C1 module so that it releases the pins
+    I2C1->CR1 &= ~CR1_PE;
+
+    // Release both lines (open-drain high) before handing them over to the GPIO
+    GPIOB->BSRR = SCL_PIN | SDA_PIN;
+
+    // Configure GPIOB Pin 8, 9 as general-purpose outputs (MODERx[1:0] = 01), they stay open-drain
+    MODIFY_REG(GPIOB->MODER, (3U << 16) | (3U << 18), (1U << 16) | (1U << 18));
+
+    // Clock out the byte a slave may still be sending until it releases SDA
+    for (uint32_t i = 0; i < I2C_RECOVERY_CLOCK_PULSES; i++) {
+        if (GPIOB->IDR & SDA_PIN) {
+            break;
         }
 
-        // Transmit one byte to the specified memory address of the slave device
-        I2C1->DR = *data++;
+        GPIOB->BSRR = SCL_PIN << 16;
+        i2c1_recovery_delay();
+        GPIOB->BSRR = SCL_PIN;
+        i2c1_recovery_delay();
     }
 
-    // Wait until the byte transfer has fully completed (both data register and shift register are empty)
-    while (!(I2C1->SR1 & (SR1_BTF))) {
-    }
+    // Generate a stop condition by hand: SDA rises while SCL is high
+    GPIOB->BSRR = SCL_PIN << 16;
+    i2c1_recovery_delay();
+    GPIOB->BSRR = SDA_PIN << 16;
+    i2c1_recovery_delay();
+    GPIOB->BSRR = SCL_PIN;
+    i2c1_recovery_delay();
+    GPIOB->BSRR = SDA_PIN;
+    i2c1_recovery_delay();
+
+    // Give the pins back to the I2C1 peripheral (MODERx[1:0] = 10)
+    MODIFY_REG(GPIOB->MODER, (3U << 16) | (3U << 18), (2U << 16) | (2U << 18));
+
+    // Reset the I2C1 peripheral to clear a BUSY flag latched by the stuck bus
+    I2C1->CR1 |= CR1_SWRST;
+    I2C1->CR1 &= ~CR1_SWRST;
+
+    // Restore the bus timing and enable I2C1 module again
+    i2c1_config();
+}
 
-    // Initiate a stop condition on the I2C1 bus
-    I2C1->CR1 |= CR1_STOP;
+void i2c1_get_error_stats(i2c_error_stats_t *stats) {
+    *stats = i2c1_error_stats;
+}
 
-    (void)temp;
+void i2c1_clear_error_stats(void) {
+    memset(&i2c1_error_stats, 0, sizeof(i2c1_error_stats));
+}
+
+// Called while polling a flag, overridden by the kernel to yield to other tasks instead of spinning
+__attribute__((weak)) void i2c1_wait_hook(void) {
+}
+
+static void i2c1_recovery_delay(void) {
+    // Wait for about half an SCL period of the standard mode
+    for (volatile uint32_t i = 0; i < I2C_RECOVERY_HALF_PERIOD; i++) {
+    }
 }
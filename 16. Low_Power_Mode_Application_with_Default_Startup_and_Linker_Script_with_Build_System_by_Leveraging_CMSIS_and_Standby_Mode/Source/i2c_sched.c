@@ -0,0 +1,172 @@
+#include <stddef.h>
+#include <string.h>
+#include "i2c_sched.h"
+
+/* Periodic I2C1 job scheduler
+ * Every job reads <len> bytes from register <maddr> of the slave <saddr> each <period_ms>.
+ * All jobs that are due at the same time are packed into one chained transaction, so the
+ * bus is acquired once and the reads follow each other with repeated start conditions.
+ *
+ * The destination of a job holds two buffers of <len> bytes. The scheduler always fills the
+ * back buffer and only then publishes it as the front buffer, so a reader never observes a
+ * partially updated sample.
+ */
+
+// Table entry of a periodic job
+typedef struct {
+    uint8_t saddr;              // 7-bit address of the slave device
+    uint8_t maddr;              // Register address inside the slave device
+    uint8_t len;                // Number of bytes read per period
+    uint32_t period_ms;         // Read period in milliseconds
+    uint32_t next_due_ms;       // Time at which the next read is due
+    uint8_t *dest;              // Double buffer of 2 * len bytes
+    volatile uint8_t front;     // Index (0 or 1) of the buffer holding the latest complete sample
+    volatile uint32_t sequence; // Incremented before and after each publish (odd while updating)
+    i2c_sched_stats_t stats;    // Timing statistics of the job
+} i2c_sched_job_t;
+
+static i2c_sched_job_t jobs[I2C_SCHED_MAX_JOBS];
+static uint8_t num_of_jobs;
+
+static uint8_t is_job_due(const i2c_sched_job_t *job, uint32_t now_ms);
+static void i2c_sched_account(i2c_sched_job_t *job, uint32_t now_ms, uint8_t published);
+
+void i2c_sched_init(void) {
+    // Start with an empty job table
+    memset(jobs, 0, sizeof(jobs));
+    num_of_jobs = 0;
+}
+
+int8_t i2c_sched_add(uint8_t saddr, uint8_t maddr, uint8_t len, uint32_t period_ms, uint8_t *dest, uint32_t now_ms) {
+    // Reject invalid jobs and jobs that do not fit in the table
+    if ((num_of_jobs >= I2C_SCHED_MAX_JOBS) || (len == 0U) || (period_ms == 0U) || (dest == NULL)) {
+        return I2C_SCHED_INVALID_JOB;
+    }
+
+    i2c_sched_job_t *job = &jobs[num_of_jobs];
+
+    job->saddr = saddr;
+    job->maddr = maddr;
+    job->len = len;
+    job->period_ms = period_ms;
+    job->dest = dest;
+    job->front = 0;
+    job->sequence = 0;
+
+    // The first read is due immediately
+    job->next_due_ms = now_ms;
+
+    return (int8_t)num_of_jobs++;
+}
+
+uint32_t i2c_sched_run(uint32_t now_ms) {
+    i2c1_read_req_t reqs[I2C_SCHED_MAX_JOBS];
+    uint8_t due_jobs[I2C_SCHED_MAX_JOBS];
+    uint32_t count = 0;
+
+    // Collect every due job into one batch, each one targeting its back buffer
+    for (uint8_t i = 0; i < num_of_jobs; i++) {
+        i2c_sched_job_t *job = &jobs[i];
+
+        if (is_job_due(job, now_ms)) {
+            reqs[count].saddr = job->saddr;
+            reqs[count].maddr = job->maddr;
+            reqs[count].n = job->len;
+            reqs[count].data = &job->dest[(job->front ^ 1U) * job->len];
+            due_jobs[count] = i;
+            count++;
+        }
+    }
+
+    if (count == 0U) {
+        return 0;
+    }
+
+    // Read all due jobs back to back in a single bus transaction
+    uint8_t published = (i2c1_chained_read(reqs, count) == I2C_OK);
+
+    // Publish the freshly filled buffers (a failed batch keeps the previous samples) and update the statistics
+    for (uint32_t i = 0; i < count; i++) {
+        i2c_sched_job_t *job = &jobs[due_jobs[i]];
+
+        if (published) {
+            job->sequence++;
+            job->front ^= 1U;
+            job->sequence++;
+        }
+
+        i2c_sched_account(job, now_ms, published);
+    }
+
+    return count;
+}
+
+const uint8_t *i2c_sched_get_data(int8_t job_id) {
+    if ((job_id < 0) || (job_id >= (int8_t)num_of_jobs)) {
+        return NULL;
+    }
+
+    // Return the buffer holding the latest complete sample
+    return &jobs[job_id].dest[jobs[job_id].front * jobs[job_id].len];
+}
+
+uint8_t i2c_sched_copy_data(int8_t job_id, uint8_t *out) {
+    uint32_t sequence;
+
+    if ((job_id < 0) || (job_id >= (int8_t)num_of_jobs)) {
+        return 0;
+    }
+
+    i2c_sched_job_t *job = &jobs[job_id];
+
+    // Retry the copy if a publish happened in the meantime (scheduler running in an interrupt)
+    do {
+        sequence = job->sequence;
+        memcpy(out, &job->dest[job->front * job->len], job->len);
+    } while ((sequence & 1U) || (sequence != job->sequence));
+
+    // Report whether at least one sample has been read so far
+    return (sequence != 0U);
+}
+
+void i2c_sched_get_stats(int8_t job_id, i2c_sched_stats_t *stats) {
+    if ((job_id < 0) || (job_id >= (int8_t)num_of_jobs)) {
+        return;
+    }
+
+    *stats = jobs[job_id].stats;
+}
+
+void i2c_sched_clear_stats(void) {
+    for (uint8_t i = 0; i < num_of_jobs; i++) {
+        memset(&jobs[i].stats, 0, sizeof(jobs[i].stats));
+    }
+}
+
+static uint8_t is_job_due(const i2c_sched_job_t *job, uint32_t now_ms) {
+    // Wrap-around safe comparison of the current time against the due time
+    return ((int32_t)(now_ms - job->next_due_ms) >= 0);
+}
+
+static void i2c_sched_account(i2c_sched_job_t *job, uint32_t now_ms, uint8_t published) {
+    uint32_t latency = now_ms - job->next_due_ms;
+
+    // Every full period elapsed since the due time is a missed sample
+    uint32_t missed = latency / job->period_ms;
+
+    if (published) {
+        job->stats.runs++;
+    } else {
+        job->stats.errors++;
+    }
+
+    job->stats.misses += missed;
+    job->stats.last_latency_ms = latency;
+
+    if (latency > job->stats.max_latency_ms) {
+        job->stats.max_latency_ms = latency;
+    }
+
+    // Stay on the original period grid instead of trying to catch up with the missed samples
+    job->next_due_ms += (missed + 1U) * job->period_ms;
+}
@@ -0,0 +1,101 @@
+#include <stddef.h>
+#include "irq.h"
+
+/* Central interrupt priority plan
+ * Drivers enable their interrupts through irq_enable(), which applies the priority from the table below
+ * instead of the reset default 0. Latency-critical DMA handlers therefore preempt the UART and user input
+ * handlers, and anything that may block (printf, delays) is restricted to IRQ_PRIO_MAY_BLOCK and below.
+ * Interrupts missing from the table get IRQ_PRIO_DEFERRED.
+ */
+
+static const irq_plan_entry_t irq_plan[] = {
+    { DMA2_Stream5_IRQn, IRQ_PRIO_REALTIME, 0 }, // Waveform engine buffer refill
+    { DMA2_Stream0_IRQn, IRQ_PRIO_DMA,      0 }, // Memory-to-memory transfer complete
+    { DMA1_Stream5_IRQn, IRQ_PRIO_DMA,      0 }, // UART2 reception
+    { DMA1_Stream6_IRQn, IRQ_PRIO_DMA,      1 }, // UART2 transmission
+    { SysTick_IRQn,      IRQ_PRIO_TICK,     0 }, // Time base
+    { USART2_IRQn,       IRQ_PRIO_COMM,     0 }, // UART2 transmission complete
+    { RTC_WKUP_IRQn,     IRQ_PRIO_TIMER,    0 }, // RTC wake-up timer
+    { RTC_Alarm_IRQn,    IRQ_PRIO_TIMER,    1 }, // RTC alarms
+    { EXTI0_IRQn,        IRQ_PRIO_USER,     0 }, // GPIO line 0
+    { EXTI1_IRQn,        IRQ_PRIO_USER,     0 }, // GPIO line 1
+    { EXTI2_IRQn,        IRQ_PRIO_USER,     0 }, // GPIO line 2
+    { EXTI3_IRQn,        IRQ_PRIO_USER,     0 }, // GPIO line 3
+    { EXTI4_IRQn,        IRQ_PRIO_USER,     0 }, // GPIO line 4
+    { EXTI9_5_IRQn,      IRQ_PRIO_USER,     0 }, // GPIO lines 5-9
+    { EXTI15_10_IRQn,    IRQ_PRIO_USER,     0 }, // GPIO lines 10-15 (user button on PC13)
+    { TIM1_TRG_COM_TIM11_IRQn, IRQ_PRIO_USER, 1 }, // EXTI debounce tick (TIM11)
+    { SPI5_IRQn,         IRQ_PRIO_DEFERRED, 0 }, // Deferred work (software interrupt, SPI5 is not used)
+    { PendSV_IRQn,       IRQ_PRIO_LOWEST,   1 }, // Kernel context switch
+};
+
+static uint8_t irq_grouping_set;
+static volatile uint32_t irq_violations;
+
+static const irq_plan_entry_t *irq_lookup(IRQn_Type irq);
+
+void irq_init(void) {
+    // Split the priority field into preempt and sub-priority
+    NVIC_SetPriorityGrouping(IRQ_PRIORITY_GROUP);
+    irq_grouping_set = 1;
+
+    // Apply the whole plan, including the system exceptions
+    for (uint32_t i = 0; i < (sizeof(irq_plan) / sizeof(irq_plan[0])); i++) {
+        NVIC_SetPriority(irq_plan[i].irq, NVIC_EncodePriority(IRQ_PRIORITY_GROUP, irq_plan[i].preempt, irq_plan[i].sub));
+    }
+}
+
+void irq_apply(IRQn_Type irq) {
+    if (!irq_grouping_set) {
+        irq_init();
+    }
+
+    const irq_plan_entry_t *entry = irq_lookup(irq);
+    uint32_t preempt = (entry != NULL) ? entry->preempt : IRQ_PRIO_DEFERRED;
+    uint32_t sub = (entry != NULL) ? entry->sub : 0U;
+
+    NVIC_SetPriority(irq, NVIC_EncodePriority(IRQ_PRIORITY_GROUP, preempt, sub));
+}
+
+void irq_enable(IRQn_Type irq) {
+    // Set the planned priority before the interrupt can fire
+    irq_apply(irq);
+    NVIC_EnableIRQ(irq);
+}
+
+void irq_check_may_block(void) {
+    uint32_t active = __get_IPSR();
+
+    if (active == 0U) {
+        return;
+    }
+
+    uint32_t preempt;
+    uint32_t sub;
+
+    // Exception numbers start 16 below the IRQ numbers
+    NVIC_DecodePriority(NVIC_GetPriority((IRQn_Type)((int32_t)active - 16)), IRQ_PRIORITY_GROUP, &preempt, &sub);
+
+    if (preempt < IRQ_PRIO_MAY_BLOCK) {
+        irq_violations++;
+
+        // Stop right at the offending call when a debugger is attached
+        if (CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk) {
+            __BKPT(0);
+        }
+    }
+}
+
+uint32_t irq_get_violations(void) {
+    return irq_violations;
+}
+
+static const irq_plan_entry_t *irq_lookup(IRQn_Type irq) {
+    for (uint32_t i = 0; i < (sizeof(irq_plan) / sizeof(irq_plan[0])); i++) {
+        if (irq_plan[i].irq == irq) {
+            return &irq_plan[i];
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,666 @@
+#include <stddef.h>
+#include <string.h>
+#include "kernel.h"
+#include "systick.h"
+#include "i2c.h"
+#include "irq.h"
+#ifdef KERNEL_TICKLESS
+#include "stop_mode.h"
+#endif
+
+/* Minimal preemptive kernel
+ * Tasks have a fixed priority (0 is the highest) and a statically allocated stack. The highest
+ * priority ready task always runs, tasks of equal priority take turns when one of them yields or
+ * blocks. A context switch is requested by pending PendSV, which runs at the lowest exception priority,
+ * so it only happens once all other interrupts are done. PendSV saves R4-R11 and EXC_RETURN on the task
+ * stack and S16-S31 only if the task used the FPU; S0-S15 are stacked lazily by the hardware.
+ * Waiters are not kept in lists: with at most KERNEL_MAX_TASKS tasks, scanning the task table for the
+ * highest priority task blocked on an object is cheaper than maintaining the lists.
+ * Any BASEPRI mask holds PendSV off, so tasks must not block inside an irq_lock() section: the blocking
+ * calls return KERNEL_ERR_CONTEXT there, kernel_yield() does nothing and kernel_delay() busy-waits.
+ */
+
+// Macro to define the slot of the idle task, user tasks use the others
+#define KERNEL_IDLE_TASK 0U
+
+// Macro to define the priority of the idle task
+#define KERNEL_IDLE_PRIO 255U
+
+// Macro to define the value the stacks are filled with to measure their usage
+#define KERNEL_STACK_FILL 0xA5A5A5A5U
+
+// Macro to define the initial program status of a task (Thumb state, bit 24 in xPSR)
+#define XPSR_THUMB (1U << 24)
+
+// Macro to define the no-wait-object marker of a plain delay
+#define KERNEL_WAIT_DELAY NULL
+
+// Task states
+enum {
+    TASK_FREE = 0, // Slot not in use
+    TASK_READY,    // Running or waiting for the CPU
+    TASK_BLOCKED   // Waiting for an object, a timeout or both
+};
+
+// Task control block
+typedef struct {
+    uint32_t *sp;          // Saved stack pointer (must be the first member, used by PendSV_Handler)
+    uint32_t *stack;       // Lowest address of the stack
+    uint32_t words;        // Size of the stack in 32-bit words
+    kernel_task_fn_t fn;   // Entry function
+    void *arg;             // Argument of the entry function
+    uint64_t wake_tick;    // Tick at which a blocking call times out (UINT64_MAX: never)
+    const void *wait_obj;  // Object the task is blocked on (NULL for a delay)
+    uint8_t state;         // TASK_FREE, TASK_READY or TASK_BLOCKED
+    uint8_t prio;          // Effective priority, raised by priority inheritance
+    uint8_t base_prio;     // Priority assigned at creation
+    uint8_t wait_result;   // kernel_status_t handed over by the waker
+} kernel_tcb_t;
+
+static kernel_tcb_t kernel_tasks[KERNEL_MAX_TASKS];
+
+// Running task, referenced by name from the PendSV and SVC handlers
+kernel_tcb_t *volatile kernel_current;
+
+static volatile uint8_t kernel_running;
+
+// Context switch time from requesting the switch to the next task running (DWT cycles)
+static profile_probe_t kernel_switch_probe = PROFILE_PROBE_INIT("context switch");
+static volatile uint32_t kernel_switch_start;
+
+KERNEL_STACK_DEFINE(kernel_idle_stack, KERNEL_MIN_STACK_WORDS);
+
+void kernel_schedule(void);
+static void kernel_task_setup(kernel_tcb_t *task, kernel_task_fn_t fn, void *arg, uint8_t prio, uint32_t *stack, uint32_t words);
+static void kernel_task_entry(kernel_tcb_t *task);
+static void kernel_idle(void *arg);
+static uint8_t kernel_in_task(void);
+static uint8_t kernel_may_block(void);
+static void kernel_switch(void);
+static void kernel_switch_record(void);
+static kernel_status_t kernel_block(const void *obj, uint32_t timeout_ms);
+static void kernel_wake(kernel_tcb_t *task, kernel_status_t result);
+static kernel_tcb_t *kernel_highest_waiter(const void *obj);
+static void kernel_check_preempt(void);
+static void kernel_mutex_inherit(kernel_mutex_t *mutex);
+#ifdef KERNEL_TICKLESS
+static uint32_t kernel_ms_until_wake(void);
+#endif
+
+kernel_status_t kernel_task_create(kernel_task_fn_t fn, void *arg, uint8_t prio, uint32_t *stack, uint32_t words, kernel_task_t *task) {
+    if ((fn == NULL) || (stack == NULL) || (words < KERNEL_MIN_STACK_WORDS) || (prio > KERNEL_LOWEST_PRIO)) {
+        return KERNEL_ERR_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // The idle task owns slot 0
+    for (uint32_t i = KERNEL_IDLE_TASK + 1U; i < KERNEL_MAX_TASKS; i++) {
+        if (kernel_tasks[i].state == TASK_FREE) {
+            kernel_task_setup(&kernel_tasks[i], fn, arg, prio, stack, words);
+
+            if (task != NULL) {
+                *task = (kernel_task_t)i;
+            }
+
+            // A task created at run time may preempt its creator
+            if (kernel_running) {
+                kernel_check_preempt();
+            }
+
+            __set_PRIMASK(primask);
+            return KERNEL_OK;
+        }
+    }
+
+    __set_PRIMASK(primask);
+    return KERNEL_ERR_NO_TASK;
+}
+
+void kernel_start(void) {
+    kernel_task_setup(&kernel_tasks[KERNEL_IDLE_TASK], kernel_idle, NULL, KERNEL_IDLE_PRIO, kernel_idle_stack, KERNEL_MIN_STACK_WORDS);
+
+    // The tick drives the timeouts and DWT measures the switch time
+    systick_init();
+    profile_init();
+
+    // Save the FPU registers only when a task actually used them (automatic and lazy state preservation)
+    FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+
+    // PendSV must not preempt any other handler
+    irq_apply(PendSV_IRQn);
+
+    __disable_irq();
+
+    // Pick the first task, the scan starts after the idle task
+    kernel_current = &kernel_tasks[KERNEL_IDLE_TASK];
+    kernel_schedule();
+    kernel_running = 1;
+
+    __enable_irq();
+    __DSB();
+    __ISB();
+
+    // SVC_Handler restores the context of the first task, this stack is not used by Thread mode anymore
+    __asm volatile("svc 0");
+
+    while (1) {
+    }
+}
+
+uint8_t kernel_is_running(void) {
+    return kernel_running;
+}
+
+kernel_task_t kernel_task_self(void) {
+    return (kernel_task_t)(kernel_current - kernel_tasks);
+}
+
+uint32_t kernel_stack_free(kernel_task_t task) {
+    if ((task >= KERNEL_MAX_TASKS) || (kernel_tasks[task].state == TASK_FREE)) {
+        return 0;
+    }
+
+    const kernel_tcb_t *tcb = &kernel_tasks[task];
+    uint32_t unused = 0;
+
+    // The stack grows down, so the untouched fill pattern is at its lowest addresses
+    while ((unused < tcb->words) && (tcb->stack[unused] == KERNEL_STACK_FILL)) {
+        unused++;
+    }
+
+    return unused;
+}
+
+void kernel_yield(void) {
+    if (!kernel_may_block()) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    kernel_switch();
+
+    __set_PRIMASK(primask);
+}
+
+void kernel_delay(uint32_t msec) {
+    // Before the kernel runs (or while PendSV is masked) there is nothing else to do than to wait
+    if (!kernel_may_block()) {
+        systick_msec_delay(msec);
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (msec == 0U) {
+        kernel_switch();
+    } else {
+        kernel_block(KERNEL_WAIT_DELAY, msec);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void kernel_sem_init(kernel_sem_t *sem, uint32_t initial, uint32_t max) {
+    sem->max = max;
+    sem->count = (initial < max) ? initial : max;
+}
+
+kernel_status_t kernel_sem_take(kernel_sem_t *sem, uint32_t timeout_ms) {
+    kernel_status_t status = KERNEL_OK;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (sem->count > 0U) {
+        sem->count--;
+    } else if (timeout_ms == KERNEL_NO_WAIT) {
+        status = KERNEL_ERR_TIMEOUT;
+    } else if (!kernel_in_task()) {
+        // Interrupt handlers and code before kernel_start() cannot block
+        status = KERNEL_ERR_CONTEXT;
+    } else {
+        // kernel_sem_give() hands the unit directly to the woken task
+        status = kernel_block(sem, timeout_ms);
+    }
+
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+kernel_status_t kernel_sem_give(kernel_sem_t *sem) {
+    kernel_status_t status = KERNEL_OK;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    kernel_tcb_t *waiter = kernel_highest_waiter(sem);
+
+    if (waiter != NULL) {
+        kernel_wake(waiter, KERNEL_OK);
+    } else if (sem->count < sem->max) {
+        sem->count++;
+    } else {
+        status = KERNEL_ERR_FULL;
+    }
+
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+void kernel_mutex_init(kernel_mutex_t *mutex) {
+    mutex->owner = KERNEL_TASK_NONE;
+    mutex->depth = 0;
+}
+
+kernel_status_t kernel_mutex_lock(kernel_mutex_t *mutex, uint32_t timeout_ms) {
+    if (!kernel_in_task()) {
+        return KERNEL_ERR_CONTEXT;
+    }
+
+    kernel_status_t status = KERNEL_OK;
+    kernel_task_t self = kernel_task_self();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (mutex->owner == KERNEL_TASK_NONE) {
+        mutex->owner = self;
+        mutex->depth = 1;
+    } else if (mutex->owner == self) {
+        mutex->depth++;
+    } else if (timeout_ms == KERNEL_NO_WAIT) {
+        status = KERNEL_ERR_TIMEOUT;
+    } else {
+        kernel_tcb_t *owner = &kernel_tasks[mutex->owner];
+
+        // Priority inheritance: the owner runs at our priority until it unlocks, so a medium priority
+        // task cannot keep us waiting
+        if (kernel_current->prio < owner->prio) {
+            owner->prio = kernel_current->prio;
+        }
+
+        status = kernel_block(mutex, timeout_ms);
+
+        // On success kernel_mutex_unlock() made us the owner, after a timeout the owner may have
+        // inherited a priority no other waiter needs anymore
+        if (status != KERNEL_OK) {
+            kernel_mutex_inherit(mutex);
+        }
+    }
+
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+kernel_status_t kernel_mutex_unlock(kernel_mutex_t *mutex) {
+    if (!kernel_in_task() || (mutex->owner != kernel_task_self())) {
+        return KERNEL_ERR_NOT_OWNER;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (--mutex->depth == 0U) {
+        // Drop an inherited priority
+        kernel_current->prio = kernel_current->base_prio;
+
+        // Hand the mutex over to the highest priority waiter, which inherits from the remaining ones
+        kernel_tcb_t *waiter = kernel_highest_waiter(mutex);
+
+        if (waiter != NULL) {
+            mutex->owner = (uint8_t)(waiter - kernel_tasks);
+            mutex->depth = 1;
+            kernel_wake(waiter, KERNEL_OK);
+            kernel_mutex_inherit(mutex);
+        } else {
+            mutex->owner = KERNEL_TASK_NONE;
+        }
+
+        kernel_check_preempt();
+    }
+
+    __set_PRIMASK(primask);
+
+    return KERNEL_OK;
+}
+
+void kernel_msgq_init(kernel_msgq_t *queue, void *buffer, uint32_t item_size, uint32_t capacity) {
+    queue->buffer = buffer;
+    queue->item_size = item_size;
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->tail = 0;
+
+    kernel_sem_init(&queue->items, 0, capacity);
+    kernel_sem_init(&queue->slots, capacity, capacity);
+}
+
+kernel_status_t kernel_msgq_send(kernel_msgq_t *queue, const void *msg, uint32_t timeout_ms) {
+    // Reserve a free slot first, then only the copy needs the interrupts masked
+    kernel_status_t status = kernel_sem_take(&queue->slots, timeout_ms);
+
+    if (status != KERNEL_OK) {
+        return status;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    memcpy(&queue->buffer[queue->tail * queue->item_size], msg, queue->item_size);
+    queue->tail = (queue->tail + 1U == queue->capacity) ? 0U : queue->tail + 1U;
+
+    __set_PRIMASK(primask);
+
+    return kernel_sem_give(&queue->items);
+}
+
+kernel_status_t kernel_msgq_receive(kernel_msgq_t *queue, void *msg, uint32_t timeout_ms) {
+    kernel_status_t status = kernel_sem_take(&queue->items, timeout_ms);
+
+    if (status != KERNEL_OK) {
+        return status;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    memcpy(msg, &queue->buffer[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1U == queue->capacity) ? 0U : queue->head + 1U;
+
+    __set_PRIMASK(primask);
+
+    return kernel_sem_give(&queue->slots);
+}
+
+const profile_probe_t *kernel_get_switch_probe(void) {
+    return &kernel_switch_probe;
+}
+
+void systick_tick_hook(void) {
+    if (!kernel_running) {
+        return;
+    }
+
+    uint64_t now = systick_get_ticks();
+
+    // Wake the tasks whose delay or timeout has elapsed
+    for (uint32_t i = 0; i < KERNEL_MAX_TASKS; i++) {
+        if ((kernel_tasks[i].state == TASK_BLOCKED) && (kernel_tasks[i].wake_tick <= now)) {
+            kernel_wake(&kernel_tasks[i], KERNEL_ERR_TIMEOUT);
+        }
+    }
+}
+
+void i2c1_wait_hook(void) {
+    // Let the other tasks of the same priority run while the I2C hardware is busy
+    if (kernel_in_task()) {
+        kernel_yield();
+    }
+}
+
+void kernel_schedule(void) {
+    uint32_t current = (uint32_t)(kernel_current - kernel_tasks);
+    kernel_tcb_t *best = NULL;
+
+    // Scan starting after the running task, so tasks of equal priority take turns; the idle task is always ready
+    for (uint32_t i = 1U; i <= KERNEL_MAX_TASKS; i++) {
+        kernel_tcb_t *task = &kernel_tasks[(current + i) % KERNEL_MAX_TASKS];
+
+        if ((task->state == TASK_READY) && ((best == NULL) || (task->prio < best->prio))) {
+            best = task;
+        }
+    }
+
+    kernel_current = best;
+}
+
+__attribute__((naked)) void PendSV_Handler(void) {
+    __asm volatile(
+        // Save the remaining context of the running task on its stack
+        "mrs r0, psp                            \n"
+        "isb                                    \n"
+        // Bit 4 of EXC_RETURN is clear when the task has an FPU context, S0-S15 are stacked by the hardware
+        "tst lr, #0x10                          \n"
+        "it eq                                  \n"
+        "vstmdbeq r0!, {s16-s31}                \n"
+        "stmdb r0!, {r4-r11, lr}                \n"
+        "movw r1, #:lower16:kernel_current      \n"
+        "movt r1, #:upper16:kernel_current      \n"
+        "ldr r2, [r1]                           \n"
+        "str r0, [r2]                           \n"
+        // Select the next task
+        "cpsid i                                \n"
+        "bl kernel_schedule                     \n"
+        "cpsie i                                \n"
+        // Restore its context
+        "movw r1, #:lower16:kernel_current      \n"
+        "movt r1, #:upper16:kernel_current      \n"
+        "ldr r2, [r1]                           \n"
+        "ldr r0, [r2]                           \n"
+        "ldmia r0!, {r4-r11, lr}                \n"
+        "tst lr, #0x10                          \n"
+        "it eq                                  \n"
+        "vldmiaeq r0!, {s16-s31}                \n"
+        "msr psp, r0                            \n"
+        "isb                                    \n"
+        "bx lr                                  \n");
+}
+
+__attribute__((naked)) void SVC_Handler(void) {
+    __asm volatile(
+        // Restore the initial context of the first task and return to it on the process stack
+        "movw r1, #:lower16:kernel_current      \n"
+        "movt r1, #:upper16:kernel_current      \n"
+        "ldr r2, [r1]                           \n"
+        "ldr r0, [r2]                           \n"
+        "ldmia r0!, {r4-r11, lr}                \n"
+        "msr psp, r0                            \n"
+        "isb                                    \n"
+        "bx lr                                  \n");
+}
+
+static void kernel_task_setup(kernel_tcb_t *task, kernel_task_fn_t fn, void *arg, uint8_t prio, uint32_t *stack, uint32_t words) {
+    // Fill the stack to be able to measure its usage
+    for (uint32_t i = 0; i < words; i++) {
+        stack[i] = KERNEL_STACK_FILL;
+    }
+
+    // The exception frame must start 8-byte aligned
+    uint32_t *sp = (uint32_t *)((uint32_t)(stack + words) & ~7U);
+
+    // Frame unstacked by the hardware on exception return: xPSR, PC, LR, R12, R3-R0
+    *(--sp) = XPSR_THUMB;
+    *(--sp) = (uint32_t)kernel_task_entry & ~1U;
+    *(--sp) = 0;
+    *(--sp) = 0;
+    *(--sp) = 0;
+    *(--sp) = 0;
+    *(--sp) = 0;
+    *(--sp) = (uint32_t)task;
+
+    // Frame restored by PendSV_Handler: EXC_RETURN (Thread mode, process stack, no FPU frame) and R11-R4
+    *(--sp) = EXC_RETURN_THREAD_PSP;
+
+    for (uint32_t i = 0; i < 8U; i++) {
+        *(--sp) = 0;
+    }
+
+    task->sp = sp;
+    task->stack = stack;
+    task->words = words;
+    task->fn = fn;
+    task->arg = arg;
+    task->wake_tick = UINT64_MAX;
+    task->wait_obj = NULL;
+    task->prio = prio;
+    task->base_prio = prio;
+    task->wait_result = KERNEL_OK;
+    task->state = TASK_READY;
+}
+
+static void kernel_task_entry(kernel_tcb_t *task) {
+    __disable_irq();
+    kernel_switch_record();
+    __enable_irq();
+
+    task->fn(task->arg);
+
+    // The task returned, free its slot and never come back
+    __disable_irq();
+    task->state = TASK_FREE;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    __enable_irq();
+
+    while (1) {
+    }
+}
+
+static void kernel_idle(void *arg) {
+    (void)arg;
+
+    while (1) {
+#ifdef KERNEL_TICKLESS
+        // Decide with interrupts masked, so no task can be woken between the check and the Stop mode entry;
+        // the kernel does not use the soft timer wheel, so the next task wake-up alone sets the sleep time
+        __disable_irq();
+        stop_mode_sleep(kernel_ms_until_wake());
+#else
+        // The tick or another interrupt makes a task ready again
+        __WFI();
+#endif
+    }
+}
+
+static uint8_t kernel_in_task(void) {
+    // Blocking is only possible from Thread mode once the kernel runs
+    return kernel_running && (__get_IPSR() == 0U);
+}
+
+static uint8_t kernel_may_block(void) {
+    // PendSV has the lowest priority, so an irq_lock() section would hold the switch off
+    return kernel_in_task() && (__get_BASEPRI() == 0U);
+}
+
+static void kernel_switch(void) {
+    // Called with the interrupts masked, PendSV is taken as soon as they are enabled again
+    kernel_switch_start = profile_cycles();
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+
+    __enable_irq();
+    __ISB();
+
+    // This task continues here once it is scheduled again
+    __disable_irq();
+    kernel_switch_record();
+}
+
+static void kernel_switch_record(void) {
+    // The task that runs next completes the measurement started by the task that gave up the CPU
+    if (kernel_switch_start != 0U) {
+        profile_record(&kernel_switch_probe, profile_cycles() - kernel_switch_start);
+        kernel_switch_start = 0;
+    }
+}
+
+static kernel_status_t kernel_block(const void *obj, uint32_t timeout_ms) {
+    kernel_tcb_t *self = kernel_current;
+
+    // With PendSV masked the task would only switch out after the wait was over, still marked blocked
+    if (__get_BASEPRI() != 0U) {
+        return KERNEL_ERR_CONTEXT;
+    }
+
+    self->state = TASK_BLOCKED;
+    self->wait_obj = obj;
+    self->wait_result = KERNEL_ERR_TIMEOUT;
+    self->wake_tick = (timeout_ms == KERNEL_WAIT_FOREVER) ? UINT64_MAX : systick_get_ticks() + timeout_ms;
+
+    kernel_switch();
+
+    return (kernel_status_t)self->wait_result;
+}
+
+static void kernel_wake(kernel_tcb_t *task, kernel_status_t result) {
+    task->state = TASK_READY;
+    task->wait_obj = NULL;
+    task->wake_tick = UINT64_MAX;
+    task->wait_result = (uint8_t)result;
+
+    // Preempt the running task if the woken one is more important
+    if (kernel_running && (task->prio < kernel_current->prio)) {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    }
+}
+
+static kernel_tcb_t *kernel_highest_waiter(const void *obj) {
+    kernel_tcb_t *best = NULL;
+
+    for (uint32_t i = 0; i < KERNEL_MAX_TASKS; i++) {
+        kernel_tcb_t *task = &kernel_tasks[i];
+
+        if ((task->state == TASK_BLOCKED) && (task->wait_obj == obj) && ((best == NULL) || (task->prio < best->prio))) {
+            best = task;
+        }
+    }
+
+    return best;
+}
+
+static void kernel_check_preempt(void) {
+    // Request a switch if any ready task is more important than the running one
+    for (uint32_t i = 0; i < KERNEL_MAX_TASKS; i++) {
+        if ((kernel_tasks[i].state == TASK_READY) && (kernel_tasks[i].prio < kernel_current->prio)) {
+            SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+            return;
+        }
+    }
+}
+
+static void kernel_mutex_inherit(kernel_mutex_t *mutex) {
+    if (mutex->owner == KERNEL_TASK_NONE) {
+        return;
+    }
+
+    // The owner runs at the highest priority of its own and of the tasks waiting for the mutex
+    // (single level: the tasks the owner itself waits for are not raised)
+    kernel_tcb_t *owner = &kernel_tasks[mutex->owner];
+    kernel_tcb_t *waiter = kernel_highest_waiter(mutex);
+
+    owner->prio = owner->base_prio;
+
+    if ((waiter != NULL) && (waiter->prio < owner->prio)) {
+        owner->prio = waiter->prio;
+    }
+}
+
+#ifdef KERNEL_TICKLESS
+static uint32_t kernel_ms_until_wake(void) {
+    uint64_t now = systick_get_ticks();
+    uint64_t nearest = STOP_MODE_MAX_SLEEP_MS;
+
+    // Sleep until the nearest delay or timeout expires, interrupts wake the tasks blocked forever
+    for (uint32_t i = 0; i < KERNEL_MAX_TASKS; i++) {
+        if (kernel_tasks[i].state == TASK_BLOCKED) {
+            uint64_t wake = kernel_tasks[i].wake_tick;
+
+            if (wake <= now) {
+                return 0;
+            }
+
+            if ((wake - now) < nearest) {
+                nearest = wake - now;
+            }
+        }
+    }
+
+    return (uint32_t)nearest;
+}
+#endif
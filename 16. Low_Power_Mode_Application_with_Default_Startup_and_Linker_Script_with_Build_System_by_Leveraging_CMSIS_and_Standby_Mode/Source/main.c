@@ -7,9 +7,12 @@
  * - Initializes UART2 for debugging output.
  * - Configures PA0 as a wake-up pin.
  * - Checks whether the system resumed from Standby mode and handles reset flags.
- * - Sets up EXTI13 to trigger standby entry when the button is pressed.
+ * - Registers a debounced EXTI13 callback to trigger standby entry when the button is pressed.
+ * - Saves the application state in the RTC backup registers before entering Standby
+ *   and restores it when the system resumes, so a warm boot skips the re-initialization.
  *
- * The main loop remains idle. When the user button is pressed, the MCU enters
+ * The main loop sleeps in an event loop. When the user button is pressed, the interrupt queues
+ * the Standby entry as deferred work, which runs in the lowest priority software interrupt. The MCU enters
  * Standby mode and can be woken up by toggling PA0.
  * In normal mode, connect a jumper wire from PA0 to the ground. To trigger a wake-up event,
  * pull out the jumper wire and connect it to 3.3V, causing a change in logic that will wake the
@@ -20,31 +23,57 @@
 #include "uart.h"
 #include "gpio_exti.h"
 #include "standby_mode.h"
+#include "rtc.h"
+#include "backup.h"
+#include "event_loop.h"
+#include "defer.h"
+
+// Macro to define the settling time of the user button (in ms)
+#define BUTTON_DEBOUNCE_MS 20U
+
+// Macro to define the layout version of the state kept across Standby
+#define APP_STATE_VERSION 1U
+
+// Application state kept in the backup registers across Standby
+typedef struct {
+    uint32_t standby_entries; // Number of times the system entered Standby
+    uint32_t cold_boot_epoch; // Calendar time of the last cold boot
+} app_state_t;
+
+static app_state_t app_state;
 
 static void check_reset_source(void);
-static void exti13_callback(void);
-void EXTI15_10_IRQHandler(void);
+static void exti13_callback(uint32_t arg);
+static void button_pressed(uint8_t pin, uint8_t level);
 
 /**
  * Main function: Initializes UART2, configures PA0 as a wake-up pin,
  * checks the reset source, and sets up the external interrupt on PC13.
- * The main loop remains idle.
+ * The main loop sleeps, the button is handled by the deferred work interrupt.
  */
 int main(void) {
 	// Initialize UART 2 peripheral for debugging
 	uart2_init();
 
+	// Initialize RTC peripheral (keeps the running calendar on a warm boot) and the backup registers
+	rtc_init();
+	backup_init();
+
 	// Configure the wake-up pin to prepare the microcontroller to respond to external wake-up signals
 	pa0_wakeup_pin_init();
 
     // Determine if the last reset was caused by the standby mode or another source
     check_reset_source();
 
-    // Initialize EXTI 13 peripheral
-    pc13_exti13_init();
+    // Handle the button in the deferred work interrupt, the main loop only sleeps
+    defer_init();
+    event_loop_init(1);
 
-    while (1) {
-    }
+    // Report debounced falling edges of the user button (PC13)
+    exti_register(GPIOC, 13, EXTI_EDGE_FALLING, BUTTON_DEBOUNCE_MS, button_pressed);
+
+    // Sleep, the core stays asleep across the interrupts
+    event_loop_run();
 }
 
 static void check_reset_source(void) {
@@ -58,11 +87,25 @@ static void check_reset_source(void) {
 
         printf("The system has resumed from Standby...\n\r");
 
+        // Resume with the state saved before entering Standby
+        if (backup_restore(APP_STATE_VERSION, &app_state, sizeof(app_state))) {
+            printf("State restored, %lu Standby entries so far\n\r", (unsigned long)app_state.standby_entries);
+        }
+
     	// Wait for the wake-up pin to be released, ensuring that the pin is in a stable state before proceeding
         while (get_pa0_wakeup_pin_state() == 0) {
         }
     }
 
+    // A cold boot (or an invalid record) starts from a fresh state
+    if (app_state.cold_boot_epoch == 0U) {
+        rtc_snapshot_t now;
+        rtc_get_snapshot(&now);
+
+        app_state.standby_entries = 0;
+        app_state.cold_boot_epoch = now.epoch;
+    }
+
     // Check whether the wake-up flag (WUF) is set
     if ((PWR->CSR & PWR_CSR_WUF) == PWR_CSR_WUF) {
     	// Clears the flag to reset the wake-up status
@@ -70,16 +113,20 @@ static void check_reset_source(void) {
     }
 }
 
-static void exti13_callback(void) {
+static void exti13_callback(uint32_t arg) {
+	(void)arg;
+
+	// Save the application state, SRAM is lost in Standby
+	app_state.standby_entries++;
+	backup_save(APP_STATE_VERSION, &app_state, sizeof(app_state));
+
 	standby_pa0_wakeup_pin_setup();
 }
 
-void EXTI15_10_IRQHandler(void) {
-    if ((EXTI->PR & (LINE13)) != 0) {
-        // Clear PR (pending bit) flag
-        EXTI->PR |= LINE13;
+static void button_pressed(uint8_t pin, uint8_t level) {
+    (void)pin;
+    (void)level;
 
-        // Execute the callback function to handle the external interrupt
-        exti13_callback();
-    }
+    // Let the software interrupt save the state and wait for the wake-up pin
+    defer_post(exti13_callback, 0);
 }
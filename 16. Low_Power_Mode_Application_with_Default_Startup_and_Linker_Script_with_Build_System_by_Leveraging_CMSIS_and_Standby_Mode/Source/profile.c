@@ -0,0 +1,78 @@
+#include "profile.h"
+
+#ifdef PROFILE_HOST
+// Stub cycle counter advanced by the host program
+volatile uint32_t profile_host_cycles;
+#endif
+
+// Number of cycles that Reset_Handler spends before main() is called (written by the startup code)
+uint32_t g_reset_handler_cycles;
+
+// Cost of an empty start/stop pair, subtracted from every sample
+static uint32_t profile_overhead;
+
+void profile_init(void) {
+#ifndef PROFILE_HOST
+    // Enable the trace and debug blocks, which include the DWT unit
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+    // Enable the cycle counter if the startup code has not done it yet
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+#endif
+
+    // Measure the cost of the probe itself with an empty section
+    profile_probe_t calibration = PROFILE_PROBE_INIT("calibration");
+    profile_overhead = 0;
+
+    for (uint32_t i = 0; i < 8U; i++) {
+        profile_start(&calibration);
+        profile_stop(&calibration);
+    }
+
+    profile_overhead = calibration.min;
+}
+
+void profile_probe_reset(profile_probe_t *probe, const char *name) {
+    probe->name = name;
+    probe->start = 0;
+    probe->count = 0;
+    probe->min = UINT32_MAX;
+    probe->max = 0;
+    probe->total = 0;
+}
+
+void profile_record(profile_probe_t *probe, uint32_t cycles) {
+    // Remove the measurement overhead without wrapping below zero
+    cycles = (cycles > profile_overhead) ? (cycles - profile_overhead) : 0U;
+
+    probe->count++;
+    probe->total += cycles;
+
+    if (cycles < probe->min) {
+        probe->min = cycles;
+    }
+
+    if (cycles > probe->max) {
+        probe->max = cycles;
+    }
+}
+
+uint32_t profile_mean(const profile_probe_t *probe) {
+    if (probe->count == 0U) {
+        return 0;
+    }
+
+    // Round to the nearest cycle
+    return (uint32_t)((probe->total + (probe->count / 2U)) / probe->count);
+}
+
+uint32_t profile_get_overhead(void) {
+    return profile_overhead;
+}
+
+void profile_scope_exit(profile_probe_t **probe) {
+    profile_stop(*probe);
+}
@@ -0,0 +1,124 @@
+#include <stddef.h>
+#include "pt.h"
+
+/* Run queue of stackless coroutines
+ * pt_sched_run() calls every queued thread that either polls (no event awaited) or waits for one of the
+ * events posted since the previous pass; finished threads leave the queue. Interrupt handlers post the
+ * events with pt_sched_signal(), an atomic OR, so a multi-step operation reads linearly:
+ *
+ *     static uint8_t report_thread(pt_t *pt, void *arg) {
+ *         PT_BEGIN(pt);
+ *         i2c1_multiple_bytes_read(saddr, maddr, 6, data);
+ *         dma1_stream6_uart2_tx_config((uint32_t)msg, len);
+ *         PT_AWAIT_EVENT(pt, PT_EVENT_UART2_TX);
+ *         PT_DELAY(pt, 100);
+ *         PT_END(pt);
+ *     }
+ *
+ * Each concurrent operation costs one pt_task_t (20 bytes) instead of a task stack.
+ */
+
+// Macro to define the maximum number of queued threads
+#define PT_SCHED_MAX_TASKS 16U
+
+static pt_task_t *pt_run_queue[PT_SCHED_MAX_TASKS];
+static uint32_t pt_run_count;
+static volatile uint32_t pt_sched_pending;
+
+uint32_t pt_sched_events;
+
+#if defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_7M__)
+// Atomic OR into the pending events (forced inline, so that it runs from SRAM inside pt_sched_signal())
+static inline __attribute__((always_inline)) void pt_pending_or(uint32_t events) {
+    uint32_t value;
+
+    // Retry when another context wrote the mask between the exclusive load and store
+    do {
+        value = __LDREXW(&pt_sched_pending) | events;
+    } while (__STREXW(value, &pt_sched_pending) != 0U);
+}
+
+// Atomic read and clear of the pending events
+static inline __attribute__((always_inline)) uint32_t pt_pending_take(void) {
+    uint32_t value;
+
+    do {
+        value = __LDREXW(&pt_sched_pending);
+    } while (__STREXW(0U, &pt_sched_pending) != 0U);
+
+    return value;
+}
+#else
+// Atomic OR into the pending events (host tests use the GCC __atomic builtins)
+static inline __attribute__((always_inline)) void pt_pending_or(uint32_t events) {
+    __atomic_fetch_or(&pt_sched_pending, events, __ATOMIC_SEQ_CST);
+}
+
+// Atomic read and clear of the pending events
+static inline __attribute__((always_inline)) uint32_t pt_pending_take(void) {
+    return __atomic_exchange_n(&pt_sched_pending, 0U, __ATOMIC_SEQ_CST);
+}
+#endif
+
+void pt_sched_init(void) {
+    pt_run_count = 0;
+    pt_sched_pending = 0;
+    pt_sched_events = 0;
+}
+
+uint8_t pt_sched_add(pt_task_t *task, pt_thread_t fn, void *arg) {
+    if (pt_run_count >= PT_SCHED_MAX_TASKS) {
+        return 0;
+    }
+
+    PT_INIT(&task->pt);
+    task->fn = fn;
+    task->arg = arg;
+
+    pt_run_queue[pt_run_count++] = task;
+
+    return 1;
+}
+
+// Placed in SRAM for the interrupt handlers that run from there (DMA1_Stream5_IRQHandler)
+RAMFUNC void pt_sched_signal(uint32_t events) {
+    pt_pending_or(events);
+}
+
+uint32_t pt_sched_run(void) {
+    uint32_t ran = 0;
+
+    // Take the events posted so far, later ones are delivered by the next pass
+    pt_sched_events = pt_pending_take();
+
+    for (uint32_t i = 0; i < pt_run_count;) {
+        pt_task_t *task = pt_run_queue[i];
+
+        // A thread waiting for events is skipped until one of them arrives
+        if ((task->pt.wait != 0U) && ((task->pt.wait & pt_sched_events) == 0U)) {
+            i++;
+            continue;
+        }
+
+        ran++;
+
+        if (task->fn(&task->pt, task->arg) >= PT_EXITED) {
+            // Remove the finished thread and keep the order of the others
+            pt_run_count--;
+
+            for (uint32_t j = i; j < pt_run_count; j++) {
+                pt_run_queue[j] = pt_run_queue[j + 1U];
+            }
+        } else {
+            i++;
+        }
+    }
+
+    pt_sched_events = 0;
+
+    return ran;
+}
+
+uint32_t pt_sched_count(void) {
+    return pt_run_count;
+}
@@ -0,0 +1,392 @@
+#include <stddef.h>
+#include "pwm.h"
+
+/* PWM generation on TIM1-TIM4
+ * Channels run in PWM mode 1 with preloaded compare registers, so duty cycle changes take effect at
+ * the next update event without glitches. TIM1 additionally drives complementary outputs with
+ * dead-time insertion. A DMA burst through TIMx_DMAR can reload one or more compare registers at
+ * every update event from a table in memory, which plays a waveform with no CPU involvement.
+ *
+ * Typical pins (alternate function in parentheses):
+ *   TIM1 CH1-CH4 PA8-PA11 (AF1), CH1N-CH3N PB13-PB15 (AF1)
+ *   TIM2 CH1 PA5 (AF1, user LED), CH2 PA1 (AF1), CH3 PB10 (AF1)
+ *   TIM3 CH1-CH2 PA6-PA7 (AF2), CH3-CH4 PB0-PB1 (AF2)
+ *   TIM4 CH1-CH4 PB6-PB9 (AF2)
+ *
+ * The TIM4 update request is served by DMA1 Stream 6, the stream uart_dma.c uses for USART2 TX. A TIM4
+ * burst is refused while USART2 transmits by DMA (CR3_DMAT set) or the stream is enabled, and a running
+ * TIM4 burst has to be stopped before the UART2 DMA driver is initialized.
+ */
+
+// Macro to enable the clock for TIM1 (bit 0 in RCC_APB2ENR)
+#define TIM1EN (1U << 0)
+
+// Macro to enable the clock for TIM2 (bit 0 in RCC_APB1ENR)
+#define TIM2EN (1U << 0)
+
+// Macro to enable the clock for TIM3 (bit 1 in RCC_APB1ENR)
+#define TIM3EN (1U << 1)
+
+// Macro to enable the clock for TIM4 (bit 2 in RCC_APB1ENR)
+#define TIM4EN (1U << 2)
+
+// Macro to enable clock for DMA1 controller (bit 21 in RCC_AHB1ENR register)
+#define DMA1EN (1U << 21)
+
+// Macro to enable clock for DMA2 controller (bit 22 in RCC_AHB1ENR register)
+#define DMA2EN (1U << 22)
+
+// Macro to enable the counter (bit 0 in TIMx_CR1)
+#define CR1_CEN (1U << 0)
+
+// Macro to select center-aligned mode 1 (CMS[1:0] = 01, bits 6:5 in TIMx_CR1)
+#define CR1_CMS_CENTER1 (1U << 5)
+
+// Macro to mask the center-aligned mode selection (bits 6:5 in TIMx_CR1)
+#define CR1_CMS_MASK (3U << 5)
+
+// Macro to enable the auto-reload preload (bit 7 in TIMx_CR1)
+#define CR1_ARPE (1U << 7)
+
+// Macro to generate an update event (bit 0 in TIMx_EGR)
+#define EGR_UG (1U << 0)
+
+// Macro to enable the update DMA request (bit 8 in TIMx_DIER)
+#define DIER_UDE (1U << 8)
+
+// Macro to enable the main output of TIM1 (bit 15 in TIM1_BDTR)
+#define BDTR_MOE (1U << 15)
+
+// Macro to select PWM mode 1 with compare preload for one channel of TIMx_CCMRx (OCxM = 110, OCxPE = 1)
+#define CCMR_PWM1_PRELOAD ((6U << 4) | (1U << 3))
+
+// Macro to enable the DMA stream (bit 0 in DMA_SxCR register)
+#define DMA_SCR_EN (1U << 0)
+
+// Macro to select memory-to-peripheral direction (DIR[1:0] = 01, bits 7:6 in DMA_SxCR register)
+#define DMA_SCR_DIR_M2P (1U << 6)
+
+// Macro to enable DMA circular mode (bit 8 in DMA_SxCR register)
+#define DMA_SCR_CIRC (1U << 8)
+
+// Macro to enable memory increment mode (bit 10 in DMA_SxCR register)
+#define DMA_SCR_MINC (1U << 10)
+
+// Macro to select 16-bit peripheral data size (bits 12:11 = 01 in DMA_SxCR register)
+#define DMA_SCR_PSIZE_HALF (1U << 11)
+
+// Macro to select 16-bit memory data size (bits 14:13 = 01 in DMA_SxCR register)
+#define DMA_SCR_MSIZE_HALF (1U << 13)
+
+// Macro to select the request channel of a stream (bits 27:25 in DMA_SxCR register)
+#define DMA_SCR_CHSEL(ch) ((uint32_t)(ch) << 25)
+
+// Macro to define the word offset of TIMx_CCR1 used as DMA burst base address (0x34 / 4)
+#define DCR_DBA_CCR1 13U
+
+// Macro to check whether USART2 transmits by DMA (bit 7 in USART_CR3)
+#define USART_CR3_DMAT_EN (1U << 7)
+
+// DMA stream serving the update request of a timer
+typedef struct {
+    TIM_TypeDef *tim;
+    DMA_TypeDef *dma;
+    DMA_Stream_TypeDef *stream;
+    uint32_t channel;
+    volatile uint32_t *ifcr; // Flag clear register of the stream
+    uint32_t ifcr_mask;      // All flags of the stream in that register
+} pwm_dma_route_t;
+
+// TIMx_UP request mapping (TIM2_UP is left out, see pwm_dma_burst_start())
+static const pwm_dma_route_t pwm_dma_routes[] = {
+    { TIM1, DMA2, DMA2_Stream5, 6U, &DMA2->HIFCR, (0x3DU << 6)  },
+    { TIM3, DMA1, DMA1_Stream2, 5U, &DMA1->LIFCR, (0x3DU << 16) },
+    { TIM4, DMA1, DMA1_Stream6, 2U, &DMA1->HIFCR, (0x3DU << 16) },
+};
+
+static const pwm_dma_route_t *pwm_find_dma_route(TIM_TypeDef *tim);
+static uint8_t pwm_dma_route_is_free(const pwm_dma_route_t *route);
+static volatile uint32_t *pwm_ccr(TIM_TypeDef *tim, uint8_t channel);
+
+uint8_t pwm_compute_timing(uint32_t clk_hz, uint32_t freq_hz, pwm_align_t align, pwm_timing_t *timing) {
+    if ((freq_hz == 0U) || (timing == NULL)) {
+        return 0;
+    }
+
+    // Counter clocks per period; a center-aligned counter travels up and down once per period
+    uint32_t divisor = (align == PWM_ALIGN_CENTER) ? (2U * freq_hz) : freq_hz;
+    uint32_t total = clk_hz / divisor;
+
+    // At least two steps are needed to get anything but a constant level
+    if (total < 2U) {
+        return 0;
+    }
+
+    // Longest counter length: ARR + 1 edge-aligned, ARR center-aligned
+    uint32_t max_length = (align == PWM_ALIGN_CENTER) ? PWM_ARR_MAX : (PWM_ARR_MAX + 1U);
+
+    // Pick the smallest prescaler that still fits the period into 16 bits, which gives the best resolution
+    uint32_t psc = (total - 1U) / max_length;
+
+    // Round the counter length to the nearest achievable value
+    uint32_t length = (clk_hz + ((divisor * (psc + 1U)) / 2U)) / (divisor * (psc + 1U));
+
+    // Rounding up may exceed the 16-bit range by one, the next prescaler fits it again
+    if (length > max_length) {
+        psc++;
+        length = (clk_hz + ((divisor * (psc + 1U)) / 2U)) / (divisor * (psc + 1U));
+    }
+
+    if ((psc > 0xFFFFU) || (length < 2U)) {
+        return 0;
+    }
+
+    // Edge-aligned counts 0..ARR (ARR + 1 clocks), center-aligned counts 0..ARR..0 (2 * ARR clocks)
+    timing->psc = (uint16_t)psc;
+    timing->arr = (uint16_t)((align == PWM_ALIGN_CENTER) ? length : (length - 1U));
+    timing->steps = length;
+
+    return 1;
+}
+
+uint32_t pwm_timing_frequency(uint32_t clk_hz, const pwm_timing_t *timing, pwm_align_t align) {
+    uint32_t period = (align == PWM_ALIGN_CENTER) ? (2U * timing->arr) : (timing->arr + 1U);
+
+    return clk_hz / ((timing->psc + 1U) * period);
+}
+
+uint32_t pwm_duty_to_compare(uint32_t arr, pwm_align_t align, uint16_t duty) {
+    uint32_t steps = (align == PWM_ALIGN_CENTER) ? arr : (arr + 1U);
+
+    if (duty > PWM_DUTY_FULL) {
+        duty = PWM_DUTY_FULL;
+    }
+
+    // The output is active while CNT < CCR, so CCR = steps gives 100 %
+    return (uint32_t)(((uint64_t)steps * duty + (PWM_DUTY_FULL / 2U)) / PWM_DUTY_FULL);
+}
+
+uint8_t pwm_deadtime_to_dtg(uint32_t clk_hz, uint32_t deadtime_ns) {
+    // Dead-time in tDTS periods (CKD = 00, so tDTS = 1 / clk_hz), rounded up
+    uint32_t ticks = (uint32_t)(((uint64_t)deadtime_ns * clk_hz + 999999999U) / 1000000000U);
+
+    // DTG[7:5] selects one of four linear ranges (RM0383, TIM1_BDTR)
+    if (ticks <= 127U) {
+        return (uint8_t)ticks;
+    }
+
+    if (ticks <= 254U) {
+        return (uint8_t)(0x80U | (((ticks + 1U) / 2U) - 64U));
+    }
+
+    if (ticks <= 504U) {
+        return (uint8_t)(0xC0U | (((ticks + 7U) / 8U) - 32U));
+    }
+
+    if (ticks <= 1008U) {
+        return (uint8_t)(0xE0U | (((ticks + 15U) / 16U) - 32U));
+    }
+
+    // Saturate at the longest dead-time
+    return 0xFFU;
+}
+
+void pwm_pin_init(GPIO_TypeDef *port, uint8_t pin, uint8_t af) {
+    // Enable the clock access to the port (GPIOA = bit 0, GPIOB = bit 1, ... in RCC_AHB1ENR)
+    RCC->AHB1ENR |= (1U << (((uint32_t)port - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE)));
+
+    // Select the alternate function of the pin
+    port->AFR[pin >> 3] &= ~(0xFU << ((pin & 7U) * 4U));
+    port->AFR[pin >> 3] |= ((uint32_t)af << ((pin & 7U) * 4U));
+
+    // Use a fast output speed for sharp edges
+    port->OSPEEDR |= (2U << (pin * 2U));
+
+    // Configure the pin in alternate function mode (MODERx[1:0] = 10)
+    port->MODER &= ~(3U << (pin * 2U));
+    port->MODER |= (2U << (pin * 2U));
+}
+
+uint8_t pwm_init(TIM_TypeDef *tim, uint32_t freq_hz, pwm_align_t align) {
+    pwm_timing_t timing;
+
+    if (!pwm_compute_timing(PWM_TIM_CLK, freq_hz, align, &timing)) {
+        return 0;
+    }
+
+    // Enable clock access to the timer
+    if (tim == TIM1) {
+        RCC->APB2ENR |= TIM1EN;
+    } else if (tim == TIM2) {
+        RCC->APB1ENR |= TIM2EN;
+    } else if (tim == TIM3) {
+        RCC->APB1ENR |= TIM3EN;
+    } else if (tim == TIM4) {
+        RCC->APB1ENR |= TIM4EN;
+    } else {
+        return 0;
+    }
+
+    // Stop the counter while it is reconfigured
+    tim->CR1 &= ~CR1_CEN;
+
+    // Preload the auto-reload register and select the alignment
+    tim->CR1 &= ~CR1_CMS_MASK;
+    tim->CR1 |= CR1_ARPE;
+
+    if (align == PWM_ALIGN_CENTER) {
+        tim->CR1 |= CR1_CMS_CENTER1;
+    }
+
+    tim->PSC = timing.psc;
+    tim->ARR = timing.arr;
+    tim->CNT = 0;
+
+    // Load prescaler and auto-reload value now, then clear the resulting flags
+    tim->EGR = EGR_UG;
+    tim->SR = 0;
+
+    // The advanced timer only drives its outputs once the main output is enabled
+    if (tim == TIM1) {
+        tim->BDTR |= BDTR_MOE;
+    }
+
+    // Enable timer and make it start counting
+    tim->CR1 |= CR1_CEN;
+
+    return 1;
+}
+
+void pwm_channel_enable(TIM_TypeDef *tim, uint8_t channel) {
+    uint32_t index = (uint32_t)(channel - 1U);
+    volatile uint32_t *ccmr = (index < 2U) ? &tim->CCMR1 : &tim->CCMR2;
+    uint32_t shift = (index & 1U) * 8U;
+
+    // Select PWM mode 1 with compare preload, channel as output (CCxS = 00)
+    *ccmr &= ~(0xFFU << shift);
+    *ccmr |= (CCMR_PWM1_PRELOAD << shift);
+
+    // Start at 0 % duty and enable the output (CCxE), active high
+    *pwm_ccr(tim, channel) = 0;
+    tim->CCER &= ~(0x2U << (index * 4U));
+    tim->CCER |= (0x1U << (index * 4U));
+}
+
+void pwm_channel_disable(TIM_TypeDef *tim, uint8_t channel) {
+    uint32_t index = (uint32_t)(channel - 1U);
+
+    // Disable the output and its complementary output (CCxE, CCxNE)
+    tim->CCER &= ~(0x5U << (index * 4U));
+}
+
+void pwm_set_duty(TIM_TypeDef *tim, uint8_t channel, uint16_t duty) {
+    pwm_align_t align = ((tim->CR1 & CR1_CMS_MASK) != 0U) ? PWM_ALIGN_CENTER : PWM_ALIGN_EDGE;
+
+    // The new value is latched at the next update event (compare preload)
+    *pwm_ccr(tim, channel) = pwm_duty_to_compare(tim->ARR, align, duty);
+}
+
+void pwm_tim1_complementary_enable(uint8_t channel, uint32_t deadtime_ns) {
+    uint32_t index = (uint32_t)(channel - 1U);
+
+    // Only channels 1 to 3 have a complementary output
+    if (index > 2U) {
+        return;
+    }
+
+    // Program the dead-time inserted between an output and its complement (DTG[7:0] in TIM1_BDTR)
+    TIM1->BDTR &= ~(0xFFU << 0);
+    TIM1->BDTR |= pwm_deadtime_to_dtg(PWM_TIM_CLK, deadtime_ns);
+
+    // Enable the complementary output (CCxNE), active high
+    TIM1->CCER &= ~(0x8U << (index * 4U));
+    TIM1->CCER |= (0x4U << (index * 4U));
+}
+
+uint8_t pwm_dma_burst_start(TIM_TypeDef *tim, uint8_t first_channel, uint8_t channels,
+                            const uint16_t *table, uint16_t len) {
+    // TIM2 has 32-bit compare registers, a 16-bit write from the DMA would be duplicated into the upper half
+    const pwm_dma_route_t *route = pwm_find_dma_route(tim);
+
+    if ((route == NULL) || (first_channel < 1U) || (channels < 1U) ||
+        ((first_channel + channels) > 5U) || (table == NULL) || (len == 0U)) {
+        return 0;
+    }
+
+    // Do not take the stream away from another driver (USART2 TX for TIM4)
+    if (!pwm_dma_route_is_free(route)) {
+        return 0;
+    }
+
+    // Enable the clock access to the DMA controller
+    RCC->AHB1ENR |= (route->dma == DMA2) ? DMA2EN : DMA1EN;
+
+    // Disable the stream and wait until it is released before configuring it
+    route->stream->CR &= ~DMA_SCR_EN;
+
+    while ((route->stream->CR & DMA_SCR_EN)) {
+    }
+
+    // Clear flags left over from a previous use of the stream
+    *route->ifcr = route->ifcr_mask;
+
+    // Each update writes 'channels' consecutive compare registers starting at CCRx through TIMx_DMAR
+    tim->DCR = ((uint32_t)(channels - 1U) << 8) | (DCR_DBA_CCR1 + (uint32_t)(first_channel - 1U));
+
+    // Source is the waveform table, destination the DMA burst address register
+    route->stream->PAR = (uint32_t)&tim->DMAR;
+    route->stream->M0AR = (uint32_t)table;
+    route->stream->NDTR = len;
+
+    // Memory-to-peripheral, half-word transfers, memory increment, circular so the table repeats
+    route->stream->CR = DMA_SCR_CHSEL(route->channel) | DMA_SCR_MSIZE_HALF | DMA_SCR_PSIZE_HALF |
+                        DMA_SCR_MINC | DMA_SCR_CIRC | DMA_SCR_DIR_M2P;
+
+    // Direct mode, each request moves exactly one half-word
+    route->stream->FCR = 0;
+
+    route->stream->CR |= DMA_SCR_EN;
+
+    // Request a burst at every update event
+    tim->DIER |= DIER_UDE;
+
+    return 1;
+}
+
+void pwm_dma_burst_stop(TIM_TypeDef *tim) {
+    const pwm_dma_route_t *route = pwm_find_dma_route(tim);
+
+    // Leave the stream alone unless this timer's burst owns it
+    if ((route == NULL) || !(tim->DIER & DIER_UDE)) {
+        return;
+    }
+
+    // Stop requesting bursts, then release the stream
+    tim->DIER &= ~DIER_UDE;
+    route->stream->CR &= ~DMA_SCR_EN;
+}
+
+static const pwm_dma_route_t *pwm_find_dma_route(TIM_TypeDef *tim) {
+    for (uint32_t i = 0; i < (sizeof(pwm_dma_routes) / sizeof(pwm_dma_routes[0])); i++) {
+        if (pwm_dma_routes[i].tim == tim) {
+            return &pwm_dma_routes[i];
+        }
+    }
+
+    return NULL;
+}
+
+static uint8_t pwm_dma_route_is_free(const pwm_dma_route_t *route) {
+    // DMA1 Stream 6 belongs to USART2 TX once the UART2 DMA driver is initialized
+    if ((route->stream == DMA1_Stream6) && (USART2->CR3 & USART_CR3_DMAT_EN)) {
+        return 0;
+    }
+
+    // An enabled stream is only ours if this timer already requests bursts
+    return !(route->stream->CR & DMA_SCR_EN) || (route->tim->DIER & DIER_UDE);
+}
+
+static volatile uint32_t *pwm_ccr(TIM_TypeDef *tim, uint8_t channel) {
+    // CCR1 to CCR4 are consecutive registers
+    return &tim->CCR1 + (channel - 1U);
+}
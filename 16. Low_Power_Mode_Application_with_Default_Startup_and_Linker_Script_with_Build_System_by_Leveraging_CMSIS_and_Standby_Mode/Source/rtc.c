@@ -1,4 +1,5 @@
 #include "rtc.h"
+#include "systick.h"
 
 // Macro to enable the clock for PWR (power controller) (bit 28 in RCC_APB1ENR)
 #define PWREN (1U << 28)
@@ -12,6 +13,21 @@
 // Macro to check whether the LSI is stable and ready to be used (bit 1 in RCC_CSR)
 #define CSR_LSIRDY (1U << 1)
 
+// Macro to enable the external low-speed oscillator (LSE) (bit 0 in RCC_BDCR)
+#define BDCR_LSEON (1U << 0)
+
+// Macro to check whether the LSE is stable and ready to be used (bit 1 in RCC_BDCR)
+#define BDCR_LSERDY (1U << 1)
+
+// Macro to select LSE as RTC clock source (RTCSEL[1:0] = 01, bits 9:8 in RCC_BDCR)
+#define BDCR_RTCSEL_LSE (1U << 8)
+
+// Macro to select LSI as RTC clock source (RTCSEL[1:0] = 10, bits 9:8 in RCC_BDCR)
+#define BDCR_RTCSEL_LSI (2U << 8)
+
+// Macro to mask the RTC clock source selection (bits 9:8 in RCC_BDCR)
+#define BDCR_RTCSEL_MASK (3U << 8)
+
 // Macro to force a software reset of the entire backup domain (bit 16 in RCC_BDCR)
 #define BDCR_BDRST (1U << 16)
 
@@ -36,6 +52,9 @@
 // Macro to set the hour format to 12-hour format (bit 6 in RTC_CR)
 #define CR_FMT (1U << 6)
 
+// Macro to check whether the calendar has been initialized (bit 4 in RTC_ISR)
+#define ISR_INITS (1U << 4)
+
 // Macro to check whether calendar shadow registers synchronized (bit 5 in RTC_ISR)
 #define ISR_RSF (1U << 5)
 
@@ -45,6 +64,18 @@
 // Macro to set the synchronous prescaler for the RTC peripheral
 #define RTC_SYNCH_PREDIV ((uint32_t)0x00F9)  // 249
 
+// Macro to set the asynchronous prescaler when the RTC runs from the 32.768 kHz LSE
+#define RTC_LSE_ASYNCH_PREDIV ((uint32_t)0x007F) // 127
+
+// Macro to set the synchronous prescaler when the RTC runs from the 32.768 kHz LSE
+#define RTC_LSE_SYNCH_PREDIV ((uint32_t)0x00FF)  // 255
+
+// Macro to define how long to wait for the LSE crystal to start (in ms)
+#define RTC_LSE_TIMEOUT_MS 2000U
+
+// Macro to define the value kept in RTC_BKP0R once the calendar has been configured
+#define RTC_BKP_MAGIC 0x32F2C0DEU
+
 static void rtc_set_asynchronous_prescaler(uint32_t Asynch_Prescaler);
 static void rtc_set_synchronous_prescaler(uint32_t Synch_Prescaler);
 static uint8_t rtc_initialization_sequence_enter(void);
@@ -52,6 +83,46 @@ static uint8_t wait_for_rtc_synchronization(void);
 static uint8_t rtc_initialization_sequence_exit(void);
 static void rtc_date_config(uint32_t WeekDay, uint32_t Day, uint32_t Month, uint32_t Year);
 static void rtc_time_config(uint32_t Format12_24, uint32_t Hours, uint32_t Minutes, uint32_t Seconds);
+static uint8_t rtc_lse_start(void);
+static void rtc_lsi_start(void);
+static uint8_t rtc_days_in_month(uint16_t year, uint8_t month);
+
+static uint8_t rtc_lse_start(void) {
+    // The LSE timeout counts SysTick milliseconds, which rtc_init() may run before anything else started
+    systick_init();
+
+    // Enable the external low-speed oscillator (LSE)
+    RCC->BDCR |= BDCR_LSEON;
+
+    // Wait until the crystal is stable, it may take up to a few hundred milliseconds or be missing altogether
+    deadline_t deadline = deadline_after_ms(RTC_LSE_TIMEOUT_MS);
+
+    while ((RCC->BDCR & BDCR_LSERDY) != BDCR_LSERDY) {
+        if (deadline_expired(deadline)) {
+            // Give up and switch the oscillator off again
+            RCC->BDCR &= ~BDCR_LSEON;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void rtc_lsi_start(void) {
+    // Enable the low-speed internal oscillator (LSI)
+    RCC->CSR |= CSR_LSION;
+
+    // Wait until the LSI oscillator is stable and ready to use
+    while ((RCC->CSR & (CSR_LSIRDY)) != CSR_LSIRDY) {
+    }
+}
+
+static uint8_t rtc_days_in_month(uint16_t year, uint8_t month) {
+    static const uint8_t days[12] = {31U, 28U, 31U, 30U, 31U, 30U, 31U, 31U, 30U, 31U, 30U, 31U};
+
+    // Every fourth year from 2000 to 2099 is a leap year
+    return (uint8_t)(days[month - 1U] + (((month == 2U) && ((year & 3U) == 0U)) ? 1U : 0U));
+}
 
 static void rtc_set_asynchronous_prescaler(uint32_t Asynch_Prescaler) {
     MODIFY_REG(RTC->PRER, RTC_PRER_PREDIV_A, Asynch_Prescaler << RTC_PRER_PREDIV_A_Pos);
@@ -134,6 +205,18 @@ uint8_t is_rtc_synchronized(void) {
 	return ((RTC->ISR & (ISR_RSF)) == ISR_RSF);
 }
 
+void rtc_wait_synchronized(void) {
+    // RSF can only be cleared with the write protection disabled
+    RTC->WPR = RTC_WRITE_PROTECTION_KEY_1;
+    RTC->WPR = RTC_WRITE_PROTECTION_KEY_2;
+
+    // The next copy of the calendar into the shadow registers sets RSF again (up to two RTCCLK periods)
+    wait_for_rtc_synchronization();
+
+    // Re-enable write protection on the RTC registers
+    RTC->WPR = (uint8_t)0xFF;
+}
+
 void rtc_init(void) {
 	// Enable the clock access to PWR
     RCC->APB1ENR |= PWREN;
@@ -141,11 +224,16 @@ void rtc_init(void) {
     // Enable write access to RTC and RTC backup registers
     PWR->CR |= CR_DBP;
 
-    // Enable the low-speed internal oscillator (LSI)
-    RCC->CSR |= CSR_LSION;
+    // The backup domain survives resets and standby: keep the running calendar untouched
+    if (rtc_is_running()) {
+        // A system reset stops the LSI, restart it if the RTC is clocked from it
+        if ((RCC->BDCR & BDCR_RTCSEL_MASK) == BDCR_RTCSEL_LSI) {
+            rtc_lsi_start();
+        }
 
-    // Wait until the LSI oscillator is stable and ready to use
-    while ((RCC->CSR & (CSR_LSIRDY)) != CSR_LSIRDY) {
+        // Shadow registers are not valid after a reset or a standby wake-up until RSF is set again
+        rtc_wait_synchronized();
+        return;
     }
 
     // Force a software reset of the backup domain to ensure a clean configuration
@@ -154,9 +242,20 @@ void rtc_init(void) {
     // Release the reset to allow the backup domain to function normally
     RCC->BDCR &= ~BDCR_BDRST;
 
-    // Set the clock source for the RTC peripheral to LSI
-    RCC->BDCR &= ~(1U << 8);
-    RCC->BDCR |= (1U << 9);
+    uint32_t asynch_prediv;
+    uint32_t synch_prediv;
+
+    // Prefer the 32.768 kHz crystal, fall back to the LSI (~32 kHz) when it does not start
+    if (rtc_lse_start()) {
+        RCC->BDCR |= BDCR_RTCSEL_LSE;
+        asynch_prediv = RTC_LSE_ASYNCH_PREDIV;
+        synch_prediv = RTC_LSE_SYNCH_PREDIV;
+    } else {
+        rtc_lsi_start();
+        RCC->BDCR |= BDCR_RTCSEL_LSI;
+        asynch_prediv = RTC_ASYNCH_PREDIV;
+        synch_prediv = RTC_SYNCH_PREDIV;
+    }
 
     // Enable the RTC peripheral
     RCC->BDCR |= BDCR_RTCEN;
@@ -181,15 +280,140 @@ void rtc_init(void) {
     // Configure the RTC peripheral so that it uses a 12-hour format
     RTC->CR |= CR_FMT;
 
-    // Set the asynchronous and synchronous prescaler values
-    rtc_set_asynchronous_prescaler(RTC_ASYNCH_PREDIV);
-    rtc_set_synchronous_prescaler(RTC_SYNCH_PREDIV);
+    // Set the asynchronous and synchronous prescaler values for a 1 Hz calendar clock
+    rtc_set_asynchronous_prescaler(asynch_prediv);
+    rtc_set_synchronous_prescaler(synch_prediv);
 
     // Exit the initialization mode
     rtc_initialization_sequence_exit();
 
     // Re-enable write protection on the RTC registers to prevent accidental changes
     RTC->WPR = (uint8_t)0xFF;
+
+    // Mark the calendar as configured for the next boot
+    RTC->BKP0R = RTC_BKP_MAGIC;
+}
+
+uint8_t rtc_is_running(void) {
+    // The magic value is only written after a complete configuration and the calendar must have been initialized
+    return ((RTC->BKP0R == RTC_BKP_MAGIC) && ((RCC->BDCR & BDCR_RTCEN) == BDCR_RTCEN) &&
+            ((RTC->ISR & ISR_INITS) == ISR_INITS));
+}
+
+rtc_clock_source_t rtc_get_clock_source(void) {
+    switch (RCC->BDCR & BDCR_RTCSEL_MASK) {
+    case BDCR_RTCSEL_LSE:
+        return RTC_CLOCK_LSE;
+    case BDCR_RTCSEL_LSI:
+        return RTC_CLOCK_LSI;
+    default:
+        return RTC_CLOCK_NONE;
+    }
+}
+
+uint8_t rtc_set_datetime(const rtc_snapshot_t *datetime) {
+    uint8_t hour = datetime->hour;
+    uint32_t format = 0;
+
+    if ((datetime->year < 2000U) || (datetime->year > 2099U) || (datetime->month < 1U) || (datetime->month > 12U) ||
+        (datetime->day < 1U) || (datetime->day > rtc_days_in_month(datetime->year, datetime->month)) ||
+        (datetime->hour > 23U) || (datetime->minute > 59U) || (datetime->second > 59U)) {
+        return 0;
+    }
+
+    // Keep the hour format of the calendar, in 12-hour mode 0 is 12 AM and 12 is 12 PM
+    if (RTC->CR & CR_FMT) {
+        format = (hour >= 12U) ? TIME_FORMAT_PM : 0U;
+        hour = (uint8_t)(hour % 12U);
+
+        if (hour == 0U) {
+            hour = 12U;
+        }
+    }
+
+    // Derive the week day from the date so callers cannot get it wrong
+    uint32_t days = rtc_to_epoch(datetime->year, datetime->month, datetime->day, 0U, 0U, 0U) / 86400U;
+    uint32_t weekday = ((days + 3U) % 7U) + 1U;
+
+    // Disable the write protection of RTC registers
+    RTC->WPR = RTC_WRITE_PROTECTION_KEY_1;
+    RTC->WPR = RTC_WRITE_PROTECTION_KEY_2;
+
+    rtc_initialization_sequence_enter();
+
+    rtc_date_config(weekday, rtc_convert_dec2bcd(datetime->day), rtc_convert_dec2bcd(datetime->month),
+                    rtc_convert_dec2bcd((uint8_t)(datetime->year - 2000U)));
+    rtc_time_config(format, rtc_convert_dec2bcd(hour), rtc_convert_dec2bcd(datetime->minute),
+                    rtc_convert_dec2bcd(datetime->second));
+
+    rtc_initialization_sequence_exit();
+
+    // Re-enable write protection on the RTC registers to prevent accidental changes
+    RTC->WPR = (uint8_t)0xFF;
+
+    return 1;
+}
+
+uint8_t rtc_parse_datetime(const char *command, rtc_snapshot_t *datetime) {
+    // Accepted formats: "YYYY-MM-DD HH:MM:SS" or "YYYY-MM-DDTHH:MM:SS", optionally preceded by "SET "
+    static const char layout[] = "dddd-dd-dd?dd:dd:dd";
+    uint32_t fields[6] = {0};
+    uint32_t field = 0;
+
+    if ((command[0] == 'S') && (command[1] == 'E') && (command[2] == 'T') && (command[3] == ' ')) {
+        command += 4;
+    }
+
+    for (uint32_t i = 0; layout[i] != '\0'; i++) {
+        char c = command[i];
+
+        if (layout[i] == 'd') {
+            if ((c < '0') || (c > '9')) {
+                return 0;
+            }
+
+            fields[field] = (fields[field] * 10U) + (uint32_t)(c - '0');
+        } else if (layout[i] == '?') {
+            if ((c != ' ') && (c != 'T')) {
+                return 0;
+            }
+
+            field++;
+        } else {
+            if (c != layout[i]) {
+                return 0;
+            }
+
+            field++;
+        }
+    }
+
+    // Tolerate a trailing line ending from a terminal
+    char end = command[sizeof(layout) - 1U];
+
+    if ((end != '\0') && (end != '\r') && (end != '\n')) {
+        return 0;
+    }
+
+    datetime->year = (uint16_t)fields[0];
+    datetime->month = (uint8_t)fields[1];
+    datetime->day = (uint8_t)fields[2];
+    datetime->hour = (uint8_t)fields[3];
+    datetime->minute = (uint8_t)fields[4];
+    datetime->second = (uint8_t)fields[5];
+    datetime->millisecond = 0;
+
+    return 1;
+}
+
+uint8_t rtc_set_from_command(const char *command) {
+    rtc_snapshot_t datetime;
+
+    if (!rtc_parse_datetime(command, &datetime)) {
+        return 0;
+    }
+
+    return rtc_set_datetime(&datetime);
 }
 
 uint8_t rtc_convert_dec2bcd(uint8_t decimal_value) {
@@ -247,3 +471,109 @@ uint8_t rtc_time_get_current_hour(void) {
         return hour;
     }
 }
+
+// Macro to define one row of the BCD lookup table: ten valid codes followed by six invalid ones
+#define BCD_ROW(tens) (tens) * 10U + 0U, (tens) * 10U + 1U, (tens) * 10U + 2U, (tens) * 10U + 3U, \
+                      (tens) * 10U + 4U, (tens) * 10U + 5U, (tens) * 10U + 6U, (tens) * 10U + 7U, \
+                      (tens) * 10U + 8U, (tens) * 10U + 9U, 0U, 0U, 0U, 0U, 0U, 0U
+
+// Macro to define the number of days from 1970-01-01 to 2000-01-01
+#define RTC_EPOCH_DAYS_2000 10957U
+
+// Binary value of every two-digit BCD code
+static const uint8_t bcd2bin_lut[256] = {
+    BCD_ROW(0U), BCD_ROW(1U), BCD_ROW(2U), BCD_ROW(3U), BCD_ROW(4U), BCD_ROW(5U), BCD_ROW(6U), BCD_ROW(7U),
+    BCD_ROW(8U), BCD_ROW(9U), BCD_ROW(0U), BCD_ROW(0U), BCD_ROW(0U), BCD_ROW(0U), BCD_ROW(0U), BCD_ROW(0U)
+};
+
+// Days before the first day of each month in a non-leap year
+static const uint16_t days_before_month[12] = {
+    0U, 31U, 59U, 90U, 120U, 151U, 181U, 212U, 243U, 273U, 304U, 334U
+};
+
+uint32_t rtc_to_epoch(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+    uint32_t y = (uint32_t)year - 2000U;
+
+    // Every fourth year from 2000 to 2099 is a leap year, so (y + 3) / 4 leap days precede year y
+    // and the leap day of year y itself counts from March on
+    uint32_t leap = (uint32_t)((y & 3U) == 0U) & (uint32_t)(month > 2U);
+    uint32_t days = RTC_EPOCH_DAYS_2000 + (y * 365U) + ((y + 3U) >> 2) +
+                    days_before_month[(month - 1U) % 12U] + leap + (uint32_t)day - 1U;
+
+    return (days * 86400U) + ((uint32_t)hour * 3600U) + ((uint32_t)minute * 60U) + second;
+}
+
+void rtc_from_epoch(uint32_t epoch, rtc_snapshot_t *datetime) {
+    uint32_t days = epoch / 86400U;
+    uint32_t seconds = epoch % 86400U;
+
+    datetime->hour = (uint8_t)(seconds / 3600U);
+    datetime->minute = (uint8_t)((seconds / 60U) % 60U);
+    datetime->second = (uint8_t)(seconds % 60U);
+    datetime->millisecond = 0;
+    datetime->epoch = epoch;
+
+    // 1970-01-01 was a Thursday (4), week days run from 1 (Monday) to 7 (Sunday)
+    datetime->weekday = (uint8_t)(((days + 3U) % 7U) + 1U);
+
+    // Split the days since 2000 into 4-year blocks of 1461 days, each starting with a leap year
+    days -= RTC_EPOCH_DAYS_2000;
+
+    uint32_t year = (days / 1461U) * 4U;
+    uint32_t day_of_year = days % 1461U;
+    uint32_t leap = 1U;
+
+    if (day_of_year >= 366U) {
+        day_of_year -= 366U;
+        year += 1U + (day_of_year / 365U);
+        day_of_year %= 365U;
+        leap = 0U;
+    }
+
+    // Find the month, moving every day from March on back by one in a leap year
+    uint32_t month = 11U;
+
+    while ((days_before_month[month] + ((month >= 2U) ? leap : 0U)) > day_of_year) {
+        month--;
+    }
+
+    datetime->year = (uint16_t)(2000U + year);
+    datetime->month = (uint8_t)(month + 1U);
+    datetime->day = (uint8_t)(day_of_year - days_before_month[month] - ((month >= 2U) ? leap : 0U) + 1U);
+}
+
+void rtc_get_snapshot(rtc_snapshot_t *snapshot) {
+    // Reading SSR locks TR and DR in their shadow registers until DR is read, so the three reads below
+    // belong to the same second even if the calendar rolls over in between
+    uint32_t ssr = RTC->SSR;
+    uint32_t tr = RTC->TR;
+    uint32_t dr = RTC->DR;
+
+    // Decode the BCD fields with one table lookup each
+    uint8_t hour = bcd2bin_lut[(tr >> RTC_TR_HU_Pos) & 0x3FU];
+    snapshot->minute = bcd2bin_lut[(tr >> RTC_TR_MNU_Pos) & 0x7FU];
+    snapshot->second = bcd2bin_lut[(tr >> RTC_TR_SU_Pos) & 0x7FU];
+    snapshot->year = (uint16_t)(2000U + bcd2bin_lut[(dr >> RTC_DR_YU_Pos) & 0xFFU]);
+    snapshot->month = bcd2bin_lut[(dr >> RTC_DR_MU_Pos) & 0x1FU];
+    snapshot->day = bcd2bin_lut[(dr >> RTC_DR_DU_Pos) & 0x3FU];
+    snapshot->weekday = (uint8_t)((dr & RTC_DR_WDU) >> RTC_DR_WDU_Pos);
+
+    // In 12-hour mode map 12 AM to 0 and add 12 for PM hours (TR PM bit only set in 12-hour mode)
+    if (RTC->CR & CR_FMT) {
+        hour = (uint8_t)((hour % 12U) + ((tr & TIME_FORMAT_PM) ? 12U : 0U));
+    }
+
+    snapshot->hour = hour;
+
+    // The sub-second counter runs down from PREDIV_S to 0 once per second
+    uint32_t prediv_s = (RTC->PRER & RTC_PRER_PREDIV_S) >> RTC_PRER_PREDIV_S_Pos;
+
+    if (ssr > prediv_s) {
+        ssr = prediv_s;
+    }
+
+    snapshot->millisecond = (uint16_t)(((prediv_s - ssr) * 1000U) / (prediv_s + 1U));
+
+    snapshot->epoch = rtc_to_epoch(snapshot->year, snapshot->month, snapshot->day,
+                                   snapshot->hour, snapshot->minute, snapshot->second);
+}
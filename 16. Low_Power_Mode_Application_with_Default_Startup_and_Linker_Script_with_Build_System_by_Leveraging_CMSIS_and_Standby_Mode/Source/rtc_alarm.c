@@ -0,0 +1,421 @@
+#include <stddef.h>
+#include "rtc_alarm.h"
+#include "rtc.h"
+#include "irq.h"
+
+/* RTC periodic wakeup timer, hardware alarms and logical alarm scheduler
+ * The wakeup timer reaches the NVIC through EXTI line 22 and the alarms through EXTI line 17, both
+ * rising edge, so they also wake the MCU from Stop mode. Alarm A is owned by the scheduler, which
+ * keeps it programmed for the earliest logical alarm; alarm B stays available to the application.
+ * rtc_init() must have been called first.
+ */
+
+// Macro to disable write protection on the RTC registers (the first key)
+#define RTC_WRITE_PROTECTION_KEY_1 ((uint8_t)0xCAU)
+
+// Macro to disable write protection on the RTC registers (the second key)
+#define RTC_WRITE_PROTECTION_KEY_2 ((uint8_t)0x53U)
+
+// Macro to check whether the alarm A registers can be written (bit 0 in RTC_ISR)
+#define ISR_ALRAWF (1U << 0)
+
+// Macro to check whether the alarm B registers can be written (bit 1 in RTC_ISR)
+#define ISR_ALRBWF (1U << 1)
+
+// Macro to check whether the wakeup timer registers can be written (bit 2 in RTC_ISR)
+#define ISR_WUTWF (1U << 2)
+
+// Macro to keep the initialization mode bit when clearing flags (bit 7 in RTC_ISR)
+#define ISR_INIT (1U << 7)
+
+// Macro to check whether alarm A matched (bit 8 in RTC_ISR)
+#define ISR_ALRAF (1U << 8)
+
+// Macro to check whether alarm B matched (bit 9 in RTC_ISR)
+#define ISR_ALRBF (1U << 9)
+
+// Macro to check whether the wakeup timer expired (bit 10 in RTC_ISR)
+#define ISR_WUTF (1U << 10)
+
+// Macro to mask the wakeup clock selection (bits 2:0 in RTC_CR)
+#define CR_WUCKSEL_MASK (7U << 0)
+
+// Macro to select ck_spre (1 Hz) as wakeup clock (WUCKSEL = 100)
+#define CR_WUCKSEL_SPRE (4U << 0)
+
+// Macro to select ck_spre with 2^16 added to the counter (WUCKSEL = 11x)
+#define CR_WUCKSEL_SPRE_EXT (6U << 0)
+
+// Macro to check the hour format, 1 = 12-hour (bit 6 in RTC_CR)
+#define CR_FMT (1U << 6)
+
+// Macro to enable alarm A (bit 8 in RTC_CR)
+#define CR_ALRAE (1U << 8)
+
+// Macro to enable alarm B (bit 9 in RTC_CR)
+#define CR_ALRBE (1U << 9)
+
+// Macro to enable the wakeup timer (bit 10 in RTC_CR)
+#define CR_WUTE (1U << 10)
+
+// Macro to enable the alarm A interrupt (bit 12 in RTC_CR)
+#define CR_ALRAIE (1U << 12)
+
+// Macro to enable the alarm B interrupt (bit 13 in RTC_CR)
+#define CR_ALRBIE (1U << 13)
+
+// Macro to enable the wakeup timer interrupt (bit 14 in RTC_CR)
+#define CR_WUTIE (1U << 14)
+
+// Macro to ignore the date/week day field of an alarm (bit 31 in RTC_ALRMxR)
+#define ALRM_MSK4 (1U << 31)
+
+// Macro to mark a PM hour in 12-hour format (bit 22 in RTC_ALRMxR)
+#define ALRM_PM (1U << 22)
+
+// Macro to define the EXTI line of the RTC alarms
+#define EXTI_LINE_ALARM (1U << 17)
+
+// Macro to define the EXTI line of the RTC wakeup timer
+#define EXTI_LINE_WAKEUP (1U << 22)
+
+// Macro to define the largest step the scheduler programs into alarm A (the alarm only matches day of month)
+#define RTC_SCHED_MAX_STEP_S (27U * 86400U)
+
+// Logical alarm of the scheduler
+typedef struct {
+    uint32_t due;                  // Epoch second at which the alarm is due
+    uint32_t period;               // Reload period in seconds, 0 for a one-shot alarm
+    rtc_sched_callback_t callback; // Function called when the alarm is due
+    void *arg;                     // Argument passed to the callback
+    uint8_t active;                // 1 while the alarm is scheduled
+} rtc_sched_entry_t;
+
+static rtc_event_callback_t wakeup_callback;
+static rtc_event_callback_t alarm_callbacks[2];
+
+static rtc_sched_entry_t sched_entries[RTC_SCHED_MAX_ALARMS];
+static volatile uint8_t sched_alarm_pending;
+
+static void rtc_write_protection_disable(void);
+static void rtc_write_protection_enable(void);
+static void rtc_clear_flag(uint32_t flag);
+static void rtc_exti_enable(uint32_t line, IRQn_Type irq);
+static void rtc_sched_alarm_handler(void);
+static void rtc_sched_reprogram(uint32_t now);
+
+static void rtc_write_protection_disable(void) {
+    RTC->WPR = RTC_WRITE_PROTECTION_KEY_1;
+    RTC->WPR = RTC_WRITE_PROTECTION_KEY_2;
+}
+
+static void rtc_write_protection_enable(void) {
+    RTC->WPR = (uint8_t)0xFF;
+}
+
+static void rtc_clear_flag(uint32_t flag) {
+    // Flags are cleared by writing 0, write 1 to all others (except INIT, which must keep its value)
+    RTC->ISR = (~(flag | ISR_INIT)) | (RTC->ISR & ISR_INIT);
+}
+
+static void rtc_exti_enable(uint32_t line, IRQn_Type irq) {
+    // Unmask the line and trigger on the rising edge of the RTC event
+    EXTI->IMR |= line;
+    EXTI->RTSR |= line;
+    EXTI->FTSR &= ~line;
+
+    irq_enable(irq);
+}
+
+uint8_t rtc_wakeup_start(uint64_t period_us, rtc_event_callback_t callback) {
+    uint32_t rtc_clk = (rtc_get_clock_source() == RTC_CLOCK_LSE) ? 32768U : 32000U;
+    uint32_t wucksel;
+    uint32_t wut;
+
+    // Sub-second periods use RTCCLK/2 to RTCCLK/16, pick the smallest divider that fits 16 bits for the best resolution
+    uint64_t ticks = 0;
+    uint32_t div = 2U;
+
+    for (wucksel = 3U; div <= 16U; div <<= 1, wucksel--) {
+        ticks = ((period_us * rtc_clk) + ((uint64_t)div * 500000U)) / ((uint64_t)div * 1000000U);
+
+        if (ticks <= 65536U) {
+            break;
+        }
+    }
+
+    if (div <= 16U) {
+        if (ticks == 0U) {
+            return 0;
+        }
+
+        wut = (uint32_t)ticks - 1U;
+    } else {
+        // Longer periods count seconds of ck_spre, up to 2^17 s (~36 h) with the extended range
+        uint64_t seconds = (period_us + 500000U) / 1000000U;
+
+        if (seconds <= 65536U) {
+            wucksel = CR_WUCKSEL_SPRE;
+            wut = (uint32_t)seconds - 1U;
+        } else if (seconds <= 131072U) {
+            wucksel = CR_WUCKSEL_SPRE_EXT;
+            wut = (uint32_t)seconds - 1U - 65536U;
+        } else {
+            return 0;
+        }
+    }
+
+    wakeup_callback = callback;
+
+    rtc_write_protection_disable();
+
+    // Stop the wakeup timer and wait until its registers can be written
+    RTC->CR &= ~(CR_WUTE | CR_WUTIE);
+
+    while ((RTC->ISR & ISR_WUTWF) != ISR_WUTWF) {
+    }
+
+    // The wakeup flag is raised every (WUT + 1) clock periods
+    RTC->WUTR = wut;
+    RTC->CR = (RTC->CR & ~CR_WUCKSEL_MASK) | wucksel;
+
+    rtc_clear_flag(ISR_WUTF);
+    EXTI->PR = EXTI_LINE_WAKEUP;
+
+    RTC->CR |= (CR_WUTIE | CR_WUTE);
+
+    rtc_write_protection_enable();
+
+    rtc_exti_enable(EXTI_LINE_WAKEUP, RTC_WKUP_IRQn);
+
+    return 1;
+}
+
+void rtc_wakeup_stop(void) {
+    rtc_write_protection_disable();
+    RTC->CR &= ~(CR_WUTE | CR_WUTIE);
+    rtc_write_protection_enable();
+
+    rtc_clear_flag(ISR_WUTF);
+    EXTI->PR = EXTI_LINE_WAKEUP;
+}
+
+uint8_t rtc_alarm_set(rtc_alarm_t alarm, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second,
+                      rtc_event_callback_t callback) {
+    if ((day > 31U) || (hour > 23U) || (minute > 59U) || (second > 59U)) {
+        return 0;
+    }
+
+    uint32_t value = 0;
+
+    // In 12-hour format the alarm hour is 1 to 12 with a PM flag, like the time register
+    if (RTC->CR & CR_FMT) {
+        if (hour >= 12U) {
+            value |= ALRM_PM;
+        }
+
+        hour = (uint8_t)(hour % 12U);
+
+        if (hour == 0U) {
+            hour = 12U;
+        }
+    }
+
+    // Match on day of month, hours, minutes and seconds (BCD), or on the time only
+    if (day == RTC_ALARM_ANY_DAY) {
+        value |= ALRM_MSK4;
+    } else {
+        value |= ((uint32_t)rtc_convert_dec2bcd(day) << RTC_ALRMAR_DU_Pos);
+    }
+
+    value |= ((uint32_t)rtc_convert_dec2bcd(hour) << RTC_ALRMAR_HU_Pos) |
+             ((uint32_t)rtc_convert_dec2bcd(minute) << RTC_ALRMAR_MNU_Pos) |
+             ((uint32_t)rtc_convert_dec2bcd(second) << RTC_ALRMAR_SU_Pos);
+
+    uint32_t enable = (alarm == RTC_ALARM_A) ? CR_ALRAE : CR_ALRBE;
+    uint32_t enable_irq = (alarm == RTC_ALARM_A) ? CR_ALRAIE : CR_ALRBIE;
+    uint32_t write_flag = (alarm == RTC_ALARM_A) ? ISR_ALRAWF : ISR_ALRBWF;
+
+    alarm_callbacks[alarm] = callback;
+
+    rtc_write_protection_disable();
+
+    // Stop the alarm and wait until its registers can be written
+    RTC->CR &= ~(enable | enable_irq);
+
+    while ((RTC->ISR & write_flag) != write_flag) {
+    }
+
+    // Sub-seconds are not compared (MASKSS = 0)
+    if (alarm == RTC_ALARM_A) {
+        RTC->ALRMAR = value;
+        RTC->ALRMASSR = 0;
+    } else {
+        RTC->ALRMBR = value;
+        RTC->ALRMBSSR = 0;
+    }
+
+    rtc_clear_flag((alarm == RTC_ALARM_A) ? ISR_ALRAF : ISR_ALRBF);
+
+    RTC->CR |= (enable | enable_irq);
+
+    rtc_write_protection_enable();
+
+    rtc_exti_enable(EXTI_LINE_ALARM, RTC_Alarm_IRQn);
+
+    return 1;
+}
+
+void rtc_alarm_disable(rtc_alarm_t alarm) {
+    uint32_t enable = (alarm == RTC_ALARM_A) ? (CR_ALRAE | CR_ALRAIE) : (CR_ALRBE | CR_ALRBIE);
+
+    rtc_write_protection_disable();
+    RTC->CR &= ~enable;
+    rtc_write_protection_enable();
+
+    rtc_clear_flag((alarm == RTC_ALARM_A) ? ISR_ALRAF : ISR_ALRBF);
+}
+
+int8_t rtc_sched_add(uint32_t due_epoch, uint32_t period_s, rtc_sched_callback_t callback, void *arg) {
+    if (callback == NULL) {
+        return RTC_SCHED_INVALID_ALARM;
+    }
+
+    for (uint32_t i = 0; i < RTC_SCHED_MAX_ALARMS; i++) {
+        if (!sched_entries[i].active) {
+            sched_entries[i].due = due_epoch;
+            sched_entries[i].period = period_s;
+            sched_entries[i].callback = callback;
+            sched_entries[i].arg = arg;
+            sched_entries[i].active = 1;
+
+            // The new alarm may be the earliest one, let the next processing pass reprogram alarm A
+            sched_alarm_pending = 1;
+
+            return (int8_t)i;
+        }
+    }
+
+    return RTC_SCHED_INVALID_ALARM;
+}
+
+uint8_t rtc_sched_cancel(int8_t id) {
+    if ((id < 0) || ((uint32_t)id >= RTC_SCHED_MAX_ALARMS) || (!sched_entries[id].active)) {
+        return 0;
+    }
+
+    sched_entries[id].active = 0;
+    sched_alarm_pending = 1;
+
+    return 1;
+}
+
+uint32_t rtc_sched_process(void) {
+    uint32_t expired = 0;
+
+    if (!sched_alarm_pending) {
+        return 0;
+    }
+
+    sched_alarm_pending = 0;
+
+    rtc_snapshot_t now;
+    rtc_get_snapshot(&now);
+
+    // Run every alarm that is due, in thread context
+    for (uint32_t i = 0; i < RTC_SCHED_MAX_ALARMS; i++) {
+        rtc_sched_entry_t *entry = &sched_entries[i];
+
+        if ((!entry->active) || (entry->due > now.epoch)) {
+            continue;
+        }
+
+        if (entry->period != 0U) {
+            // Stay on the original grid, skipping periods that were missed
+            do {
+                entry->due += entry->period;
+            } while (entry->due <= now.epoch);
+        } else {
+            entry->active = 0;
+        }
+
+        entry->callback(entry->arg);
+        expired++;
+    }
+
+    rtc_sched_reprogram(now.epoch);
+
+    return expired;
+}
+
+static void rtc_sched_reprogram(uint32_t now) {
+    uint32_t next = 0;
+    uint8_t found = 0;
+
+    // Find the earliest active alarm
+    for (uint32_t i = 0; i < RTC_SCHED_MAX_ALARMS; i++) {
+        if (sched_entries[i].active && ((!found) || (sched_entries[i].due < next))) {
+            next = sched_entries[i].due;
+            found = 1;
+        }
+    }
+
+    if (!found) {
+        rtc_alarm_disable(RTC_ALARM_A);
+        return;
+    }
+
+    // An alarm that became due meanwhile is handled by the next processing pass right away
+    if (next <= now) {
+        sched_alarm_pending = 1;
+        return;
+    }
+
+    // The hardware alarm compares the day of month only, so far targets are reached in steps
+    if ((next - now) > RTC_SCHED_MAX_STEP_S) {
+        next = now + RTC_SCHED_MAX_STEP_S;
+    }
+
+    rtc_snapshot_t at;
+    rtc_from_epoch(next, &at);
+
+    rtc_alarm_set(RTC_ALARM_A, at.day, at.hour, at.minute, at.second, rtc_sched_alarm_handler);
+}
+
+static void rtc_sched_alarm_handler(void) {
+    // Defer the callbacks to rtc_sched_process()
+    sched_alarm_pending = 1;
+}
+
+void RTC_WKUP_IRQHandler(void) {
+    if (RTC->ISR & ISR_WUTF) {
+        // Clear the RTC flag and the EXTI pending bit
+        rtc_clear_flag(ISR_WUTF);
+        EXTI->PR = EXTI_LINE_WAKEUP;
+
+        if (wakeup_callback != NULL) {
+            wakeup_callback();
+        }
+    }
+}
+
+void RTC_Alarm_IRQHandler(void) {
+    // Clear the EXTI pending bit first, both alarms share the line
+    EXTI->PR = EXTI_LINE_ALARM;
+
+    if (RTC->ISR & ISR_ALRAF) {
+        rtc_clear_flag(ISR_ALRAF);
+
+        if (alarm_callbacks[RTC_ALARM_A] != NULL) {
+            alarm_callbacks[RTC_ALARM_A]();
+        }
+    }
+
+    if (RTC->ISR & ISR_ALRBF) {
+        rtc_clear_flag(ISR_ALRBF);
+
+        if (alarm_callbacks[RTC_ALARM_B] != NULL) {
+            alarm_callbacks[RTC_ALARM_B]();
+        }
+    }
+}
@@ -0,0 +1,279 @@
+#include <stddef.h>
+#include "soft_timer.h"
+#include "systick.h"
+
+/* Hashed timer wheel driven by the SysTick time base
+ * A timer that expires at tick T is kept in the doubly linked list of slot T % SOFT_TIMER_WHEEL_SLOTS,
+ * so starting and cancelling a timer are O(1). The SysTick interrupt only advances the tick counter;
+ * soft_timer_process() catches the wheel up with it from the main loop and runs the callbacks there
+ * (deferred context), so callbacks may use blocking drivers and no interrupt masking is needed.
+ * All timers live in a static pool, nothing is allocated from the heap.
+ *
+ * The API is meant to be used from thread context only (not from interrupt handlers).
+ */
+
+#if (SOFT_TIMER_WHEEL_SLOTS & (SOFT_TIMER_WHEEL_SLOTS - 1U)) != 0U
+#error "SOFT_TIMER_WHEEL_SLOTS must be a power of two"
+#endif
+
+#if SOFT_TIMER_POOL_SIZE > 0xFFFFU
+#error "SOFT_TIMER_POOL_SIZE must fit a 16-bit index"
+#endif
+
+// Macro to select the wheel slot of an expiry tick
+#define SLOT_OF(tick) ((tick) & (SOFT_TIMER_WHEEL_SLOTS - 1U))
+
+// Macro to mark the end of a list
+#define NIL 0xFFFFU
+
+// Macro to build a timer handle from its generation and pool index
+#define MAKE_ID(gen, index) ((((uint32_t)(gen)) << 16) | ((uint32_t)(index) + 1U))
+
+// Pool entry of a timer
+typedef struct {
+    uint32_t expiry;                // Tick at which the timer expires
+    uint32_t period;                // Reload period in ticks, 0 for a one-shot timer
+    soft_timer_callback_t callback; // Function called on expiry
+    void *arg;                      // Argument passed to the callback
+    uint16_t next;                  // Next entry in the slot list (or in the free list)
+    uint16_t prev;                  // Previous entry in the slot list
+    uint16_t gen;                   // Generation, incremented each time the entry is released
+    uint8_t active;                 // 1 while the timer is linked in the wheel
+} soft_timer_entry_t;
+
+static soft_timer_entry_t pool[SOFT_TIMER_POOL_SIZE];
+static uint16_t wheel[SOFT_TIMER_WHEEL_SLOTS];
+static uint16_t free_head;
+static uint32_t active_count;
+
+// Last tick for which the wheel has been processed
+static uint32_t wheel_now;
+
+// Set by soft_timer_init(), the slots are not valid lists before
+static uint8_t wheel_ready;
+
+static soft_timer_entry_t *soft_timer_lookup(soft_timer_id_t id);
+static void wheel_link(uint16_t index);
+static void wheel_unlink(uint16_t index);
+static void pool_release(uint16_t index);
+
+void soft_timer_init(void) {
+    // Make sure the time base is running
+    systick_init();
+
+    // Chain all entries into the free list
+    for (uint32_t i = 0; i < SOFT_TIMER_POOL_SIZE; i++) {
+        pool[i].next = (uint16_t)(i + 1U);
+        pool[i].active = 0;
+    }
+
+    pool[SOFT_TIMER_POOL_SIZE - 1U].next = NIL;
+    free_head = 0;
+
+    // Start with empty slots
+    for (uint32_t i = 0; i < SOFT_TIMER_WHEEL_SLOTS; i++) {
+        wheel[i] = NIL;
+    }
+
+    active_count = 0;
+    wheel_now = millis();
+    wheel_ready = 1;
+}
+
+soft_timer_id_t soft_timer_start(uint32_t delay_ms, uint32_t period_ms, soft_timer_callback_t callback, void *arg) {
+    if ((callback == NULL) || (free_head == NIL)) {
+        return SOFT_TIMER_INVALID;
+    }
+
+    // Take an entry from the free list
+    uint16_t index = free_head;
+    soft_timer_entry_t *timer = &pool[index];
+    free_head = timer->next;
+
+    // A timer never expires in a slot the wheel has already passed
+    uint32_t expiry = millis() + delay_ms;
+
+    if ((int32_t)(expiry - wheel_now) <= 0) {
+        expiry = wheel_now + 1U;
+    }
+
+    timer->expiry = expiry;
+    timer->period = period_ms;
+    timer->callback = callback;
+    timer->arg = arg;
+
+    wheel_link(index);
+
+    return MAKE_ID(timer->gen, index);
+}
+
+uint8_t soft_timer_cancel(soft_timer_id_t id) {
+    soft_timer_entry_t *timer = soft_timer_lookup(id);
+
+    if (timer == NULL) {
+        return 0;
+    }
+
+    uint16_t index = (uint16_t)(timer - pool);
+
+    wheel_unlink(index);
+    pool_release(index);
+
+    return 1;
+}
+
+uint8_t soft_timer_is_active(soft_timer_id_t id) {
+    return (soft_timer_lookup(id) != NULL);
+}
+
+uint32_t soft_timer_process(void) {
+    uint32_t now = millis();
+    uint32_t expired = 0;
+
+    // After a long pause a single revolution visits every slot once, which is enough to find all due timers
+    if ((now - wheel_now) > SOFT_TIMER_WHEEL_SLOTS) {
+        wheel_now = now - SOFT_TIMER_WHEEL_SLOTS;
+    }
+
+    while (wheel_now != now) {
+        wheel_now++;
+
+        uint16_t index = wheel[SLOT_OF(wheel_now)];
+
+        while (index != NIL) {
+            soft_timer_entry_t *timer = &pool[index];
+
+            // Fetch the successor first, the callback may start or cancel timers
+            uint16_t next = timer->next;
+
+            // Entries of later revolutions share the slot and are skipped
+            if ((int32_t)(timer->expiry - wheel_now) <= 0) {
+                soft_timer_callback_t callback = timer->callback;
+                void *arg = timer->arg;
+
+                wheel_unlink(index);
+
+                if (timer->period != 0U) {
+                    // Reload a periodic timer on its own grid, skipping periods that were missed
+                    do {
+                        timer->expiry += timer->period;
+                    } while ((int32_t)(timer->expiry - wheel_now) <= 0);
+
+                    wheel_link(index);
+                } else {
+                    pool_release(index);
+                }
+
+                callback(arg);
+                expired++;
+
+                // The callback may have released the successor, so restart the slot from its head
+                next = wheel[SLOT_OF(wheel_now)];
+            }
+
+            index = next;
+        }
+    }
+
+    return expired;
+}
+
+uint32_t soft_timer_get_active_count(void) {
+    return active_count;
+}
+
+uint32_t soft_timer_ms_until_next(uint32_t limit_ms) {
+    // Without soft_timer_init() no timer can be running
+    if (!wheel_ready) {
+        return limit_ms;
+    }
+
+    uint32_t now = millis();
+    uint32_t lag = now - wheel_now;
+    uint32_t nearest = limit_ms;
+
+    // Walk the slots in time order from the last processed tick, the wheel lags behind the tick counter
+    // until soft_timer_process() runs. A timer in the slot 'step' ticks ahead expires no earlier than
+    // that, so the walk ends once the slots are further away than the nearest timer found; timers of
+    // later revolutions only bound the result
+    for (uint32_t step = 1U; (step <= SOFT_TIMER_WHEEL_SLOTS) && ((int32_t)(step - lag) < (int32_t)nearest); step++) {
+        uint16_t index = wheel[SLOT_OF(wheel_now + step)];
+
+        while (index != NIL) {
+            int32_t remaining = (int32_t)(pool[index].expiry - now);
+
+            // Expired timers are waiting for soft_timer_process()
+            if (remaining <= 0) {
+                return 0;
+            }
+
+            if ((uint32_t)remaining < nearest) {
+                nearest = (uint32_t)remaining;
+            }
+
+            index = pool[index].next;
+        }
+    }
+
+    return nearest;
+}
+
+static soft_timer_entry_t *soft_timer_lookup(soft_timer_id_t id) {
+    uint32_t index = (id & 0xFFFFU) - 1U;
+
+    // Reject invalid handles and handles of timers that already expired or were cancelled
+    if ((id == SOFT_TIMER_INVALID) || (index >= SOFT_TIMER_POOL_SIZE)) {
+        return NULL;
+    }
+
+    soft_timer_entry_t *timer = &pool[index];
+
+    if ((!timer->active) || (timer->gen != (uint16_t)(id >> 16))) {
+        return NULL;
+    }
+
+    return timer;
+}
+
+static void wheel_link(uint16_t index) {
+    soft_timer_entry_t *timer = &pool[index];
+    uint16_t *head = &wheel[SLOT_OF(timer->expiry)];
+
+    // Insert at the head of the slot list
+    timer->prev = NIL;
+    timer->next = *head;
+
+    if (*head != NIL) {
+        pool[*head].prev = index;
+    }
+
+    *head = index;
+    timer->active = 1;
+    active_count++;
+}
+
+static void wheel_unlink(uint16_t index) {
+    soft_timer_entry_t *timer = &pool[index];
+
+    if (timer->prev != NIL) {
+        pool[timer->prev].next = timer->next;
+    } else {
+        wheel[SLOT_OF(timer->expiry)] = timer->next;
+    }
+
+    if (timer->next != NIL) {
+        pool[timer->next].prev = timer->prev;
+    }
+
+    timer->active = 0;
+    active_count--;
+}
+
+static void pool_release(uint16_t index) {
+    soft_timer_entry_t *timer = &pool[index];
+
+    // Invalidate all handles of this entry and return it to the free list
+    timer->gen++;
+    timer->next = free_head;
+    free_head = index;
+}
@@ -1,7 +1,15 @@
 #include "spi.h"
+#include "gpio_pin.h"
 
-// Macro to enable the clock for GPIOA (bit 0 in RCC_AHB1ENR)
-#define GPIOAEN (1U << 0)
+// PA5, PA6, PA7 are SPI1_SCK, SPI1_MISO, SPI1_MOSI (AF5) and PA9 is the software-driven SS output
+#define SPI1_PINS(X) \
+    X(5, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 5) \
+    X(6, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 5) \
+    X(7, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 5) \
+    X(9, GPIO_MODE_OUTPUT, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 0)
+
+// Macro to represent the SS line (GPIOA Pin 9)
+#define SS_PIN GPIO_PIN_MASK(9)
 
 // Macro to enable the clock for SPI1 (bit 12 in RCC_APB2ENR)
 #define SPI1EN (1U << 12)
@@ -15,41 +23,12 @@
 // Macro to represent the BSY (busy flag) bit (bit 7 in SPI_SR)
 #define SR_BSY (1U << 7)
 
+static const gpio_port_cfg_t spi1_pins = GPIO_PORT_CFG(A, SPI1_PINS);
+
 void spi1_gpioa_init(void) {
-	// Enable the clock access to GPIOA
-    RCC->AHB1ENR |= GPIOAEN;
-
-    // Configure GPIOA Pin 5, 6, 7 to operate in alternate function mode (MODERx[1:0] = 10)
-    // PA5
-    GPIOA->MODER &= ~(1U << 10);  // Set bit 10 to 0
-    GPIOA->MODER |= (1U << 11);   // Set bit 11 to 1
-    // PA6
-    GPIOA->MODER &= ~(1U << 12);  // Set bit 12 to 0
-    GPIOA->MODER |= (1U << 13);   // Set bit 13 to 1
-    // PA7
-    GPIOA->MODER &= ~(1U << 14);  // Set bit 14 to 0
-    GPIOA->MODER |= (1U << 15);   // Set bit 15 to 1
-
-    // Configure GPIOA Pin 9 as a general-purpose output pin (MODER9[1:0] = 01), which will be used for SS
-    GPIOA->MODER |= (1U << 18);   // Set bit 18 to 1
-    GPIOA->MODER &= ~(1U << 19);  // Set bit 19 to 0
-
-    // Set alternate function type to AF5
-    // PA5 (SPI1_SCK)
-    GPIOA->AFR[0] |= (1U << 20);
-    GPIOA->AFR[0] &= ~(1U << 21);
-    GPIOA->AFR[0] |= (1U << 22);
-    GPIOA->AFR[0] &= ~(1U << 23);
-    // PA6 (SPI1_MISO)
-    GPIOA->AFR[0] |= (1U << 24);
-    GPIOA->AFR[0] &= ~(1U << 25);
-    GPIOA->AFR[0] |= (1U << 26);
-    GPIOA->AFR[0] &= ~(1U << 27);
-    // PA7 (SPI1_MOSI)
-    GPIOA->AFR[0] |= (1U << 28);
-    GPIOA->AFR[0] &= ~(1U << 29);
-    GPIOA->AFR[0] |= (1U << 30);
-    GPIOA->AFR[0] &= ~(1U << 31);
+	// Enable the clock access to GPIOA, configure Pin 5, 6, 7 as SPI1 (alternate function mode, AF5)
+	// and Pin 9 as a general-purpose output pin, which will be used for SS
+    gpio_port_apply(&spi1_pins);
 }
 
 void spi1_config(void) {
@@ -130,10 +109,10 @@ void spi1_receive(uint8_t *data, uint32_t size) {
 
 void spi1_cs_enable(void) {
 	// Pull the SS line low to enable the slave device
-	GPIOA->ODR &= ~(1U << 9);
+	gpio_clear(GPIOA, SS_PIN);
 }
 
 void spi1_cs_disable(void) {
 	// Pull the SS line high to disable the slave device
-	GPIOA->ODR |= (1U << 9);
+	gpio_set(GPIOA, SS_PIN);
 }
@@ -6,8 +6,6 @@
 // Bit mask for wake-up pin (GPIOA Pin 0)
 #define WK_PIN (1U << 0)
 
-static void set_low_power_mode(uint32_t pwr_mode);
-
 void pa0_wakeup_pin_init(void) {
 	// Enable the clock access to GPIOA
     RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;
@@ -55,7 +53,7 @@ uint32_t get_pa0_wakeup_pin_state(void) {
 	return ((GPIOA->IDR & WK_PIN) == WK_PIN);
 }
 
-static void set_low_power_mode(uint32_t pwr_mode) {
+void set_low_power_mode(uint32_t pwr_mode) {
 	// Update the PWR_CR register, specifically targeting the bits related to different power modes
 	// such as PDDS (Power Down Deepsleep), LPDS (Low-Power	Deepsleep), FPDS (Flash Power Down in Stop Mode),
 	// LPLVDS (Low-Power Regulator in Low Voltage in Deepsleep), and MRLVDS (Main Regulator in Low Voltage in Deepsleep)
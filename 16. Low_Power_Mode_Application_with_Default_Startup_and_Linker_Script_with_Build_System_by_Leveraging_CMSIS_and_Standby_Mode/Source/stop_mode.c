@@ -0,0 +1,182 @@
+#include <stddef.h>
+#include "stop_mode.h"
+#include "standby_mode.h"
+#include "rtc.h"
+#include "rtc_alarm.h"
+#include "soft_timer.h"
+#include "systick.h"
+
+/* Tickless idle manager
+ * When the main loop has nothing to do, stop_mode_idle() asks the software timer wheel for the next
+ * deadline, programs the RTC wakeup timer for it and enters Stop mode. SRAM and registers are kept,
+ * so execution simply continues after WFI. The SysTick clock stops in Stop mode, so on wake-up the
+ * tick counter is advanced by the time slept and the clock tree that Stop mode reset to HSI is restored.
+ * stop_mode_sleep() takes the idle time from the caller instead, the kernel idle task passes the next
+ * task wake-up there.
+ */
+
+// Macro to set the SLEEPDEEP bit in the Cortex-M4 System Control Register (bit 2 in SCB_SCR)
+#define SCR_SLEEPDEEP (1U << 2)
+
+// Macro to clear the wake-up flag (bit 2 in PWR_CR)
+#define PWR_CR_CLEAR_WUF (1U << 2)
+
+// Macro to enable the HSE oscillator (bit 16 in RCC_CR)
+#define CR_HSEON (1U << 16)
+
+// Macro to check whether the HSE is ready (bit 17 in RCC_CR)
+#define CR_HSERDY (1U << 17)
+
+// Macro to enable the main PLL (bit 24 in RCC_CR)
+#define CR_PLLON (1U << 24)
+
+// Macro to check whether the main PLL is locked (bit 25 in RCC_CR)
+#define CR_PLLRDY (1U << 25)
+
+// Macro to mask the system clock switch (bits 1:0 in RCC_CFGR)
+#define CFGR_SW_MASK (3U << 0)
+
+// Macro to mask the system clock switch status (bits 3:2 in RCC_CFGR)
+#define CFGR_SWS_MASK (3U << 2)
+
+static uint32_t stop_pwr_mode;
+static stop_mode_stats_t stop_stats;
+
+static uint64_t stop_mode_rtc_ms(void);
+static void stop_mode_restore_clocks(uint32_t rcc_cr, uint32_t rcc_cfgr);
+
+void stop_mode_init(uint32_t pwr_mode) {
+    // The RTC keeps running in Stop mode and provides the wake-up
+    rtc_init();
+
+    // Keep only the Stop mode options, Standby (PDDS) would lose SRAM
+    stop_pwr_mode = pwr_mode & ~PWR_CR_PDDS;
+}
+
+void stop_mode_idle(void) {
+    stop_mode_idle_limit(STOP_MODE_MAX_SLEEP_MS);
+}
+
+void stop_mode_idle_limit(uint32_t limit_ms) {
+    // Decide with interrupts masked, so an interrupt cannot add work between the check and WFI;
+    // a pending interrupt still ends WFI and is taken once PRIMASK is cleared again
+    __disable_irq();
+
+    stop_mode_sleep(soft_timer_ms_until_next((limit_ms < STOP_MODE_MAX_SLEEP_MS) ? limit_ms : STOP_MODE_MAX_SLEEP_MS));
+}
+
+void stop_mode_sleep(uint32_t sleep_ms) {
+    // Called with interrupts masked, 0 means there is work pending and returns at once
+    __disable_irq();
+
+    if (sleep_ms > STOP_MODE_MAX_SLEEP_MS) {
+        sleep_ms = STOP_MODE_MAX_SLEEP_MS;
+    }
+
+    if (sleep_ms < STOP_MODE_MIN_SLEEP_MS) {
+        // Too short to pay for the Stop mode wake-up, just stop the CPU clock until the next interrupt
+        if (sleep_ms != 0U) {
+            stop_stats.sleep_entries++;
+            __DSB();
+            __WFI();
+        }
+
+        __enable_irq();
+        return;
+    }
+
+    // Remember the clock tree, Stop mode falls back to the HSI
+    uint32_t rcc_cr = RCC->CR;
+    uint32_t rcc_cfgr = RCC->CFGR;
+
+    // Wake up through the RTC for the next timer deadline, without a wakeup timer only Sleep mode is safe
+    if (!rtc_wakeup_start((uint64_t)sleep_ms * 1000U, NULL)) {
+        stop_stats.sleep_entries++;
+        __DSB();
+        __WFI();
+        __enable_irq();
+        return;
+    }
+
+    uint64_t rtc_before = stop_mode_rtc_ms();
+
+    // Select Stop mode with the requested regulator and flash options and clear a stale wake-up flag
+    set_low_power_mode(stop_pwr_mode);
+    PWR->CR |= PWR_CR_CLEAR_WUF;
+
+    // SysTick would end the Stop mode immediately, stop it until the tick counter has been compensated
+    SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+
+    SCB->SCR |= SCR_SLEEPDEEP;
+    __DSB();
+    __WFI();
+    SCB->SCR &= ~SCR_SLEEPDEEP;
+
+    stop_mode_restore_clocks(rcc_cr, rcc_cfgr);
+
+    // The wake-up flag is still pending while PRIMASK is set
+    uint8_t by_rtc = ((RTC->ISR & RTC_ISR_WUTF) == RTC_ISR_WUTF);
+    rtc_wakeup_stop();
+
+    // A full period when the RTC woke us, otherwise the time measured with the calendar (~4 ms resolution)
+    uint32_t slept_ms = sleep_ms;
+
+    if (!by_rtc) {
+        uint64_t elapsed = stop_mode_rtc_ms() - rtc_before;
+        slept_ms = (elapsed < sleep_ms) ? (uint32_t)elapsed : sleep_ms;
+        stop_stats.early_wakeups++;
+    }
+
+    systick_compensate(slept_ms);
+    SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+
+    stop_stats.stop_entries++;
+    stop_stats.stop_ms += slept_ms;
+
+    // Let the interrupt that woke us up run
+    __enable_irq();
+}
+
+void stop_mode_get_stats(stop_mode_stats_t *stats) {
+    *stats = stop_stats;
+}
+
+static uint64_t stop_mode_rtc_ms(void) {
+    rtc_snapshot_t now;
+
+    // The shadow registers keep the calendar of the Stop mode entry until they are synchronized again
+    rtc_wait_synchronized();
+
+    rtc_get_snapshot(&now);
+
+    return ((uint64_t)now.epoch * 1000U) + now.millisecond;
+}
+
+static void stop_mode_restore_clocks(uint32_t rcc_cr, uint32_t rcc_cfgr) {
+    // Nothing to do when the system already ran from the HSI
+    if ((rcc_cfgr & CFGR_SWS_MASK) == 0U) {
+        return;
+    }
+
+    // Restart the HSE if it was used
+    if (rcc_cr & CR_HSEON) {
+        RCC->CR |= CR_HSEON;
+
+        while ((RCC->CR & CR_HSERDY) != CR_HSERDY) {
+        }
+    }
+
+    // Relock the PLL if it was used, its configuration in RCC_PLLCFGR is retained
+    if (rcc_cr & CR_PLLON) {
+        RCC->CR |= CR_PLLON;
+
+        while ((RCC->CR & CR_PLLRDY) != CR_PLLRDY) {
+        }
+    }
+
+    // Switch the system clock back and wait until the switch is effective
+    RCC->CFGR = (RCC->CFGR & ~CFGR_SW_MASK) | (rcc_cfgr & CFGR_SW_MASK);
+
+    while ((RCC->CFGR & CFGR_SWS_MASK) != (rcc_cfgr & CFGR_SWS_MASK)) {
+    }
+}
@@ -0,0 +1,266 @@
+#include <stddef.h>
+#include "timestamp.h"
+
+/* 32-bit timestamp service on TIM2 and TIM5
+ * Both timers run free over their full 32-bit range, so the difference of two timestamps is
+ * correct across a wrap with plain unsigned subtraction. The input capture channels latch the
+ * counter on an edge and raise a DMA request, a circular DMA stream copies the latched value
+ * into a ring buffer, and the CPU reads the ring whenever it likes: no interrupt per edge.
+ *
+ * TIM2 is shared with tim2_1hz_signal_init() and PA1 with the ADC DMA scan, use one or the other. TIM5
+ * captures on channel 2 (PA1), its channel 1 pin PA0 is the WKUP pin that wakes the board from Standby.
+ */
+
+// Macro to enable the clock for GPIOA (bit 0 in RCC_AHB1ENR)
+#define GPIOAEN (1U << 0)
+
+// Macro to enable the clock for GPIOB (bit 1 in RCC_AHB1ENR)
+#define GPIOBEN (1U << 1)
+
+// Macro to enable clock for DMA1 controller (bit 21 in RCC_AHB1ENR register)
+#define DMA1EN (1U << 21)
+
+// Macro to enable the clock for TIM2 (bit 0 in RCC_APB1ENR)
+#define TIM2EN (1U << 0)
+
+// Macro to enable the clock for TIM5 (bit 3 in RCC_APB1ENR)
+#define TIM5EN (1U << 3)
+
+// Macro to enable the counter (bit 0 in TIMx_CR1)
+#define CR1_CEN (1U << 0)
+
+// Macro to generate an update event that loads the prescaler (bit 0 in TIMx_EGR)
+#define EGR_UG (1U << 0)
+
+// Macro to enable the DMA request of capture/compare channel 2 (bit 10 in TIMx_DIER)
+#define DIER_CC2DE (1U << 10)
+
+// Macro to enable the DMA request of capture/compare channel 3 (bit 11 in TIMx_DIER)
+#define DIER_CC3DE (1U << 11)
+
+// Macro to enable the DMA stream (bit 0 in DMA_SxCR register)
+#define DMA_SCR_EN (1U << 0)
+
+// Macro to enable DMA circular mode (bit 8 in DMA_SxCR register)
+#define DMA_SCR_CIRC (1U << 8)
+
+// Macro to enable memory increment mode (bit 10 in DMA_SxCR register)
+#define DMA_SCR_MINC (1U << 10)
+
+// Macro to select 32-bit peripheral data size (bits 12:11 = 10 in DMA_SxCR register)
+#define DMA_SCR_PSIZE_WORD (2U << 11)
+
+// Macro to select 32-bit memory data size (bits 14:13 = 10 in DMA_SxCR register)
+#define DMA_SCR_MSIZE_WORD (2U << 13)
+
+// Macro to select the request channel of a stream (bits 27:25 in DMA_SxCR register)
+#define DMA_SCR_CHSEL(ch) ((uint32_t)(ch) << 25)
+
+// Macro to clear all interrupt flags of Stream 1 (bits 11:6 in DMA_LIFCR)
+#define LIFCR_STREAM1_ALL (0x3DU << 6)
+
+// Macro to clear all interrupt flags of Stream 4 (bits 5:0 in DMA_HIFCR)
+#define HIFCR_STREAM4_ALL (0x3DU << 0)
+
+// Macro to define the request channel of TIM2_CH3 on DMA1 Stream 1
+#define TIM2_CH3_DMA_CHANNEL 3U
+
+// Macro to define the request channel of TIM5_CH2 on DMA1 Stream 4
+#define TIM5_CH2_DMA_CHANNEL 6U
+
+static void timestamp_timer_start(TIM_TypeDef *tim, timestamp_rate_t rate);
+static uint32_t capture_polarity(capture_edge_t edge);
+static void capture_dma_start(capture_ring_t *ring, DMA_Stream_TypeDef *stream, uint32_t channel,
+                              volatile uint32_t *ccr, uint32_t *buffer, uint16_t size,
+                              volatile uint32_t *ifcr, uint32_t clear_flags);
+
+void tim2_timestamp_init(timestamp_rate_t rate) {
+    // Enable clock access to TIM2
+    RCC->APB1ENR |= TIM2EN;
+
+    timestamp_timer_start(TIM2, rate);
+}
+
+void tim5_timestamp_init(timestamp_rate_t rate) {
+    // Enable clock access to TIM5
+    RCC->APB1ENR |= TIM5EN;
+
+    timestamp_timer_start(TIM5, rate);
+}
+
+void tim2_ch3_capture_init(capture_ring_t *ring, uint32_t *buffer, uint16_t size, capture_edge_t edge) {
+    // Enable the clock access to GPIOB
+    RCC->AHB1ENR |= GPIOBEN;
+
+    // Configure PB10 in alternate function mode (MODER10[1:0] = 10)
+    GPIOB->MODER &= ~(3U << 20);
+    GPIOB->MODER |= (2U << 20);
+
+    // Select AF1 (TIM2_CH3) for PB10 (AFRH10[3:0] = 0001)
+    GPIOB->AFR[1] &= ~(0xFU << 8);
+    GPIOB->AFR[1] |= (1U << 8);
+
+    // Stop channel 3 while it is reconfigured
+    TIM2->CCER &= ~(0xBU << 8);
+
+    // Map IC3 on TI3 (CC3S[1:0] = 01) without prescaler and input filter
+    TIM2->CCMR2 &= ~(0xFFU << 0);
+    TIM2->CCMR2 |= (1U << 0);
+
+    // Arm the DMA ring on the capture register
+    capture_dma_start(ring, DMA1_Stream1, TIM2_CH3_DMA_CHANNEL, &TIM2->CCR3, buffer, size,
+                      &DMA1->LIFCR, LIFCR_STREAM1_ALL);
+
+    // Request a DMA transfer on each capture
+    TIM2->DIER |= DIER_CC3DE;
+
+    // Select the active edge(s) (CC3P bit 9, CC3NP bit 11) and enable the capture (CC3E bit 8)
+    TIM2->CCER |= (capture_polarity(edge) << 8) | (1U << 8);
+}
+
+void tim5_ch2_capture_init(capture_ring_t *ring, uint32_t *buffer, uint16_t size, capture_edge_t edge) {
+    // Enable the clock access to GPIOA
+    RCC->AHB1ENR |= GPIOAEN;
+
+    // Configure PA1 in alternate function mode (MODER1[1:0] = 10)
+    GPIOA->MODER &= ~(3U << 2);
+    GPIOA->MODER |= (2U << 2);
+
+    // Select AF2 (TIM5_CH2) for PA1 (AFRL1[3:0] = 0010)
+    GPIOA->AFR[0] &= ~(0xFU << 4);
+    GPIOA->AFR[0] |= (2U << 4);
+
+    // Stop channel 2 while it is reconfigured
+    TIM5->CCER &= ~(0xBU << 4);
+
+    // Map IC2 on TI2 (CC2S[1:0] = 01) without prescaler and input filter
+    TIM5->CCMR1 &= ~(0xFFU << 8);
+    TIM5->CCMR1 |= (1U << 8);
+
+    // Arm the DMA ring on the capture register
+    capture_dma_start(ring, DMA1_Stream4, TIM5_CH2_DMA_CHANNEL, &TIM5->CCR2, buffer, size,
+                      &DMA1->HIFCR, HIFCR_STREAM4_ALL);
+
+    // Request a DMA transfer on each capture
+    TIM5->DIER |= DIER_CC2DE;
+
+    // Select the active edge(s) (CC2P bit 5, CC2NP bit 7) and enable the capture (CC2E bit 4)
+    TIM5->CCER |= (capture_polarity(edge) << 4) | (1U << 4);
+}
+
+uint16_t capture_available(const capture_ring_t *ring) {
+    // NDTR counts down from size and reloads in circular mode, so the write index is size - NDTR
+    uint16_t head = (uint16_t)(ring->size - ring->stream->NDTR);
+
+    if (head == ring->size) {
+        head = 0;
+    }
+
+    // Entries lost to an overrun (more than size edges between two reads) cannot be detected here
+    return (uint16_t)((head + ring->size - ring->tail) % ring->size);
+}
+
+uint8_t capture_read(capture_ring_t *ring, uint32_t *timestamp) {
+    if (capture_available(ring) == 0U) {
+        return 0;
+    }
+
+    // Take the oldest timestamp out of the ring
+    *timestamp = ring->buffer[ring->tail];
+
+    ring->tail++;
+
+    if (ring->tail == ring->size) {
+        ring->tail = 0;
+    }
+
+    return 1;
+}
+
+uint8_t capture_read_interval(capture_ring_t *ring, uint32_t *interval) {
+    uint32_t timestamp;
+
+    // The first edge only provides the reference point
+    while (capture_read(ring, &timestamp)) {
+        uint8_t valid = ring->has_last;
+        uint32_t previous = ring->last;
+
+        ring->last = timestamp;
+        ring->has_last = 1;
+
+        if (valid) {
+            // Unsigned subtraction stays correct when the counter wrapped between the edges
+            *interval = timestamp - previous;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void timestamp_timer_start(TIM_TypeDef *tim, timestamp_rate_t rate) {
+    // Stop the counter while it is reconfigured
+    tim->CR1 &= ~CR1_CEN;
+
+    // Count at 1 MHz or at the full kernel clock
+    tim->PSC = (rate == TIMESTAMP_RATE_1MHZ) ? ((TIMESTAMP_TIM_CLK / 1000000U) - 1U) : 0U;
+
+    // Run over the full 32-bit range
+    tim->ARR = 0xFFFFFFFFU;
+
+    // Load the prescaler now instead of at the first overflow, then clear the resulting flags
+    tim->EGR = EGR_UG;
+    tim->SR = 0;
+    tim->CNT = 0;
+
+    // Enable timer and make it start counting
+    tim->CR1 |= CR1_CEN;
+}
+
+static uint32_t capture_polarity(capture_edge_t edge) {
+    // CCxNP:CCxP = 00 rising, 01 falling, 11 both edges (bit offsets 3 and 1 relative to CCxE)
+    switch (edge) {
+    case CAPTURE_EDGE_FALLING:
+        return (1U << 1);
+    case CAPTURE_EDGE_BOTH:
+        return (1U << 1) | (1U << 3);
+    default:
+        return 0U;
+    }
+}
+
+static void capture_dma_start(capture_ring_t *ring, DMA_Stream_TypeDef *stream, uint32_t channel,
+                              volatile uint32_t *ccr, uint32_t *buffer, uint16_t size,
+                              volatile uint32_t *ifcr, uint32_t clear_flags) {
+    // Enable the clock access to DMA1
+    RCC->AHB1ENR |= DMA1EN;
+
+    // Disable the stream and wait until it is released before configuring it
+    stream->CR &= ~DMA_SCR_EN;
+
+    while ((stream->CR & DMA_SCR_EN)) {
+    }
+
+    // Clear flags left over from a previous use of the stream
+    *ifcr = clear_flags;
+
+    // Set the capture register as source and the ring as destination
+    stream->PAR = (uint32_t)ccr;
+    stream->M0AR = (uint32_t)buffer;
+    stream->NDTR = size;
+
+    // Peripheral-to-memory, word transfers, memory increment, circular mode, no interrupts
+    stream->CR = DMA_SCR_CHSEL(channel) | DMA_SCR_MSIZE_WORD | DMA_SCR_PSIZE_WORD | DMA_SCR_MINC | DMA_SCR_CIRC;
+
+    // Use direct mode so every capture is written out immediately
+    stream->FCR = 0;
+
+    ring->stream = stream;
+    ring->buffer = buffer;
+    ring->size = size;
+    ring->tail = 0;
+    ring->has_last = 0;
+
+    // Enable the stream, it now waits for capture requests
+    stream->CR |= DMA_SCR_EN;
+}
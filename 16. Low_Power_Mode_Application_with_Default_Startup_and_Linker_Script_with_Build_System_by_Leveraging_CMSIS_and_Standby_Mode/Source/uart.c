@@ -1,8 +1,11 @@
 #include <stdint.h>
 #include "uart.h"
+#include "gpio_pin.h"
+#include "irq.h"
 
-// Macro to enable the clock for GPIOA (bit 0 in RCC_AHB1ENR)
-#define GPIOAEN (1U << 0)
+// PA2 is UART2_TX (AF7)
+#define UART2_PINS(X) \
+    X(2, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 7)
 
 // Macro to enable the clock for UART2 (bit 17 in RCC_APB1ENR)
 #define UART2EN (1U << 17)
@@ -28,19 +31,11 @@
 static uint16_t compute_uart_bd(uint32_t periph_clk, uint32_t baudrate);
 static void uart2_set_baudrate(uint32_t periph_clk, uint32_t baudrate);
 
-void uart2_init(void) {
-    // Enable the clock access to GPIOA
-    RCC->AHB1ENR |= GPIOAEN;
-
-    // Configure GPIOA Pin 2 to operate in alternate function mode (MODER2[1:0] = 10)
-    GPIOA->MODER &= ~(1U << 4);  // Set bit 4 to 0
-    GPIOA->MODER |= (1U << 5);   // Set bit 5 to 1
+static const gpio_port_cfg_t uart2_pins = GPIO_PORT_CFG(A, UART2_PINS);
 
-    // Set alternate function type to AF7 (UART2_TX)
-    GPIOA->AFR[0] |= (1U << 8);    // Set bit 8 to 1
-    GPIOA->AFR[0] |= (1U << 9);    // Set bit 9 to 1
-    GPIOA->AFR[0] |= (1U << 10);   // Set bit 10 to 1
-    GPIOA->AFR[0] &= ~(1U << 11);  // Set bit 11 to 0
+void uart2_init(void) {
+    // Enable the clock access to GPIOA and configure Pin 2 as UART2_TX (alternate function mode, AF7)
+    gpio_port_apply(&uart2_pins);
 
     // Enable the clock access to UART2
     RCC->APB1ENR |= UART2EN;
@@ -65,6 +60,9 @@ static void uart2_set_baudrate(uint32_t periph_clk, uint32_t baudrate) {
 }
 
 void uart_write_character(int ch) {
+    // printf must not delay latency-critical handlers
+    IRQ_ASSERT_MAY_BLOCK();
+
     // Ensure that the transmit data register is empty before writing a new data
     while (!(USART2->SR & (SR_TXE))) {
     }
@@ -1,7 +1,15 @@
 #include "uart_dma.h"
-
-// Macro to enable the clock for GPIOA (bit 0 in RCC_AHB1ENR)
-#define GPIOAEN (1U << 0)
+#include "queue.h"
+#include "pt.h"
+#include "irq.h"
+#include "gpio_pin.h"
+#include "bitband.h"
+#include "ramfunc.h"
+
+// PA2 is UART2_TX and PA3 is UART2_RX (AF7)
+#define UART2_PINS(X) \
+    X(2, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 7) \
+    X(3, GPIO_MODE_AF, GPIO_OTYPE_PP, GPIO_SPEED_LOW, GPIO_PULL_NONE, 7)
 
 // Macro to enable the clock for UART2 (bit 17 in RCC_APB1ENR)
 #define UART2EN (1U << 17)
@@ -89,38 +97,26 @@
 
 static uint16_t compute_uart_bd(uint32_t periph_clk, uint32_t baudrate);
 static void uart2_set_baudrate(uint32_t periph_clk, uint32_t baudrate);
+static inline void uart2_rx_dma_complete(void) __attribute__((always_inline));
+
+static const gpio_port_cfg_t uart2_pins = GPIO_PORT_CFG(A, UART2_PINS);
 
 // Array to store the incoming UART2 data
 char uart2_data_buffer[UART2_DATA_BUFF_SIZE];
 
-uint8_t g_uart_cmplt; // UART2 event flag
-uint8_t g_rx_cmplt;   // DMA1 Stream 5 event flag (indicates new data has been received)
-uint8_t g_tx_cmplt;   // DMA1 Stream 6 event flag (indicates new data has been transmitted)
+// Received messages, produced by the DMA1 Stream 5 interrupt only
+SPSC_QUEUE_DEFINE(uart2_rx_queue, uart2_rx_msg_t, 4U);
 
-void uart2_rx_tx_init(void) {
-	/************UART2 GPIOA Pins Configuration**********/
-	// Enable the clock access to GPIOA
-    RCC->AHB1ENR |= GPIOAEN;
+// Driver events, produced by the UART2 and DMA1 Stream 6 interrupts
+MPSC_QUEUE_DEFINE(uart2_event_queue, uint8_t, 8U);
 
-    // Configure GPIOA Pin 2 to operate in alternate function mode (MODER2[1:0] = 10)
-    GPIOA->MODER &= ~(1U << 4);
-    GPIOA->MODER |= (1U << 5);
-
-    // Configure GPIOA Pin 3 to operate in alternate function mode (MODER3[1:0] = 10)
-    GPIOA->MODER &= ~(1U << 6);
-    GPIOA->MODER |= (1U << 7);
-
-    // Set PA2 alternate function type to AF7 (UART2_TX)
-    GPIOA->AFR[0] |= (1U << 8);
-    GPIOA->AFR[0] |= (1U << 9);
-    GPIOA->AFR[0] |= (1U << 10);
-    GPIOA->AFR[0] &= ~(1U << 11);
+void uart2_rx_tx_init(void) {
+    // Prepare the event queue before any interrupt can use it
+    mpsc_queue_init(&uart2_event_queue);
 
-    // Set PA3 alternate function type to AF7 (UART2_RX)
-    GPIOA->AFR[0] |= (1U << 12);
-    GPIOA->AFR[0] |= (1U << 13);
-    GPIOA->AFR[0] |= (1U << 14);
-    GPIOA->AFR[0] &= ~(1U << 15);
+	/************UART2 GPIOA Pins Configuration**********/
+	// Enable the clock access to GPIOA and configure Pin 2 and 3 as UART2_TX/RX (alternate function mode, AF7)
+    gpio_port_apply(&uart2_pins);
 
     /************UART2 Configuration**********/
     // Enable the clock access to UART2
@@ -135,8 +131,8 @@ void uart2_rx_tx_init(void) {
     // Configure transfer direction to both transmit and receive
     USART2->CR1 = CR1_TE | CR1_RE;
 
-    // Clear any pending transmission complete flags
-    USART2->SR &= ~SR_TC;
+    // Clear any pending transmission complete flag (rc_w0: writing 1 leaves the other flags untouched)
+    USART2->SR = ~SR_TC;
 
     // Enable the transmission complete interrupt
     USART2->CR1 |= CR1_TCIE;
@@ -145,7 +141,7 @@ void uart2_rx_tx_init(void) {
     USART2->CR1 |= CR1_UE;
 
     // Enable the USART2 interrupt line in the NVIC to handle UART2 interrupts
-    NVIC_EnableIRQ(USART2_IRQn);
+    irq_enable(USART2_IRQn);
 }
 
 void dma1_init(void) {
@@ -153,15 +149,15 @@ void dma1_init(void) {
     RCC->AHB1ENR |= DMA1EN;
 
     // Enable the DMA1_Stream6 interrupt line in the NVIC to handle DMA1-related interrupts
-    NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+    irq_enable(DMA1_Stream6_IRQn);
 }
 
 void dma1_stream5_uart2_rx_config(void) {
 	// Disable DMA1 stream before making any configurations
-    DMA1_Stream5->CR &= ~DMA_SCR_EN;
+    BITBAND_PERIPH_CLEAR(DMA1_Stream5->CR, DMA_SCR_EN);
 
     // Wait until DMA1 Stream5 is disabled before configuring it
-    while ((DMA1_Stream5->CR & (DMA_SCR_EN))) {
+    while (BITBAND_PERIPH_TEST(DMA1_Stream5->CR, DMA_SCR_EN)) {
     }
 
     // Clear any existing interrupt flags for DMA1 Stream5
@@ -177,36 +173,36 @@ void dma1_stream5_uart2_rx_config(void) {
     DMA1_Stream5->NDTR = (uint16_t)UART2_DATA_BUFF_SIZE;
 
     // Select the DMA Channel 4
-    DMA1_Stream5->CR &= ~(1U << 25);
-    DMA1_Stream5->CR &= ~(1U << 26);
-    DMA1_Stream5->CR |= (1U << 27);
+    BITBAND_PERIPH_CLEAR(DMA1_Stream5->CR, (1U << 25));
+    BITBAND_PERIPH_CLEAR(DMA1_Stream5->CR, (1U << 26));
+    BITBAND_PERIPH_SET(DMA1_Stream5->CR, (1U << 27));
 
     // Enable memory address increment mode
-    DMA1_Stream5->CR |= DMA_SCR_MINC;
+    BITBAND_PERIPH_SET(DMA1_Stream5->CR, DMA_SCR_MINC);
 
     // Enable the transfer complete interrupt
-    DMA1_Stream5->CR |= DMA_SCR_TCIE;
+    BITBAND_PERIPH_SET(DMA1_Stream5->CR, DMA_SCR_TCIE);
 
     // Enable circular mode for continuous data transfer (reception)
-    DMA1_Stream5->CR |= DMA_SCR_CIRC;
+    BITBAND_PERIPH_SET(DMA1_Stream5->CR, DMA_SCR_CIRC);
 
     // Set data transfer direction as peripheral-to-memory
-    DMA1_Stream5->CR &= ~(1U << 6);
-    DMA1_Stream5->CR &= ~(1U << 7);
+    BITBAND_PERIPH_CLEAR(DMA1_Stream5->CR, (1U << 6));
+    BITBAND_PERIPH_CLEAR(DMA1_Stream5->CR, (1U << 7));
 
     // Enable DMA1 stream
-    DMA1_Stream5->CR |= DMA_SCR_EN;
+    BITBAND_PERIPH_SET(DMA1_Stream5->CR, DMA_SCR_EN);
 
     // Enable the DMA1_Stream5 interrupt line in the NVIC to handle DMA1-related interrupts
-    NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+    irq_enable(DMA1_Stream5_IRQn);
 }
 
 void dma1_stream6_uart2_tx_config(uint32_t msg_to_snd, uint32_t msg_len) {
 	// Disable DMA1 stream before making any configurations
-    DMA1_Stream6->CR &= ~DMA_SCR_EN;
+    BITBAND_PERIPH_CLEAR(DMA1_Stream6->CR, DMA_SCR_EN);
 
     // Wait until DMA1 Stream6 is disabled before configuring it
-    while ((DMA1_Stream6->CR & (DMA_SCR_EN))) {
+    while (BITBAND_PERIPH_TEST(DMA1_Stream6->CR, DMA_SCR_EN)) {
     }
 
     // Clear any existing interrupt flags for DMA1 Stream6
@@ -222,22 +218,38 @@ void dma1_stream6_uart2_tx_config(uint32_t msg_to_snd, uint32_t msg_len) {
     DMA1_Stream6->NDTR = msg_len;
 
     // Select the DMA Channel 4
-    DMA1_Stream6->CR &= ~(1U << 25);
-    DMA1_Stream6->CR &= ~(1U << 26);
-    DMA1_Stream6->CR |= (1U << 27);
+    BITBAND_PERIPH_CLEAR(DMA1_Stream6->CR, (1U << 25));
+    BITBAND_PERIPH_CLEAR(DMA1_Stream6->CR, (1U << 26));
+    BITBAND_PERIPH_SET(DMA1_Stream6->CR, (1U << 27));
 
     // Enable memory address increment mode
-    DMA1_Stream6->CR |= DMA_SCR_MINC;
+    BITBAND_PERIPH_SET(DMA1_Stream6->CR, DMA_SCR_MINC);
 
     // Set data transfer direction as memory-to-peripheral
-    DMA1_Stream6->CR |= (1U << 6);
-    DMA1_Stream6->CR &= ~(1U << 7);
+    BITBAND_PERIPH_SET(DMA1_Stream6->CR, (1U << 6));
+    BITBAND_PERIPH_CLEAR(DMA1_Stream6->CR, (1U << 7));
 
     // Enable the transfer complete interrupt
-    DMA1_Stream6->CR |= DMA_SCR_TCIE;
+    BITBAND_PERIPH_SET(DMA1_Stream6->CR, DMA_SCR_TCIE);
 
     // Enable DMA2 stream
-    DMA1_Stream6->CR |= DMA_SCR_EN;
+    BITBAND_PERIPH_SET(DMA1_Stream6->CR, DMA_SCR_EN);
+}
+
+uint8_t uart2_dma_receive(uart2_rx_msg_t *msg) {
+    return spsc_queue_pop(&uart2_rx_queue, msg);
+}
+
+uint8_t uart2_dma_get_event(uart_dma_event_t *event) {
+    uint8_t value;
+
+    if (!mpsc_queue_pop_byte(&uart2_event_queue, &value)) {
+        return 0;
+    }
+
+    *event = (uart_dma_event_t)value;
+
+    return 1;
 }
 
 static uint16_t compute_uart_bd(uint32_t periph_clk, uint32_t baudrate) {
@@ -250,29 +262,57 @@ static void uart2_set_baudrate(uint32_t periph_clk, uint32_t baudrate) {
 }
 
 void USART2_IRQHandler(void) {
-	// Set the flag when a UART2 event occurs
-    g_uart_cmplt = 1;
+	// Report the UART2 event
+    mpsc_queue_push_byte(&uart2_event_queue, UART_DMA_EVENT_UART_TC);
+    pt_sched_signal(PT_EVENT_UART2_TC);
 
-    // Clear any pending transmission complete flags
-    USART2->SR &= ~SR_TC;
+    // Clear the transmission complete flag with a direct write, a read-modify-write could drop a flag
+    // raised in between
+    USART2->SR = ~SR_TC;
 }
 
-void DMA1_Stream5_IRQHandler(void) {
+// Runs from SRAM, the message has to be copied out before the next reception overwrites it
+RAMFUNC void DMA1_Stream5_IRQHandler(void) {
     if ((DMA1->HISR) & HIFSR_TCIF5) {
-    	// Set the flag when a transfer complete event occurs on DMA1 Stream 5
-        g_rx_cmplt = 1;
+        uart2_rx_dma_complete();
 
         // Clear the transfer complete interrupt flag
-        DMA1->HIFCR |= HIFCR_CTCIF5;
+        DMA1->HIFCR = HIFCR_CTCIF5;
     }
 }
 
+RAMFUNC void uart2_dma_rx_complete_sram(void) {
+    uart2_rx_dma_complete();
+}
+
+void uart2_dma_rx_complete_flash(void) {
+    uart2_rx_dma_complete();
+}
+
+static inline void uart2_rx_dma_complete(void) {
+	// Copy the message into the queue before the circular transfer overwrites it (dropped if the queue is full)
+    // The slot is filled in place with a fixed-size loop, spsc_queue_push() would call memcpy() in flash
+    uart2_rx_msg_t *msg = spsc_queue_claim(&uart2_rx_queue);
+
+    if (msg != NULL) {
+        for (uint32_t i = 0; i < UART2_DATA_BUFF_SIZE; i++) {
+            msg->data[i] = uart2_data_buffer[i];
+        }
+
+        spsc_queue_publish(&uart2_rx_queue);
+    }
+
+    // pt_sched_signal() is a RAMFUNC as well, so the whole completion path runs from SRAM
+    pt_sched_signal(PT_EVENT_UART2_RX);
+}
+
 void DMA1_Stream6_IRQHandler(void) {
     if ((DMA1->HISR) & HIFSR_TCIF6) {
-    	// Set the flag when a transfer complete event occurs on DMA1 Stream 6
-        g_tx_cmplt = 1;
+    	// Report the transfer complete event of DMA1 Stream 6
+        mpsc_queue_push_byte(&uart2_event_queue, UART_DMA_EVENT_TX_CMPLT);
+        pt_sched_signal(PT_EVENT_UART2_TX);
 
         // Clear the transfer complete interrupt flag
-        DMA1->HIFCR |= HIFCR_CTCIF6;
+        DMA1->HIFCR = HIFCR_CTCIF6;
     }
 }
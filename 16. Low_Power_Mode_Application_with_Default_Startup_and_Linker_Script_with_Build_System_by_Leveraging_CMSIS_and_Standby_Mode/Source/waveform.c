@@ -0,0 +1,359 @@
+#include <stddef.h>
+#include "waveform.h"
+#include "irq.h"
+#include "profile.h"
+
+/* Timer-driven GPIO waveform engine
+ * Every TIM1 update event makes DMA2 Stream 5 copy one precomputed word into GPIOx->BSRR, so all lanes
+ * of a port switch in the same bus cycle and the timing only depends on the timer. Frame data is
+ * encoded chunk by chunk into two buffers used in DMA double-buffer mode: while the DMA plays one
+ * buffer, the transfer complete interrupt encodes the next chunk into the other one.
+ *
+ * The refill has to finish within one chunk period (WAVEFORM_CHUNK_SLOTS * slot_ticks TIM1 clocks). For
+ * WS2812 at 16 MHz that is 1344 cycles for 64 bits, which the encoder does not meet at -O0, so waveform_init()
+ * measures the refill with the DWT cycle counter. When it is too slow, waveform_start() encodes the whole
+ * frame up front into the buffer given to waveform_set_frame_buffer() (or the two chunk buffers for short
+ * frames) and the interrupt only points the idle DMA buffer at the next chunk. Frames that fit neither
+ * way are refused.
+ *
+ * Only DMA2 can access the GPIO ports. TIM1_UP on DMA2 Stream 5 is shared with pwm_dma_burst_start(TIM1), so
+ * waveform_init() refuses to run while the stream is enabled: the waveform releases it after every frame,
+ * an enabled stream belongs to another driver.
+ */
+
+// Macro to enable clock for DMA2 controller (bit 22 in RCC_AHB1ENR register)
+#define DMA2EN (1U << 22)
+
+// Macro to enable the clock for TIM1 (bit 0 in RCC_APB2ENR)
+#define TIM1EN (1U << 0)
+
+// Macro to enable the counter (bit 0 in TIMx_CR1)
+#define CR1_CEN (1U << 0)
+
+// Macro to generate an update event (bit 0 in TIMx_EGR)
+#define EGR_UG (1U << 0)
+
+// Macro to enable the update DMA request (bit 8 in TIMx_DIER)
+#define DIER_UDE (1U << 8)
+
+// Macro to enable the DMA stream (bit 0 in DMA_SxCR register)
+#define DMA_SCR_EN (1U << 0)
+
+// Macro to enable transfer complete interrupt (bit 4 in DMA_SxCR register)
+#define DMA_SCR_TCIE (1U << 4)
+
+// Macro to select memory-to-peripheral direction (DIR[1:0] = 01, bits 7:6 in DMA_SxCR register)
+#define DMA_SCR_DIR_M2P (1U << 6)
+
+// Macro to enable memory increment mode (bit 10 in DMA_SxCR register)
+#define DMA_SCR_MINC (1U << 10)
+
+// Macro to select 32-bit peripheral data size (bits 12:11 = 10 in DMA_SxCR register)
+#define DMA_SCR_PSIZE_WORD (2U << 11)
+
+// Macro to select 32-bit memory data size (bits 14:13 = 10 in DMA_SxCR register)
+#define DMA_SCR_MSIZE_WORD (2U << 13)
+
+// Macro to enable double-buffer mode (bit 18 in DMA_SxCR register)
+#define DMA_SCR_DBM (1U << 18)
+
+// Macro to read/select the buffer currently used in double-buffer mode (bit 19 in DMA_SxCR register)
+#define DMA_SCR_CT (1U << 19)
+
+// Macro to select DMA channel 6 (TIM1_UP on Stream 5) (bits 27:25 in DMA_SxCR register)
+#define DMA_SCR_CHSEL_6 (6U << 25)
+
+// Macro to check whether a transfer complete event is occurred on Stream 5 (bit 11 in DMA_HISR)
+#define HISR_TCIF5 (1U << 11)
+
+// Macro to clear all interrupt flags of Stream 5 (bits 11:6 in DMA_HIFCR)
+#define HIFCR_STREAM5_ALL (0x3DU << 6)
+
+// Macro to define the cycles of the interrupt around a refill (entry, flag handling, exit)
+#define WAVEFORM_IRQ_CYCLES 100U
+
+// Macro to define the number of measured refills
+#define WAVEFORM_CALIBRATION_RUNS 4U
+
+static uint32_t dma_buffers[2][WAVEFORM_CHUNK_SLOTS];
+
+// All lanes low, played during the reset time of pre-encoded frames
+static const uint32_t idle_chunk[WAVEFORM_CHUNK_SLOTS];
+
+static waveform_timing_t wf_timing;
+static const uint8_t *const *wf_lanes;
+static uint32_t wf_data_bits;      // Bits per lane in the current frame
+static uint32_t wf_next_bit;       // Next bit to be encoded
+static uint32_t wf_chunks_total;   // Chunks covering the frame and the reset time
+static uint32_t wf_chunks_done;    // Chunks played so far
+static uint32_t *wf_frame;         // Pre-encoded frame, NULL while encoding chunk by chunk
+static uint32_t wf_frame_chunks;   // Pre-encoded chunks of the current frame
+static uint32_t *wf_frame_buffer;  // Buffer for frames that cannot be encoded while playing
+static uint32_t wf_frame_buffer_chunks;
+static uint32_t wf_refill_cycles;  // Measured cycles to encode one chunk
+static volatile uint8_t wf_busy;
+
+static void waveform_encode_chunk(uint32_t *buffer);
+static uint32_t waveform_measure_refill(void);
+static void waveform_stop(void);
+
+uint8_t waveform_init(const waveform_timing_t *timing) {
+    // Reject shapes that do not fit into the slot grid
+    if ((timing == NULL) || (timing->pin_mask == 0U) || (timing->slot_ticks < 2U) ||
+        (timing->slots_per_bit == 0U) || ((WAVEFORM_CHUNK_SLOTS % timing->slots_per_bit) != 0U) ||
+        (timing->zero_high_slots == 0U) || (timing->one_high_slots == 0U) ||
+        (timing->zero_high_slots == timing->one_high_slots) ||
+        (timing->zero_high_slots >= timing->slots_per_bit) || (timing->one_high_slots >= timing->slots_per_bit)) {
+        return 0;
+    }
+
+    // Do not take DMA2 Stream 5 away from a frame still playing or from another driver
+    if (wf_busy || (DMA2_Stream5->CR & DMA_SCR_EN)) {
+        return 0;
+    }
+
+    wf_timing = *timing;
+
+    /************GPIO Configuration**********/
+    // Enable the clock access to the port (GPIOA = bit 0, GPIOB = bit 1, ... in RCC_AHB1ENR)
+    RCC->AHB1ENR |= (1U << (((uint32_t)timing->port - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE)));
+
+    // Drive all lanes low, then configure them as fast push-pull outputs (MODERx[1:0] = 01)
+    timing->port->BSRR = ((uint32_t)timing->pin_mask << 16);
+
+    for (uint32_t pin = 0; pin < WAVEFORM_MAX_LANES; pin++) {
+        if (timing->pin_mask & (1U << pin)) {
+            timing->port->OTYPER &= ~(1U << pin);
+            timing->port->OSPEEDR |= (3U << (pin * 2U));
+            timing->port->MODER &= ~(3U << (pin * 2U));
+            timing->port->MODER |= (1U << (pin * 2U));
+        }
+    }
+
+    /************TIM1 Configuration**********/
+    // Enable clock access to TIM1
+    RCC->APB2ENR |= TIM1EN;
+
+    // One update event per slot
+    TIM1->CR1 &= ~CR1_CEN;
+    TIM1->PSC = 0;
+    TIM1->ARR = timing->slot_ticks - 1U;
+    TIM1->EGR = EGR_UG;
+    TIM1->SR = 0;
+
+    /************DMA Configuration**********/
+    // Enable the clock access to DMA2
+    RCC->AHB1ENR |= DMA2EN;
+
+    // Disable the stream and wait until it is released before configuring it
+    DMA2_Stream5->CR &= ~DMA_SCR_EN;
+
+    while ((DMA2_Stream5->CR & DMA_SCR_EN)) {
+    }
+
+    // Memory-to-peripheral word transfers into BSRR, alternating between the two buffers
+    DMA2_Stream5->PAR = (uint32_t)&timing->port->BSRR;
+    DMA2_Stream5->M0AR = (uint32_t)dma_buffers[0];
+    DMA2_Stream5->M1AR = (uint32_t)dma_buffers[1];
+    DMA2_Stream5->CR = DMA_SCR_CHSEL_6 | DMA_SCR_MSIZE_WORD | DMA_SCR_PSIZE_WORD | DMA_SCR_MINC |
+                       DMA_SCR_DBM | DMA_SCR_DIR_M2P | DMA_SCR_TCIE;
+
+    // Direct mode, each update event moves exactly one word
+    DMA2_Stream5->FCR = 0;
+
+    // Enable the DMA2_Stream5 interrupt line in the NVIC to refill the idle buffer
+    irq_enable(DMA2_Stream5_IRQn);
+
+    // Time the refill of this shape, it decides whether frames can be encoded while playing
+    wf_refill_cycles = waveform_measure_refill();
+
+    return 1;
+}
+
+void waveform_set_frame_buffer(uint32_t *buffer, uint32_t words) {
+    // Only whole chunks are used, see WAVEFORM_FRAME_WORDS()
+    wf_frame_buffer = buffer;
+    wf_frame_buffer_chunks = (buffer != NULL) ? (words / WAVEFORM_CHUNK_SLOTS) : 0U;
+}
+
+uint32_t waveform_refill_cycles(void) {
+    return wf_refill_cycles;
+}
+
+uint8_t waveform_start(const uint8_t *const lanes[WAVEFORM_MAX_LANES], uint32_t bytes) {
+    if (wf_busy || (lanes == NULL) || (bytes == 0U)) {
+        return 0;
+    }
+
+    wf_lanes = lanes;
+    wf_data_bits = bytes * 8U;
+    wf_next_bit = 0;
+    wf_chunks_done = 0;
+
+    // The frame and its reset time are played in whole chunks
+    uint32_t data_slots = wf_data_bits * wf_timing.slots_per_bit;
+    uint32_t data_chunks = (data_slots + WAVEFORM_CHUNK_SLOTS - 1U) / WAVEFORM_CHUNK_SLOTS;
+    wf_chunks_total = (data_slots + wf_timing.reset_slots + WAVEFORM_CHUNK_SLOTS - 1U) / WAVEFORM_CHUNK_SLOTS;
+
+    // Encode while playing only if a refill finishes within the chunk the DMA plays meanwhile
+    uint32_t chunk_cycles = WAVEFORM_CHUNK_SLOTS * wf_timing.slot_ticks;
+
+    if ((wf_refill_cycles + WAVEFORM_IRQ_CYCLES) <= chunk_cycles) {
+        wf_frame = NULL;
+
+        // Pre-encode both buffers, the interrupt refills them from here on
+        waveform_encode_chunk(dma_buffers[0]);
+        waveform_encode_chunk(dma_buffers[1]);
+
+        DMA2_Stream5->M0AR = (uint32_t)dma_buffers[0];
+        DMA2_Stream5->M1AR = (uint32_t)dma_buffers[1];
+    } else {
+        // Otherwise encode the whole frame now, short frames fit into the two chunk buffers
+        if (data_chunks <= 2U) {
+            wf_frame = dma_buffers[0];
+        } else if (data_chunks <= wf_frame_buffer_chunks) {
+            wf_frame = wf_frame_buffer;
+        } else {
+            return 0;
+        }
+
+        wf_frame_chunks = data_chunks;
+
+        for (uint32_t chunk = 0; chunk < data_chunks; chunk++) {
+            waveform_encode_chunk(&wf_frame[chunk * WAVEFORM_CHUNK_SLOTS]);
+        }
+
+        DMA2_Stream5->M0AR = (uint32_t)wf_frame;
+        DMA2_Stream5->M1AR = (uint32_t)((data_chunks > 1U) ? &wf_frame[WAVEFORM_CHUNK_SLOTS] : idle_chunk);
+    }
+
+    wf_busy = 1;
+
+    // Restart from buffer 0 with a full chunk
+    DMA2->HIFCR = HIFCR_STREAM5_ALL;
+    DMA2_Stream5->CR &= ~DMA_SCR_CT;
+    DMA2_Stream5->NDTR = WAVEFORM_CHUNK_SLOTS;
+    DMA2_Stream5->CR |= DMA_SCR_EN;
+
+    // Start pacing the transfers
+    TIM1->CNT = 0;
+    TIM1->DIER |= DIER_UDE;
+    TIM1->CR1 |= CR1_CEN;
+
+    return 1;
+}
+
+uint8_t waveform_busy(void) {
+    return wf_busy;
+}
+
+static void waveform_encode_chunk(uint32_t *buffer) {
+    const uint32_t spb = wf_timing.slots_per_bit;
+    const uint32_t mask = wf_timing.pin_mask;
+
+    for (uint32_t slot = 0; slot < WAVEFORM_CHUNK_SLOTS; slot += spb) {
+        // Idle low after the last bit (start of the reset time)
+        for (uint32_t i = 0; i < spb; i++) {
+            buffer[slot + i] = 0;
+        }
+
+        if (wf_next_bit >= wf_data_bits) {
+            continue;
+        }
+
+        // Collect the lanes sending a 1 for this bit (MSB first)
+        uint32_t byte = wf_next_bit >> 3;
+        uint32_t bit = 7U - (wf_next_bit & 7U);
+        uint32_t ones = 0;
+        uint32_t pending = mask;
+
+        while (pending != 0U) {
+            uint32_t pin = 31U - __CLZ(pending);
+            pending &= ~(1U << pin);
+
+            if ((wf_lanes[pin][byte] >> bit) & 1U) {
+                ones |= (1U << pin);
+            }
+        }
+
+        // Raise all lanes, then release the 0 lanes and the 1 lanes at their own slot
+        buffer[slot] = mask;
+        buffer[slot + wf_timing.zero_high_slots] |= ((mask & ~ones) << 16);
+        buffer[slot + wf_timing.one_high_slots] |= (ones << 16);
+
+        wf_next_bit++;
+    }
+}
+
+static uint32_t waveform_measure_refill(void) {
+    static const uint8_t calibration_data[WAVEFORM_CHUNK_SLOTS / 8U] = {
+        [0 ... ((WAVEFORM_CHUNK_SLOTS / 8U) - 1U)] = 0xFFU
+    };
+    const uint8_t *calibration_lanes[WAVEFORM_MAX_LANES];
+    profile_probe_t probe = PROFILE_PROBE_INIT("waveform refill");
+
+    profile_init();
+
+    // Worst case: every lane of the mask sends a 1 in every bit of the chunk
+    for (uint32_t pin = 0; pin < WAVEFORM_MAX_LANES; pin++) {
+        calibration_lanes[pin] = calibration_data;
+    }
+
+    wf_lanes = calibration_lanes;
+    wf_data_bits = WAVEFORM_CHUNK_SLOTS;
+
+    for (uint32_t run = 0; run < WAVEFORM_CALIBRATION_RUNS; run++) {
+        wf_next_bit = 0;
+
+        profile_start(&probe);
+        waveform_encode_chunk(dma_buffers[0]);
+        profile_stop(&probe);
+    }
+
+    wf_lanes = NULL;
+
+    return probe.max;
+}
+
+static void waveform_stop(void) {
+    // Stop pacing, then release the stream
+    TIM1->CR1 &= ~CR1_CEN;
+    TIM1->DIER &= ~DIER_UDE;
+    DMA2_Stream5->CR &= ~DMA_SCR_EN;
+
+    // Make sure all lanes end low
+    wf_timing.port->BSRR = ((uint32_t)wf_timing.pin_mask << 16);
+
+    wf_busy = 0;
+}
+
+void DMA2_Stream5_IRQHandler(void) {
+    if (DMA2->HISR & HISR_TCIF5) {
+        DMA2->HIFCR = HIFCR_STREAM5_ALL;
+
+        wf_chunks_done++;
+
+        if (wf_chunks_done >= wf_chunks_total) {
+            waveform_stop();
+            return;
+        }
+
+        // CT points at the buffer now being played, refill the other one
+        uint32_t idle = (DMA2_Stream5->CR & DMA_SCR_CT) ? 0U : 1U;
+
+        if (wf_frame == NULL) {
+            waveform_encode_chunk(dma_buffers[idle]);
+            return;
+        }
+
+        // Pre-encoded frame: queue its next chunk, then the idle chunk for the reset time
+        uint32_t next = wf_chunks_done + 1U;
+        const uint32_t *chunk = (next < wf_frame_chunks) ? &wf_frame[next * WAVEFORM_CHUNK_SLOTS] : idle_chunk;
+
+        if (idle != 0U) {
+            DMA2_Stream5->M1AR = (uint32_t)chunk;
+        } else {
+            DMA2_Stream5->M0AR = (uint32_t)chunk;
+        }
+    }
+}
@@ -47,42 +47,103 @@ defined in linker script */
 Reset_Handler:
   ldr   r0, =_estack
   mov   sp, r0          /* set stack pointer */
+
+/* Start the DWT cycle counter so that the time spent until main() can be measured */
+  ldr   r0, =0xE000EDFC        /* CoreDebug->DEMCR */
+  ldr   r1, [r0]
+  orr   r1, r1, #0x01000000    /* TRCENA */
+  str   r1, [r0]
+  ldr   r0, =0xE0001000        /* DWT->CTRL */
+  movs  r1, #0
+  str   r1, [r0, #4]           /* DWT->CYCCNT = 0 */
+  ldr   r1, [r0]
+  orr   r1, r1, #1             /* CYCCNTENA */
+  str   r1, [r0]
+
 /* Call the clock system initialization function.*/
   bl  SystemInit
 
-/* Copy the data segment initializers from flash to SRAM */
-  ldr r0, =_sdata
-  ldr r1, =_edata
-  ldr r2, =_sidata
-  movs r3, #0
-  b LoopCopyDataInit
-
-CopyDataInit:
-  ldr r4, [r2, r3]
-  str r4, [r0, r3]
-  adds r3, r3, #4
-
-LoopCopyDataInit:
-  adds r4, r0, r3
-  cmp r4, r1
-  bcc CopyDataInit
-
-/* Zero fill the bss segment. */
-  ldr r2, =_sbss
-  ldr r4, =_ebss
-  movs r3, #0
-  b LoopFillZerobss
-
-FillZerobss:
-  str  r3, [r2]
-  adds r2, r2, #4
-
-LoopFillZerobss:
-  cmp r2, r4
-  bcc FillZerobss
+/* Copy every region of the copy table (load address, run address, size in bytes) from flash to SRAM,
+   eight words per LDM/STM burst and the remaining words one by one. Sizes are multiples of 4. */
+  ldr   r4, =_scopy_table
+  ldr   r5, =_ecopy_table
+
+LoopCopyTable:
+  cmp   r4, r5
+  bhs   CopyTableDone
+  ldmia r4!, {r0, r1, r2}
+  subs  r2, r2, #32
+  blo   CopyTail
+
+CopyBurst:
+  ldmia r0!, {r3, r6-r12}
+  stmia r1!, {r3, r6-r12}
+  subs  r2, r2, #32
+  bhs   CopyBurst
+
+CopyTail:
+  adds  r2, r2, #32
+  beq   LoopCopyTable
+
+CopyWord:
+  ldr   r3, [r0], #4
+  str   r3, [r1], #4
+  subs  r2, r2, #4
+  bne   CopyWord
+  b     LoopCopyTable
+
+CopyTableDone:
+
+/* Zero fill every region of the zero table (run address, size in bytes) the same way */
+  ldr   r4, =_szero_table
+  ldr   r5, =_ezero_table
+  movs  r3, #0
+  movs  r6, #0
+  movs  r7, #0
+  mov   r8, r3
+  mov   r9, r3
+  mov   r10, r3
+  mov   r11, r3
+  mov   r12, r3
+
+LoopZeroTable:
+  cmp   r4, r5
+  bhs   ZeroTableDone
+  ldmia r4!, {r0, r2}
+  subs  r2, r2, #32
+  blo   ZeroTail
+
+ZeroBurst:
+  stmia r0!, {r3, r6-r12}
+  subs  r2, r2, #32
+  bhs   ZeroBurst
+
+ZeroTail:
+  adds  r2, r2, #32
+  beq   LoopZeroTable
+
+ZeroWord:
+  str   r3, [r0], #4
+  subs  r2, r2, #4
+  bne   ZeroWord
+  b     LoopZeroTable
+
+ZeroTableDone:
+
+/* Take the exceptions from the vector table copy in SRAM, copied above through the copy table */
+  ldr   r0, =0xE000ED08        /* SCB->VTOR */
+  ldr   r1, =_sram_vector
+  str   r1, [r0]
+  dsb
+  isb
 
 /* Call static constructors */
   bl __libc_init_array
+/* Record the number of cycles spent before main() (see profile.c) */
+  ldr   r0, =0xE0001004        /* DWT->CYCCNT */
+  ldr   r1, [r0]
+  ldr   r0, =g_reset_handler_cycles
+  str   r1, [r0]
 /* Call the application's entry point.*/
   bl main
 
@@ -1,17 +1,45 @@
 #include <stdint.h>
 
+/* Registers of The DWT Cycle Counter Used to Measure The Time Spent Before main() */
+#define DEMCR              (*(volatile uint32_t *)0xE000EDFCU)
+#define DEMCR_TRCENA       (1U << 24)
+#define DWT_CTRL           (*(volatile uint32_t *)0xE0001000U)
+#define DWT_CTRL_CYCCNTENA (1U << 0)
+#define DWT_CYCCNT         (*(volatile uint32_t *)0xE0001004U)
+
+/* Vector Table Offset Register */
+#define SCB_VTOR           (*(volatile uint32_t *)0xE000ED08U)
+
+/* Entry of The Copy Table: A Region Copied from FLASH to SRAM */
+typedef struct {
+    const uint32_t *src; // Load address in FLASH
+    uint32_t *dest;      // Run address in SRAM
+    uint32_t size;       // Size in bytes, a multiple of 4
+} startup_copy_entry_t;
+
+/* Entry of The Zero Table: A Region Cleared in SRAM */
+typedef struct {
+    uint32_t *dest; // Run address in SRAM
+    uint32_t size;  // Size in bytes, a multiple of 4
+} startup_zero_entry_t;
+
 /* External Symbols defined in The Linker Script */
 extern uint32_t _estack;
-extern uint32_t _etext;
-extern uint32_t _sdata;
-extern uint32_t _edata;
-extern uint32_t _sbss;
-extern uint32_t _ebss;
+extern uint32_t _sram_vector;
+extern const startup_copy_entry_t _scopy_table[];
+extern const startup_copy_entry_t _ecopy_table[];
+extern const startup_zero_entry_t _szero_table[];
+extern const startup_zero_entry_t _ezero_table[];
+
+/* Number of Cycles Spent in Reset_Handler Before main() (defined in profile.c) */
+extern uint32_t g_reset_handler_cycles;
 
 /* Function Prototypes */
 void Reset_Handler(void);
 void Default_Handler(void);
 int main(void);
+static void startup_copy(uint32_t *dest, const uint32_t *src, uint32_t size);
+static void startup_zero(uint32_t *dest, uint32_t size);
 
 /* Exception and Interrupt Handlers with Specific Attributes */
 void NMI_Handler(void) __attribute__((weak, alias("Default_Handler")));
@@ -199,28 +227,79 @@ void Default_Handler(void) {
 
 /* Reset Handler */
 /* It prepares the system before executing the main application. */
+/* The regions to initialize are listed by the linker script in a copy table and a zero table, so new regions only
+   need a table entry. Sections that are in neither table (.noinit) keep their content across a reset. */
 void Reset_Handler(void) {
-    // Calculate the sizes of the .data and .bss sections
-    uint32_t data_mem_size = (uint32_t)&_edata - (uint32_t)&_sdata;  // It is used to copy initialized data from FLASH to SRAM.
-    uint32_t bss_mem_size = (uint32_t)&_ebss - (uint32_t)&_sbss;     // It is used to zero out the .bss section in SRAM.
+    // Start the DWT cycle counter to measure the time spent until main()
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
 
-    // Initialize pointers to the source and destination of the .data section
-    uint32_t *p_src_mem = (uint32_t *)&_etext;  // A source pointer to the address where initialized data is stored in flash memory
-    uint32_t *p_dest_mem = (uint32_t *)&_sdata; // A destination pointer to the start of the .data section in SRAM
+    // Copy the initialized regions (vector table, .ramfunc, .data) from FLASH to SRAM
+    for (const startup_copy_entry_t *entry = _scopy_table; entry < _ecopy_table; entry++) {
+        startup_copy(entry->dest, entry->src, entry->size);
+    }
 
-    // Copy .data section from FLASH to SRAM word by word
-    for (uint32_t i = 0; i < data_mem_size; i++) {
-        *p_dest_mem++ = *p_src_mem++;
+    // Clear the zero-initialized regions (.bss) in SRAM
+    for (const startup_zero_entry_t *entry = _szero_table; entry < _ezero_table; entry++) {
+        startup_zero(entry->dest, entry->size);
     }
 
-    // Initialize the .bss section to zero in SRAM word by word
-    p_dest_mem = (uint32_t *)&_sbss;
+    // Take the exceptions from the vector table copy in SRAM
+    SCB_VTOR = (uint32_t)&_sram_vector;
+    __asm volatile ("dsb\n isb" ::: "memory");
 
-    for (uint32_t i = 0; i < bss_mem_size; i++) {
-        // Set .bss section to zero
-        *p_dest_mem++ = 0;
-    }
+    // Record the boot time, .bss is cleared by now
+    g_reset_handler_cycles = DWT_CYCCNT;
 
     // Call the application's main function to begin the application execution
     main();
 }
+
+/* Copy a region of size bytes, eight words per LDM/STM burst and the remaining words one by one */
+__attribute__((naked)) static void startup_copy(uint32_t *dest, const uint32_t *src, uint32_t size) {
+    __asm volatile (
+        "    push  {r4-r10}             \n"
+        "    subs  r2, r2, #32          \n"
+        "    blo   2f                   \n"
+        "1:  ldmia r1!, {r3-r10}        \n"
+        "    stmia r0!, {r3-r10}        \n"
+        "    subs  r2, r2, #32          \n"
+        "    bhs   1b                   \n"
+        "2:  adds  r2, r2, #32          \n"
+        "    beq   4f                   \n"
+        "3:  ldr   r3, [r1], #4         \n"
+        "    str   r3, [r0], #4         \n"
+        "    subs  r2, r2, #4           \n"
+        "    bne   3b                   \n"
+        "4:  pop   {r4-r10}             \n"
+        "    bx    lr                   \n"
+    );
+}
+
+/* Clear a region of size bytes, eight words per STM burst and the remaining words one by one */
+__attribute__((naked)) static void startup_zero(uint32_t *dest, uint32_t size) {
+    __asm volatile (
+        "    push  {r4-r9}              \n"
+        "    movs  r2, #0               \n"
+        "    movs  r3, #0               \n"
+        "    movs  r4, #0               \n"
+        "    movs  r5, #0               \n"
+        "    movs  r6, #0               \n"
+        "    movs  r7, #0               \n"
+        "    mov   r8, r2               \n"
+        "    mov   r9, r2               \n"
+        "    subs  r1, r1, #32          \n"
+        "    blo   2f                   \n"
+        "1:  stmia r0!, {r2-r9}         \n"
+        "    subs  r1, r1, #32          \n"
+        "    bhs   1b                   \n"
+        "2:  adds  r1, r1, #32          \n"
+        "    beq   4f                   \n"
+        "3:  str   r2, [r0], #4         \n"
+        "    subs  r1, r1, #4           \n"
+        "    bne   3b                   \n"
+        "4:  pop   {r4-r9}              \n"
+        "    bx    lr                   \n"
+    );
+}
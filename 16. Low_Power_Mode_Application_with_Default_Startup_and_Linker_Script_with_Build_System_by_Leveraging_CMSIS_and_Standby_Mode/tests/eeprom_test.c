@@ -0,0 +1,211 @@
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+#include "eeprom.h"
+
+/* Host test of the 24Cxx EEPROM driver against a model of the device
+ * The model replaces the I2C1 functions used by eeprom.c. Like a real 24Cxx it wraps a page write that
+ * runs past the end of its page to the start of the same page, takes the upper address bits of one-byte
+ * address devices from the block select bits, and does not acknowledge its address for a number of polls
+ * after every write cycle.
+ */
+
+// Macro to define the largest modelled memory (24C256)
+#define MODEL_MAX_CAPACITY 32768U
+
+// Macro to define the number of polls the model stays busy after a page write
+#define MODEL_BUSY_POLLS 3U
+
+// Macro to make the model stay busy forever
+#define MODEL_BUSY_FOREVER UINT32_MAX
+
+// State of the modelled EEPROM
+typedef struct {
+    const eeprom_t *dev;              // Geometry of the modelled device
+    uint8_t mem[MODEL_MAX_CAPACITY];  // Memory array
+    uint32_t busy_polls;              // Remaining polls without acknowledge
+    uint32_t busy_polls_per_write;    // Busy polls loaded by every write
+    uint32_t writes;                  // Number of page writes
+    uint32_t writes_while_busy;       // Page writes issued before the previous write cycle ended
+    uint32_t polls;                   // Number of address polls
+    uint32_t max_write_len;           // Longest page write in bytes
+} eeprom_model_t;
+
+static eeprom_model_t model;
+
+static const eeprom_t eeprom_24c02 = { EEPROM_24CXX_ADDR, 1U, 8U, 256U };
+static const eeprom_t eeprom_24c16 = { EEPROM_24CXX_ADDR, 1U, 16U, 2048U };
+static const eeprom_t eeprom_24c256 = { EEPROM_24CXX_ADDR, 2U, 64U, 32768U };
+
+static void model_reset(const eeprom_t *dev, uint32_t busy_polls_per_write);
+static uint32_t model_address(uint8_t saddr, uint16_t maddr);
+static void test_page_split(const eeprom_t *dev, uint32_t addr, uint32_t n);
+static void test_block_select(void);
+static void test_poll_timeout(void);
+static void test_invalid_range(void);
+
+i2c_status_t i2c1_mem_write(uint8_t saddr, uint16_t maddr, uint8_t maddr_len, uint32_t n, const uint8_t *data) {
+    uint32_t addr = model_address(saddr, maddr);
+    uint32_t page_start = addr - (addr % model.dev->page_size);
+
+    TEST_CHECK(maddr_len == model.dev->addr_bytes);
+
+    if (model.busy_polls != 0U) {
+        model.writes_while_busy++;
+        return I2C_ERR_AF;
+    }
+
+    // The address counter only wraps within the current page
+    for (uint32_t i = 0; i < n; i++) {
+        model.mem[page_start + ((addr - page_start + i) % model.dev->page_size)] = data[i];
+    }
+
+    model.writes++;
+    model.busy_polls = model.busy_polls_per_write;
+
+    if (n > model.max_write_len) {
+        model.max_write_len = n;
+    }
+
+    return I2C_OK;
+}
+
+i2c_status_t i2c1_mem_read(uint8_t saddr, uint16_t maddr, uint8_t maddr_len, uint32_t n, uint8_t *data) {
+    uint32_t addr = model_address(saddr, maddr);
+
+    TEST_CHECK(maddr_len == model.dev->addr_bytes);
+
+    // Sequential reads roll over at the end of the memory
+    for (uint32_t i = 0; i < n; i++) {
+        data[i] = model.mem[(addr + i) % model.dev->capacity];
+    }
+
+    return I2C_OK;
+}
+
+i2c_status_t i2c1_is_device_ready(uint8_t saddr) {
+    TEST_CHECK((saddr & ~0x07U) == model.dev->saddr);
+
+    model.polls++;
+
+    if (model.busy_polls != 0U) {
+        if (model.busy_polls != MODEL_BUSY_FOREVER) {
+            model.busy_polls--;
+        }
+
+        return I2C_ERR_AF;
+    }
+
+    return I2C_OK;
+}
+
+int main(void) {
+    // Writes that start and end inside a page, on a page boundary and across several pages
+    test_page_split(&eeprom_24c02, 0U, 8U);
+    test_page_split(&eeprom_24c02, 3U, 4U);
+    test_page_split(&eeprom_24c02, 5U, 20U);
+    test_page_split(&eeprom_24c02, 0U, 256U);
+    test_page_split(&eeprom_24c256, 60U, 200U);
+    test_page_split(&eeprom_24c256, 32768U - 70U, 70U);
+
+    test_block_select();
+    test_poll_timeout();
+    test_invalid_range();
+
+    return TEST_RESULT("eeprom_test");
+}
+
+static void model_reset(const eeprom_t *dev, uint32_t busy_polls_per_write) {
+    memset(&model, 0, sizeof(model));
+    memset(model.mem, 0xFF, sizeof(model.mem));
+
+    model.dev = dev;
+    model.busy_polls_per_write = busy_polls_per_write;
+}
+
+static uint32_t model_address(uint8_t saddr, uint16_t maddr) {
+    // One-byte address devices select the 256-byte block with the low bits of the device address
+    if (model.dev->addr_bytes == 1U) {
+        return ((uint32_t)(saddr & 0x07U) << 8) | (maddr & 0xFFU);
+    }
+
+    return maddr;
+}
+
+static void test_page_split(const eeprom_t *dev, uint32_t addr, uint32_t n) {
+    static uint8_t data[MODEL_MAX_CAPACITY];
+    static uint8_t readback[MODEL_MAX_CAPACITY];
+    uint32_t first_page = addr / dev->page_size;
+    uint32_t last_page = (addr + n - 1U) / dev->page_size;
+
+    model_reset(dev, MODEL_BUSY_POLLS);
+
+    for (uint32_t i = 0; i < n; i++) {
+        data[i] = (uint8_t)((i * 7U) + 1U);
+    }
+
+    TEST_CHECK(eeprom_write(dev, addr, n, data) == I2C_OK);
+
+    // One page write per touched page, each one waited for with acknowledge polling
+    TEST_CHECK(model.writes == (last_page - first_page + 1U));
+    TEST_CHECK(model.writes_while_busy == 0U);
+    TEST_CHECK(model.max_write_len <= dev->page_size);
+    TEST_CHECK(model.polls == model.writes * (MODEL_BUSY_POLLS + 1U));
+
+    // Nothing wrapped around inside a page and nothing around the range was touched
+    TEST_CHECK(memcmp(&model.mem[addr], data, n) == 0);
+    TEST_CHECK((addr == 0U) || (model.mem[addr - 1U] == 0xFFU));
+    TEST_CHECK(((addr + n) >= dev->capacity) || (model.mem[addr + n] == 0xFFU));
+
+    memset(readback, 0, n);
+    TEST_CHECK(eeprom_read(dev, addr, n, readback) == I2C_OK);
+    TEST_CHECK(memcmp(readback, data, n) == 0);
+}
+
+static void test_block_select(void) {
+    static uint8_t data[2048];
+    static uint8_t readback[2048];
+
+    // Fill the whole 24C16, the eight 256-byte blocks are addressed through the block select bits
+    model_reset(&eeprom_24c16, 0U);
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)((i >> 8) ^ (i * 3U));
+    }
+
+    TEST_CHECK(eeprom_write(&eeprom_24c16, 0U, sizeof(data), data) == I2C_OK);
+    TEST_CHECK(memcmp(model.mem, data, sizeof(data)) == 0);
+
+    // A sequential read across the boundary of blocks 2 and 3 is split into one read per block
+    TEST_CHECK(eeprom_read(&eeprom_24c16, 0x2F0U, 0x20U, readback) == I2C_OK);
+    TEST_CHECK(memcmp(readback, &data[0x2F0U], 0x20U) == 0);
+
+    TEST_CHECK(eeprom_read(&eeprom_24c16, 0U, sizeof(readback), readback) == I2C_OK);
+    TEST_CHECK(memcmp(readback, data, sizeof(data)) == 0);
+}
+
+static void test_poll_timeout(void) {
+    uint8_t data[16] = { 0 };
+
+    // A device that never finishes its write cycle ends the write with a timeout after a bounded poll count
+    model_reset(&eeprom_24c02, MODEL_BUSY_FOREVER);
+
+    TEST_CHECK(eeprom_write(&eeprom_24c02, 0U, 16U, data) == I2C_ERR_TIMEOUT);
+    TEST_CHECK(model.writes == 1U);
+    TEST_CHECK(model.polls == 100U); // EEPROM_MAX_READY_POLLS
+
+    // The busy device does not answer the next write either
+    TEST_CHECK(eeprom_wait_ready(&eeprom_24c02) == I2C_ERR_TIMEOUT);
+    TEST_CHECK(model.polls == 200U);
+}
+
+static void test_invalid_range(void) {
+    uint8_t data[4] = { 0 };
+
+    model_reset(&eeprom_24c02, 0U);
+
+    TEST_CHECK(eeprom_write(&eeprom_24c02, 254U, 4U, data) == I2C_ERR_INVALID);
+    TEST_CHECK(eeprom_read(&eeprom_24c02, 257U, 1U, data) == I2C_ERR_INVALID);
+    TEST_CHECK(eeprom_write(&eeprom_24c02, 256U, 0U, data) == I2C_OK);
+    TEST_CHECK(model.writes == 0U);
+}
@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include "test.h"
+#include "profile.h"
+
+/* Host test of the profiling statistics
+ * profile.c is built with PROFILE_HOST, so the probes read profile_host_cycles instead of DWT->CYCCNT
+ * and the test advances the counter by hand between start and stop.
+ */
+
+// Probe measured by scoped_section()
+static profile_probe_t scope_probe = PROFILE_PROBE_INIT("scope");
+
+static void test_record(void);
+static void test_start_stop(void);
+static void test_scope(void);
+static void scoped_section(uint32_t cycles);
+
+int main(void) {
+    // A constant counter makes the calibrated probe overhead 0, so the samples are reported unchanged
+    profile_host_cycles = 1000U;
+    profile_init();
+    TEST_CHECK(profile_get_overhead() == 0U);
+
+    test_record();
+    test_start_stop();
+    test_scope();
+
+    return TEST_RESULT("profile_test");
+}
+
+static void test_record(void) {
+    static const uint32_t samples[] = { 40U, 10U, 25U, 31U, 10U, 90U };
+    profile_probe_t probe = PROFILE_PROBE_INIT("record");
+
+    // An empty probe reports a mean of 0 and its initial min/max
+    TEST_CHECK(probe.count == 0U);
+    TEST_CHECK(profile_mean(&probe) == 0U);
+    TEST_CHECK(probe.min == UINT32_MAX);
+    TEST_CHECK(probe.max == 0U);
+
+    for (uint32_t i = 0; i < (sizeof(samples) / sizeof(samples[0])); i++) {
+        profile_record(&probe, samples[i]);
+    }
+
+    TEST_CHECK(probe.count == 6U);
+    TEST_CHECK(probe.min == 10U);
+    TEST_CHECK(probe.max == 90U);
+    TEST_CHECK(probe.total == 206U);
+
+    // 206 / 6 = 34.33 is rounded down, 207 / 7 = 29.57 is rounded up
+    TEST_CHECK(profile_mean(&probe) == 34U);
+    profile_record(&probe, 1U);
+    TEST_CHECK(profile_mean(&probe) == 30U);
+
+    // The total is 64 bits wide, so long runs of large samples do not overflow it
+    profile_probe_reset(&probe, "large");
+    TEST_CHECK(probe.count == 0U);
+    TEST_CHECK(probe.min == UINT32_MAX);
+
+    for (uint32_t i = 0; i < 4U; i++) {
+        profile_record(&probe, UINT32_MAX);
+    }
+
+    TEST_CHECK(probe.total == (4ULL * UINT32_MAX));
+    TEST_CHECK(profile_mean(&probe) == UINT32_MAX);
+}
+
+static void test_start_stop(void) {
+    profile_probe_t probe = PROFILE_PROBE_INIT("start/stop");
+
+    profile_host_cycles = 500U;
+    profile_start(&probe);
+    profile_host_cycles += 123U;
+    profile_stop(&probe);
+
+    TEST_CHECK(probe.count == 1U);
+    TEST_CHECK(probe.min == 123U);
+    TEST_CHECK(probe.max == 123U);
+
+    // A measurement across the wrap of the 32-bit counter still yields the elapsed cycles
+    profile_host_cycles = UINT32_MAX - 9U;
+    profile_start(&probe);
+    profile_host_cycles += 30U;
+    profile_stop(&probe);
+
+    TEST_CHECK(probe.count == 2U);
+    TEST_CHECK(probe.min == 30U);
+    TEST_CHECK(probe.max == 123U);
+    TEST_CHECK(profile_mean(&probe) == 77U);
+}
+
+static void test_scope(void) {
+    // The scoped probe stops when the block is left
+    scoped_section(70U);
+    scoped_section(50U);
+
+    TEST_CHECK(scope_probe.count == 2U);
+    TEST_CHECK(scope_probe.min == 50U);
+    TEST_CHECK(scope_probe.max == 70U);
+    TEST_CHECK(profile_mean(&scope_probe) == 60U);
+}
+
+static void scoped_section(uint32_t cycles) {
+    PROFILE_SCOPE(scope_probe);
+
+    profile_host_cycles += cycles;
+}
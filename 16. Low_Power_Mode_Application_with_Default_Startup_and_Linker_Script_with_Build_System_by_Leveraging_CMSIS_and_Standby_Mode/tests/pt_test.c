@@ -0,0 +1,288 @@
+#include <stdint.h>
+#include "test.h"
+#include "pt.h"
+
+/* Host test of the protothread macros and the run queue
+ * Every thread records how far it got in a step counter, so the test can check after each
+ * pt_sched_run() pass which wait point a thread stopped at. The test supplies millis() and advances it
+ * by hand for PT_DELAY(), and posts the driver events with pt_sched_signal() as the interrupts would.
+ */
+
+// Tick counter returned by millis()
+static uint32_t test_now;
+
+// Condition of the PT_WAIT_UNTIL() thread
+static uint8_t test_ready;
+
+// Progress of the test threads
+static uint32_t yield_steps;
+static uint32_t wait_steps;
+static uint32_t delay_steps;
+static uint32_t event_steps;
+static uint32_t child_steps;
+static uint32_t parent_steps;
+
+static uint8_t yield_thread(pt_t *pt, void *arg);
+static uint8_t wait_thread(pt_t *pt, void *arg);
+static uint8_t delay_thread(pt_t *pt, void *arg);
+static uint8_t event_thread(pt_t *pt, void *arg);
+static uint8_t child_thread(pt_t *pt, void *arg);
+static uint8_t parent_thread(pt_t *pt, void *arg);
+static uint8_t exit_thread(pt_t *pt, void *arg);
+static void test_yield(void);
+static void test_wait_until(void);
+static void test_delay(uint32_t start);
+static void test_signal(void);
+static void test_spawn(void);
+static void test_queue_limits(void);
+
+void systick_init(void) {
+}
+
+uint32_t millis(void) {
+    return test_now;
+}
+
+int main(void) {
+    test_yield();
+    test_wait_until();
+    test_delay(1000U);
+
+    // The deadline wraps around 2^32 during the delay
+    test_delay(UINT32_MAX - 4U);
+
+    test_signal();
+    test_spawn();
+    test_queue_limits();
+
+    return TEST_RESULT("pt_test");
+}
+
+static uint8_t yield_thread(pt_t *pt, void *arg) {
+    (void)arg;
+
+    PT_BEGIN(pt);
+    yield_steps++;
+    PT_YIELD(pt);
+    yield_steps++;
+    PT_YIELD(pt);
+    yield_steps++;
+    PT_END(pt);
+}
+
+static uint8_t wait_thread(pt_t *pt, void *arg) {
+    (void)arg;
+
+    PT_BEGIN(pt);
+    wait_steps++;
+    PT_WAIT_UNTIL(pt, test_ready);
+    wait_steps++;
+    PT_END(pt);
+}
+
+static uint8_t delay_thread(pt_t *pt, void *arg) {
+    (void)arg;
+
+    PT_BEGIN(pt);
+    PT_DELAY(pt, 10U);
+    delay_steps++;
+    PT_END(pt);
+}
+
+static uint8_t event_thread(pt_t *pt, void *arg) {
+    (void)arg;
+
+    PT_BEGIN(pt);
+    event_steps++;
+    PT_AWAIT_EVENT(pt, PT_EVENT_UART2_RX);
+    event_steps++;
+    PT_AWAIT_EVENT(pt, PT_EVENT_UART2_TX | PT_EVENT_UART2_TC);
+    event_steps++;
+    PT_END(pt);
+}
+
+static uint8_t child_thread(pt_t *pt, void *arg) {
+    (void)arg;
+
+    PT_BEGIN(pt);
+    child_steps++;
+    PT_AWAIT_EVENT(pt, PT_EVENT_UART2_TX);
+    child_steps++;
+    PT_YIELD(pt);
+    child_steps++;
+    PT_END(pt);
+}
+
+static uint8_t parent_thread(pt_t *pt, void *arg) {
+    // The child's continuation lives in the argument, locals do not survive a wait point
+    pt_t *child = (pt_t *)arg;
+
+    PT_BEGIN(pt);
+    parent_steps++;
+    PT_SPAWN(pt, child, child_thread(child, NULL));
+    parent_steps++;
+    PT_END(pt);
+}
+
+static uint8_t exit_thread(pt_t *pt, void *arg) {
+    (void)arg;
+
+    PT_BEGIN(pt);
+    PT_EXIT(pt);
+    PT_END(pt);
+}
+
+static void test_yield(void) {
+    pt_task_t task;
+
+    pt_sched_init();
+    yield_steps = 0;
+    TEST_CHECK(pt_sched_add(&task, yield_thread, NULL));
+
+    // Each pass runs the thread up to its next PT_YIELD()
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(yield_steps == 1U);
+    TEST_CHECK(pt_sched_count() == 1U);
+
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(yield_steps == 2U);
+
+    // PT_END() removes the thread from the queue
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(yield_steps == 3U);
+    TEST_CHECK(pt_sched_count() == 0U);
+    TEST_CHECK(pt_sched_run() == 0U);
+
+    // A yielding thread called directly returns PT_YIELDED and restarts after PT_END()
+    pt_t pt;
+    PT_INIT(&pt);
+    yield_steps = 0;
+    TEST_CHECK(yield_thread(&pt, NULL) == PT_YIELDED);
+    TEST_CHECK(yield_thread(&pt, NULL) == PT_YIELDED);
+    TEST_CHECK(yield_thread(&pt, NULL) == PT_ENDED);
+    TEST_CHECK(pt.lc == 0U);
+    TEST_CHECK(yield_thread(&pt, NULL) == PT_YIELDED);
+    TEST_CHECK(yield_steps == 4U);
+}
+
+static void test_wait_until(void) {
+    pt_t pt;
+
+    PT_INIT(&pt);
+    wait_steps = 0;
+    test_ready = 0;
+
+    // The condition is evaluated on every call, the code before the wait point runs only once
+    TEST_CHECK(wait_thread(&pt, NULL) == PT_WAITING);
+    TEST_CHECK(wait_thread(&pt, NULL) == PT_WAITING);
+    TEST_CHECK(wait_steps == 1U);
+
+    test_ready = 1;
+    TEST_CHECK(wait_thread(&pt, NULL) == PT_ENDED);
+    TEST_CHECK(wait_steps == 2U);
+}
+
+static void test_delay(uint32_t start) {
+    pt_task_t task;
+
+    pt_sched_init();
+    test_now = start;
+    delay_steps = 0;
+    TEST_CHECK(pt_sched_add(&task, delay_thread, NULL));
+
+    // A polling thread is called on every pass, but stays in PT_DELAY() for 10 ms
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(delay_steps == 0U);
+
+    test_now += 9U;
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(delay_steps == 0U);
+    TEST_CHECK(pt_sched_count() == 1U);
+
+    test_now += 1U;
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(delay_steps == 1U);
+    TEST_CHECK(pt_sched_count() == 0U);
+}
+
+static void test_signal(void) {
+    pt_task_t task;
+
+    pt_sched_init();
+    event_steps = 0;
+    TEST_CHECK(pt_sched_add(&task, event_thread, NULL));
+
+    // The first pass reaches the wait point, after that the thread is skipped until its event arrives
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(event_steps == 1U);
+    TEST_CHECK(task.pt.wait == PT_EVENT_UART2_RX);
+    TEST_CHECK(pt_sched_run() == 0U);
+
+    // Other events do not wake it
+    pt_sched_signal(PT_EVENT_UART2_TX);
+    TEST_CHECK(pt_sched_run() == 0U);
+    TEST_CHECK(event_steps == 1U);
+
+    // Events posted between two passes are collected and delivered to the next one only. TC arrives
+    // before the thread waits for it and must not complete the second wait
+    pt_sched_signal(PT_EVENT_UART2_TC);
+    pt_sched_signal(PT_EVENT_UART2_RX);
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(event_steps == 2U);
+    TEST_CHECK(task.pt.wait == (PT_EVENT_UART2_TX | PT_EVENT_UART2_TC));
+    TEST_CHECK(pt_sched_events == 0U);
+    TEST_CHECK(pt_sched_run() == 0U);
+
+    // Any of the awaited events completes the second wait
+    pt_sched_signal(PT_EVENT_UART2_TC);
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK(event_steps == 3U);
+    TEST_CHECK(pt_sched_count() == 0U);
+}
+
+static void test_spawn(void) {
+    pt_task_t task;
+    pt_t child;
+
+    pt_sched_init();
+    parent_steps = 0;
+    child_steps = 0;
+    TEST_CHECK(pt_sched_add(&task, parent_thread, &child));
+
+    // The parent starts the child and takes over the event the child waits for
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK((parent_steps == 1U) && (child_steps == 1U));
+    TEST_CHECK(task.pt.wait == PT_EVENT_UART2_TX);
+    TEST_CHECK(pt_sched_run() == 0U);
+
+    // The event resumes the child up to its PT_YIELD(), the parent waits on with a polling child
+    pt_sched_signal(PT_EVENT_UART2_TX);
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK((parent_steps == 1U) && (child_steps == 2U));
+    TEST_CHECK(task.pt.wait == 0U);
+
+    // The child ends, the parent continues after PT_SPAWN() in the same call
+    TEST_CHECK(pt_sched_run() == 1U);
+    TEST_CHECK((parent_steps == 2U) && (child_steps == 3U));
+    TEST_CHECK(pt_sched_count() == 0U);
+}
+
+static void test_queue_limits(void) {
+    static pt_task_t tasks[17];
+
+    pt_sched_init();
+
+    // The run queue holds 16 threads
+    for (uint32_t i = 0; i < 16U; i++) {
+        TEST_CHECK(pt_sched_add(&tasks[i], (i == 5U) ? exit_thread : yield_thread, NULL));
+    }
+
+    TEST_CHECK(!pt_sched_add(&tasks[16], yield_thread, NULL));
+
+    // PT_EXIT() removes its thread and the others keep their places
+    yield_steps = 0;
+    TEST_CHECK(pt_sched_run() == 16U);
+    TEST_CHECK(pt_sched_count() == 15U);
+    TEST_CHECK(yield_steps == 15U);
+    TEST_CHECK(pt_sched_add(&tasks[16], yield_thread, NULL));
+}
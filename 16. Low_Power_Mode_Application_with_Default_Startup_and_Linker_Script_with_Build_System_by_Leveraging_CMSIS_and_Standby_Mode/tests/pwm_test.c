@@ -0,0 +1,161 @@
+#include <stdint.h>
+#include "test.h"
+#include "pwm.h"
+
+/* Host test of the PWM frequency and resolution math
+ * pwm_compute_timing() is checked over a sweep of frequencies in both alignments: the counter length fits
+ * the 16-bit registers, the prescaler is the smallest one that does, and the frequency error stays within
+ * the rounding of the counter length. The duty cycle and dead-time conversions are checked against their
+ * register definitions.
+ */
+
+static void test_timing_sweep(uint32_t clk_hz, pwm_align_t align);
+static void test_timing(uint32_t clk_hz, uint32_t freq_hz, pwm_align_t align);
+static void test_timing_limits(void);
+static void test_duty_to_compare(void);
+static void test_deadtime_to_dtg(void);
+static uint32_t dtg_to_ticks(uint8_t dtg);
+
+int main(void) {
+    test_timing_sweep(PWM_TIM_CLK, PWM_ALIGN_EDGE);
+    test_timing_sweep(PWM_TIM_CLK, PWM_ALIGN_CENTER);
+    test_timing_sweep(100000000U, PWM_ALIGN_EDGE);
+    test_timing_sweep(100000000U, PWM_ALIGN_CENTER);
+    test_timing_limits();
+    test_duty_to_compare();
+    test_deadtime_to_dtg();
+
+    return TEST_RESULT("pwm_test");
+}
+
+static void test_timing_sweep(uint32_t clk_hz, pwm_align_t align) {
+    // Every frequency up to 2 kHz, then a geometric sweep up to the fastest possible one
+    for (uint32_t freq_hz = 1U; freq_hz <= 2000U; freq_hz++) {
+        test_timing(clk_hz, freq_hz, align);
+    }
+
+    for (uint32_t freq_hz = 2000U; freq_hz <= (clk_hz / 2U); freq_hz += (freq_hz / 64U)) {
+        test_timing(clk_hz, freq_hz, align);
+    }
+}
+
+static void test_timing(uint32_t clk_hz, uint32_t freq_hz, pwm_align_t align) {
+    pwm_timing_t timing;
+    uint32_t divisor = (align == PWM_ALIGN_CENTER) ? (2U * freq_hz) : freq_hz;
+    uint32_t clocks_per_step = (align == PWM_ALIGN_CENTER) ? 2U : 1U;
+    uint32_t max_length = (align == PWM_ALIGN_CENTER) ? PWM_ARR_MAX : (PWM_ARR_MAX + 1U);
+
+    // Frequencies with fewer than two counter clocks per period are refused
+    if ((clk_hz / divisor) < 2U) {
+        TEST_CHECK(pwm_compute_timing(clk_hz, freq_hz, align, &timing) == 0U);
+        return;
+    }
+
+    TEST_CHECK(pwm_compute_timing(clk_hz, freq_hz, align, &timing) == 1U);
+
+    // The register values describe the reported resolution, a wrapped ARR would not
+    uint32_t length = (align == PWM_ALIGN_CENTER) ? timing.arr : (timing.arr + 1U);
+    TEST_CHECK(timing.steps == length);
+    TEST_CHECK((length >= 2U) && (length <= max_length));
+
+    // The next smaller prescaler cannot hold the period
+    if (timing.psc != 0U) {
+        TEST_CHECK(((double)clk_hz / ((double)divisor * timing.psc)) > (double)max_length);
+    }
+
+    // The frequency error is at most half a counter clock per period
+    double actual = (double)clk_hz / ((double)(timing.psc + 1U) * clocks_per_step * length);
+    double error = (actual > freq_hz) ? (actual - freq_hz) : (freq_hz - actual);
+    TEST_CHECK(error <= ((double)freq_hz * 0.5 / ((double)length - 0.5)));
+
+    // The reported frequency is the actual one rounded down
+    double reported = pwm_timing_frequency(clk_hz, &timing, align);
+    TEST_CHECK((reported <= (actual + 1e-6)) && (reported > (actual - 1.0)));
+}
+
+static void test_timing_limits(void) {
+    pwm_timing_t timing;
+
+    // 16 MHz: 1 Hz is the slowest, 8 MHz edge-aligned and 4 MHz center-aligned the fastest frequency
+    TEST_CHECK(pwm_compute_timing(PWM_TIM_CLK, 1U, PWM_ALIGN_EDGE, &timing) == 1U);
+    TEST_CHECK((timing.psc == 244U) && (timing.arr == 65305U));
+    TEST_CHECK(pwm_compute_timing(PWM_TIM_CLK, 8000000U, PWM_ALIGN_EDGE, &timing) == 1U);
+    TEST_CHECK((timing.psc == 0U) && (timing.arr == 1U) && (timing.steps == 2U));
+    TEST_CHECK(pwm_compute_timing(PWM_TIM_CLK, 8000001U, PWM_ALIGN_EDGE, &timing) == 0U);
+    TEST_CHECK(pwm_compute_timing(PWM_TIM_CLK, 4000000U, PWM_ALIGN_CENTER, &timing) == 1U);
+    TEST_CHECK((timing.psc == 0U) && (timing.arr == 2U));
+    TEST_CHECK(pwm_compute_timing(PWM_TIM_CLK, 4000001U, PWM_ALIGN_CENTER, &timing) == 0U);
+    TEST_CHECK(pwm_compute_timing(PWM_TIM_CLK, 0U, PWM_ALIGN_EDGE, &timing) == 0U);
+
+    // 1 kHz edge-aligned divides 16 MHz exactly
+    TEST_CHECK(pwm_compute_timing(PWM_TIM_CLK, 1000U, PWM_ALIGN_EDGE, &timing) == 1U);
+    TEST_CHECK((timing.psc == 0U) && (timing.arr == 15999U) && (timing.steps == 16000U));
+    TEST_CHECK(pwm_timing_frequency(PWM_TIM_CLK, &timing, PWM_ALIGN_EDGE) == 1000U);
+
+    // 65535.7 clocks per half period round to a length of 65536, which ARR cannot hold center-aligned
+    TEST_CHECK(pwm_compute_timing(13107140U, 100U, PWM_ALIGN_CENTER, &timing) == 1U);
+    TEST_CHECK((timing.psc == 1U) && (timing.arr == 32768U) && (timing.steps == 32768U));
+
+    // The same counter length fits edge-aligned without a prescaler
+    TEST_CHECK(pwm_compute_timing(6553570U, 100U, PWM_ALIGN_EDGE, &timing) == 1U);
+    TEST_CHECK((timing.psc == 0U) && (timing.arr == 65535U) && (timing.steps == 65536U));
+
+    // A period longer than the largest prescaler allows is refused
+    TEST_CHECK(pwm_compute_timing(0xFFFFFFFFU, 1U, PWM_ALIGN_CENTER, &timing) == 0U);
+}
+
+static void test_duty_to_compare(void) {
+    // Edge-aligned ARR = 999 gives 1000 steps, CCR = 1000 keeps the output active for the whole period
+    TEST_CHECK(pwm_duty_to_compare(999U, PWM_ALIGN_EDGE, 0U) == 0U);
+    TEST_CHECK(pwm_duty_to_compare(999U, PWM_ALIGN_EDGE, 2500U) == 250U);
+    TEST_CHECK(pwm_duty_to_compare(999U, PWM_ALIGN_EDGE, PWM_DUTY_FULL) == 1000U);
+    TEST_CHECK(pwm_duty_to_compare(999U, PWM_ALIGN_EDGE, PWM_DUTY_FULL + 1U) == 1000U);
+
+    // Center-aligned ARR = 1000 gives 1000 steps as well
+    TEST_CHECK(pwm_duty_to_compare(1000U, PWM_ALIGN_CENTER, 5000U) == 500U);
+    TEST_CHECK(pwm_duty_to_compare(1000U, PWM_ALIGN_CENTER, PWM_DUTY_FULL) == 1000U);
+
+    // Coarse resolutions round to the nearest step, 0.05 % of 16 steps is 0.008 steps
+    TEST_CHECK(pwm_duty_to_compare(15U, PWM_ALIGN_EDGE, 5U) == 0U);
+    TEST_CHECK(pwm_duty_to_compare(15U, PWM_ALIGN_EDGE, 3125U) == 5U);
+
+    // The full 16-bit range does not overflow
+    TEST_CHECK(pwm_duty_to_compare(PWM_ARR_MAX, PWM_ALIGN_EDGE, PWM_DUTY_FULL) == (PWM_ARR_MAX + 1U));
+}
+
+static void test_deadtime_to_dtg(void) {
+    // 16 MHz gives 62.5 ns per tick; the dead-time is rounded up to the next whole tick
+    TEST_CHECK(pwm_deadtime_to_dtg(PWM_TIM_CLK, 0U) == 0U);
+    TEST_CHECK(pwm_deadtime_to_dtg(PWM_TIM_CLK, 62U) == 1U);
+    TEST_CHECK(pwm_deadtime_to_dtg(PWM_TIM_CLK, 63U) == 2U);
+    TEST_CHECK(pwm_deadtime_to_dtg(PWM_TIM_CLK, 1000U) == 16U);
+
+    // Every tick count maps to the shortest encodable dead-time that is not shorter
+    for (uint32_t ticks = 0U; ticks <= 1008U; ticks++) {
+        uint32_t deadtime_ns = (uint32_t)(((uint64_t)ticks * 1000000000U) / PWM_TIM_CLK);
+        uint8_t dtg = pwm_deadtime_to_dtg(PWM_TIM_CLK, deadtime_ns);
+
+        TEST_CHECK(dtg_to_ticks(dtg) >= ticks);
+        TEST_CHECK((dtg == 0U) || (dtg_to_ticks(dtg - 1U) < ticks));
+    }
+
+    // Longer dead-times saturate at 1008 ticks
+    TEST_CHECK(pwm_deadtime_to_dtg(PWM_TIM_CLK, 100000U) == 0xFFU);
+}
+
+static uint32_t dtg_to_ticks(uint8_t dtg) {
+    // Dead-time generator decoding (RM0383, TIM1_BDTR DTG[7:0])
+    if ((dtg & 0x80U) == 0U) {
+        return dtg;
+    }
+
+    if ((dtg & 0xC0U) == 0x80U) {
+        return (64U + (dtg & 0x3FU)) * 2U;
+    }
+
+    if ((dtg & 0xE0U) == 0xC0U) {
+        return (32U + (dtg & 0x1FU)) * 8U;
+    }
+
+    return (32U + (dtg & 0x1FU)) * 16U;
+}
@@ -0,0 +1,221 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include "test.h"
+#include "queue.h"
+
+/* Host stress test of the lock-free queues
+ * Producer threads stand in for interrupt handlers and the main thread is the consumer. Small queues
+ * keep both sides running into the full and empty states all the time. The consumer checks that every
+ * element arrives exactly once, in the order of its producer and with an intact payload. On the host
+ * queue.h uses the GCC __atomic builtins in place of LDREX/STREX and DMB.
+ */
+
+// Macro to define the number of elements sent through each queue
+#define QUEUE_TEST_ELEMENTS 200000U
+
+// Macro to define the number of MPSC producer threads
+#define QUEUE_TEST_PRODUCERS 4U
+
+// Element of the MPSC test, the check word detects torn copies
+typedef struct {
+    uint32_t producer; // Index of the producer thread
+    uint32_t seq;      // Position in the sequence of its producer
+    uint32_t check;    // Complement of seq
+} queue_test_elem_t;
+
+// Producer threads that have pushed all of their elements
+static volatile uint32_t producers_done;
+
+SPSC_QUEUE_DEFINE(word_queue, uint32_t, 64);
+SPSC_QUEUE_DEFINE(byte_queue, uint8_t, 16);
+MPSC_QUEUE_DEFINE(multi_queue, queue_test_elem_t, 64);
+
+static void producer_finish(void);
+static uint8_t producers_finished(uint32_t producers);
+static void *spsc_word_producer(void *arg);
+static void *spsc_byte_producer(void *arg);
+static void *mpsc_producer(void *arg);
+static void test_spsc_word(uint32_t start);
+static void test_spsc_byte(void);
+static void test_mpsc(void);
+
+int main(void) {
+    test_spsc_word(0U);
+
+    // Free-running indexes wrap around 2^32 during the run
+    test_spsc_word(UINT32_MAX - (QUEUE_TEST_ELEMENTS / 2U));
+
+    test_spsc_byte();
+    test_mpsc();
+
+    return TEST_RESULT("queue_test");
+}
+
+static void producer_finish(void) {
+    __atomic_add_fetch(&producers_done, 1U, __ATOMIC_SEQ_CST);
+}
+
+static uint8_t producers_finished(uint32_t producers) {
+    return (__atomic_load_n(&producers_done, __ATOMIC_SEQ_CST) == producers);
+}
+
+static void *spsc_word_producer(void *arg) {
+    (void)arg;
+
+    for (uint32_t i = 0; i < QUEUE_TEST_ELEMENTS;) {
+        if (spsc_queue_push(&word_queue, &i)) {
+            i++;
+        } else {
+            sched_yield();
+        }
+    }
+
+    producer_finish();
+
+    return NULL;
+}
+
+static void *spsc_byte_producer(void *arg) {
+    (void)arg;
+
+    for (uint32_t i = 0; i < QUEUE_TEST_ELEMENTS;) {
+        if (spsc_queue_push_byte(&byte_queue, (uint8_t)(i * 7U))) {
+            i++;
+        } else {
+            sched_yield();
+        }
+    }
+
+    producer_finish();
+
+    return NULL;
+}
+
+static void *mpsc_producer(void *arg) {
+    queue_test_elem_t elem = { (uint32_t)(uintptr_t)arg, 0U, 0U };
+
+    while (elem.seq < (QUEUE_TEST_ELEMENTS / QUEUE_TEST_PRODUCERS)) {
+        elem.check = ~elem.seq;
+
+        if (mpsc_queue_push(&multi_queue, &elem)) {
+            elem.seq++;
+        } else {
+            sched_yield();
+        }
+    }
+
+    producer_finish();
+
+    return NULL;
+}
+
+static void test_spsc_word(uint32_t start) {
+    pthread_t producer;
+    uint32_t out_of_order = 0;
+    uint32_t received = 0;
+    uint32_t value;
+
+    word_queue.head = start;
+    word_queue.tail = start;
+    producers_done = 0;
+
+    TEST_CHECK(pthread_create(&producer, NULL, spsc_word_producer, NULL) == 0);
+
+    // A lost element must not hang the test: the producers are sampled before draining, so the queue
+    // is empty for good once they were finished and the drain is over
+    for (uint8_t done = 0; !done; sched_yield()) {
+        done = producers_finished(1U);
+
+        while (spsc_queue_pop(&word_queue, &value)) {
+            out_of_order += (value != received);
+            received++;
+        }
+    }
+
+    TEST_CHECK(pthread_join(producer, NULL) == 0);
+    TEST_CHECK(received == QUEUE_TEST_ELEMENTS);
+    TEST_CHECK(out_of_order == 0U);
+
+    // Nothing is left over or duplicated
+    TEST_CHECK(spsc_queue_count(&word_queue) == 0U);
+    TEST_CHECK(!spsc_queue_pop(&word_queue, &value));
+    TEST_CHECK(word_queue.head == (start + QUEUE_TEST_ELEMENTS));
+}
+
+static void test_spsc_byte(void) {
+    pthread_t producer;
+    uint32_t out_of_order = 0;
+    uint32_t received = 0;
+    uint8_t value;
+
+    producers_done = 0;
+
+    TEST_CHECK(pthread_create(&producer, NULL, spsc_byte_producer, NULL) == 0);
+
+    for (uint8_t done = 0; !done; sched_yield()) {
+        done = producers_finished(1U);
+
+        while (spsc_queue_pop_byte(&byte_queue, &value)) {
+            out_of_order += (value != (uint8_t)(received * 7U));
+            received++;
+        }
+    }
+
+    TEST_CHECK(pthread_join(producer, NULL) == 0);
+    TEST_CHECK(received == QUEUE_TEST_ELEMENTS);
+    TEST_CHECK(out_of_order == 0U);
+    TEST_CHECK(!spsc_queue_pop_byte(&byte_queue, &value));
+}
+
+static void test_mpsc(void) {
+    pthread_t producers[QUEUE_TEST_PRODUCERS];
+    uint32_t next_seq[QUEUE_TEST_PRODUCERS] = { 0 };
+    uint32_t out_of_order = 0;
+    uint32_t torn = 0;
+    uint32_t unknown = 0;
+    uint32_t received = 0;
+    queue_test_elem_t elem;
+
+    mpsc_queue_init(&multi_queue);
+    producers_done = 0;
+
+    for (uint32_t p = 0; p < QUEUE_TEST_PRODUCERS; p++) {
+        TEST_CHECK(pthread_create(&producers[p], NULL, mpsc_producer, (void *)(uintptr_t)p) == 0);
+    }
+
+    for (uint8_t done = 0; !done; sched_yield()) {
+        done = producers_finished(QUEUE_TEST_PRODUCERS);
+
+        while (mpsc_queue_pop(&multi_queue, &elem)) {
+            received++;
+
+            if (elem.producer >= QUEUE_TEST_PRODUCERS) {
+                unknown++;
+                continue;
+            }
+
+            // Elements of one producer keep their order, elements of different producers interleave
+            torn += (elem.check != ~elem.seq);
+            out_of_order += (elem.seq != next_seq[elem.producer]);
+            next_seq[elem.producer] = elem.seq + 1U;
+        }
+    }
+
+    for (uint32_t p = 0; p < QUEUE_TEST_PRODUCERS; p++) {
+        TEST_CHECK(pthread_join(producers[p], NULL) == 0);
+    }
+
+    TEST_CHECK(received == QUEUE_TEST_ELEMENTS);
+    TEST_CHECK(unknown == 0U);
+    TEST_CHECK(torn == 0U);
+    TEST_CHECK(out_of_order == 0U);
+
+    // Every producer delivered all of its elements and the queue is empty again
+    for (uint32_t p = 0; p < QUEUE_TEST_PRODUCERS; p++) {
+        TEST_CHECK(next_seq[p] == (QUEUE_TEST_ELEMENTS / QUEUE_TEST_PRODUCERS));
+    }
+
+    TEST_CHECK(!mpsc_queue_pop(&multi_queue, &elem));
+    TEST_CHECK(multi_queue.head == multi_queue.tail);
+}
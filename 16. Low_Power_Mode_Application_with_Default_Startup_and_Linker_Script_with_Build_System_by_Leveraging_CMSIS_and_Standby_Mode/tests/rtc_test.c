@@ -0,0 +1,88 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <time.h>
+#include "test.h"
+#include "rtc.h"
+
+/* Host test of the RTC calendar conversions
+ * rtc_to_epoch() is compared with timegm() of the C library for every day from 2000 to 2099 (the range
+ * of the two-digit RTC year), and rtc_from_epoch() has to give back the same calendar and week day.
+ */
+
+// Days of each month in a non-leap year
+static const uint8_t days_in_month[12] = { 31U, 28U, 31U, 30U, 31U, 30U, 31U, 31U, 30U, 31U, 30U, 31U };
+
+// Times of day checked on every day: midnight, a mixed value and the last second
+static const uint8_t times_of_day[][3] = { { 0U, 0U, 0U }, { 13U, 37U, 42U }, { 23U, 59U, 59U } };
+
+static void test_day(uint16_t year, uint8_t month, uint8_t day);
+static void test_sequence(void);
+
+int main(void) {
+    for (uint16_t year = 2000U; year <= 2099U; year++) {
+        for (uint8_t month = 1U; month <= 12U; month++) {
+            uint8_t days = days_in_month[month - 1U] + (((month == 2U) && ((year % 4U) == 0U)) ? 1U : 0U);
+
+            for (uint8_t day = 1U; day <= days; day++) {
+                test_day(year, month, day);
+            }
+        }
+    }
+
+    test_sequence();
+
+    return TEST_RESULT("rtc_test");
+}
+
+static void test_day(uint16_t year, uint8_t month, uint8_t day) {
+    for (uint32_t i = 0; i < (sizeof(times_of_day) / sizeof(times_of_day[0])); i++) {
+        struct tm reference = { 0 };
+        rtc_snapshot_t datetime;
+
+        reference.tm_year = year - 1900;
+        reference.tm_mon = month - 1;
+        reference.tm_mday = day;
+        reference.tm_hour = times_of_day[i][0];
+        reference.tm_min = times_of_day[i][1];
+        reference.tm_sec = times_of_day[i][2];
+
+        // timegm() also fills in the week day, 0 (Sunday) to 6 (Saturday)
+        uint32_t expected = (uint32_t)timegm(&reference);
+        uint32_t epoch = rtc_to_epoch(year, month, day, times_of_day[i][0], times_of_day[i][1], times_of_day[i][2]);
+        TEST_CHECK(epoch == expected);
+
+        rtc_from_epoch(epoch, &datetime);
+        TEST_CHECK(datetime.year == year);
+        TEST_CHECK(datetime.month == month);
+        TEST_CHECK(datetime.day == day);
+        TEST_CHECK(datetime.hour == times_of_day[i][0]);
+        TEST_CHECK(datetime.minute == times_of_day[i][1]);
+        TEST_CHECK(datetime.second == times_of_day[i][2]);
+        TEST_CHECK(datetime.millisecond == 0U);
+        TEST_CHECK(datetime.epoch == epoch);
+        TEST_CHECK(datetime.weekday == ((reference.tm_wday == 0) ? 7U : (uint8_t)reference.tm_wday));
+    }
+}
+
+static void test_sequence(void) {
+    rtc_snapshot_t datetime;
+
+    // First and last second of the range
+    TEST_CHECK(rtc_to_epoch(2000U, 1U, 1U, 0U, 0U, 0U) == 946684800U);
+    TEST_CHECK(rtc_to_epoch(2099U, 12U, 31U, 23U, 59U, 59U) == 4102444799U);
+
+    // 2000-01-01 was a Saturday
+    rtc_from_epoch(946684800U, &datetime);
+    TEST_CHECK(datetime.weekday == 6U);
+
+    // Seconds around the start of 2000-02-29, 2000-03-01, 2009-01-01 and 2096-03-01 convert back unchanged
+    static const uint32_t midnights[] = { 951782400U, 951868800U, 1230768000U, 3981398400U };
+
+    for (uint32_t i = 0; i < (sizeof(midnights) / sizeof(midnights[0])); i++) {
+        for (uint32_t epoch = midnights[i] - 2U; epoch < (midnights[i] + 2U); epoch++) {
+            rtc_from_epoch(epoch, &datetime);
+            TEST_CHECK(rtc_to_epoch(datetime.year, datetime.month, datetime.day,
+                                    datetime.hour, datetime.minute, datetime.second) == epoch);
+        }
+    }
+}
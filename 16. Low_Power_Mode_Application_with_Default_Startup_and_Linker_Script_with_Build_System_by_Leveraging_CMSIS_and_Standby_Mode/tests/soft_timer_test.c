@@ -0,0 +1,129 @@
+#include <stdint.h>
+#include "test.h"
+#include "soft_timer.h"
+#include "systick.h"
+
+/* Host test of the timer wheel deadline query
+ * The test supplies millis() and advances it by hand, so the wheel can be left behind the tick counter
+ * the way it is when nothing has called soft_timer_process() yet. soft_timer_ms_until_next() has to
+ * report the real distance to the next timer then, and 0 only for timers that are already due.
+ */
+
+// Macro to define the limit passed to every query
+#define TEST_LIMIT_MS 60000U
+
+// Tick counter returned by millis()
+static uint32_t test_now;
+
+// Number of callbacks run by soft_timer_process()
+static uint32_t test_expired;
+
+static void test_callback(void *arg);
+static void test_uninitialized(void);
+static void test_unprocessed_wheel(void);
+static void test_later_revolution(void);
+static void test_long_lag(void);
+
+void systick_init(void) {
+}
+
+uint32_t millis(void) {
+    return test_now;
+}
+
+int main(void) {
+    test_uninitialized();
+    test_unprocessed_wheel();
+    test_later_revolution();
+    test_long_lag();
+
+    return TEST_RESULT("soft_timer_test");
+}
+
+static void test_callback(void *arg) {
+    (void)arg;
+    test_expired++;
+}
+
+static void test_uninitialized(void) {
+    // Without soft_timer_init() there are no timers, whatever the tick counter says
+    test_now = 12345U;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == TEST_LIMIT_MS);
+    TEST_CHECK(soft_timer_ms_until_next(7U) == 7U);
+}
+
+static void test_unprocessed_wheel(void) {
+    test_now = 1000U;
+    soft_timer_init();
+
+    // An empty wheel that lags behind the tick counter still allows the full limit
+    test_now += 30U;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == TEST_LIMIT_MS);
+
+    soft_timer_id_t id = soft_timer_start(50U, 0U, test_callback, NULL);
+    TEST_CHECK(id != SOFT_TIMER_INVALID);
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 50U);
+    TEST_CHECK(soft_timer_ms_until_next(20U) == 20U);
+
+    // Time passes without soft_timer_process(), the distance shrinks instead of collapsing to 0
+    test_now += 20U;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 30U);
+    test_now += 29U;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 1U);
+
+    // A due timer needs soft_timer_process()
+    test_now += 1U;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 0U);
+    test_now += 5U;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 0U);
+
+    test_expired = 0;
+    TEST_CHECK(soft_timer_process() == 1U);
+    TEST_CHECK(test_expired == 1U);
+    TEST_CHECK(!soft_timer_is_active(id));
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == TEST_LIMIT_MS);
+
+    // A periodic timer reports its next period after processing
+    id = soft_timer_start(10U, 10U, test_callback, NULL);
+    test_now += 4U;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 6U);
+    test_now += 6U;
+    TEST_CHECK(soft_timer_process() == 1U);
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 10U);
+    TEST_CHECK(soft_timer_cancel(id));
+}
+
+static void test_later_revolution(void) {
+    test_now = 5000U;
+    soft_timer_init();
+
+    // Both timers share a slot, the later revolution must not hide the nearer one
+    soft_timer_id_t far = soft_timer_start(SOFT_TIMER_WHEEL_SLOTS + 40U, 0U, test_callback, NULL);
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == (SOFT_TIMER_WHEEL_SLOTS + 40U));
+
+    soft_timer_id_t near = soft_timer_start(40U, 0U, test_callback, NULL);
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 40U);
+
+    // Unprocessed, the far timer still bounds the result once the near one is gone
+    TEST_CHECK(soft_timer_cancel(near));
+    test_now += 100U;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == (SOFT_TIMER_WHEEL_SLOTS - 60U));
+    TEST_CHECK(soft_timer_cancel(far));
+}
+
+static void test_long_lag(void) {
+    test_now = 9000U;
+    soft_timer_init();
+
+    // The wheel falls more than a revolution behind, a timer that became due meanwhile is found
+    soft_timer_start(3U * SOFT_TIMER_WHEEL_SLOTS, 0U, test_callback, NULL);
+    test_now += 2U * SOFT_TIMER_WHEEL_SLOTS;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == SOFT_TIMER_WHEEL_SLOTS);
+    test_now += SOFT_TIMER_WHEEL_SLOTS;
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == 0U);
+
+    test_expired = 0;
+    TEST_CHECK(soft_timer_process() == 1U);
+    TEST_CHECK(test_expired == 1U);
+    TEST_CHECK(soft_timer_ms_until_next(TEST_LIMIT_MS) == TEST_LIMIT_MS);
+}
@@ -0,0 +1,28 @@
+#ifndef TESTS_TEST_H_
+#define TESTS_TEST_H_
+
+#include <stdio.h>
+
+/* Minimal host test helpers
+ * TEST_CHECK() reports a failed condition with its location and keeps going, so one run lists every
+ * failure. TEST_RESULT() prints the summary and yields the exit status of the test program.
+ */
+
+static unsigned test_checks;
+static unsigned test_failures;
+
+// Macro to check a condition and report it when it does not hold
+#define TEST_CHECK(cond) \
+    do { \
+        test_checks++; \
+        if (!(cond)) { \
+            test_failures++; \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+// Macro to print the summary of a test program and return its exit status
+#define TEST_RESULT(name) \
+    (printf("%s: %u checks, %u failed\n", (name), test_checks, test_failures), (test_failures != 0U))
+
+#endif /* TESTS_TEST_H_ */
@@ -200,9 +200,9 @@ void Default_Handler(void) {
 /* Reset Handler */
 /* It prepares the system before executing the main application. */
 void Reset_Handler(void) {
-    // Calculate the sizes of the .data and .bss sections
-    uint32_t data_mem_size = (uint32_t)&_edata - (uint32_t)&_sdata;  // It is used to copy initialized data from FLASH to SRAM.
-    uint32_t bss_mem_size = (uint32_t)&_ebss - (uint32_t)&_sbss;     // It is used to zero out the .bss section in SRAM.
+    // Calculate the sizes of the .data and .bss sections in words (the linker symbols are byte addresses)
+    uint32_t data_mem_size = ((uint32_t)&_edata - (uint32_t)&_sdata) / 4U;  // It is used to copy initialized data from FLASH to SRAM.
+    uint32_t bss_mem_size = ((uint32_t)&_ebss - (uint32_t)&_sbss) / 4U;     // It is used to zero out the .bss section in SRAM.
 
     // Initialize pointers to the source and destination of the .data section
     uint32_t *p_src_mem = (uint32_t *)&_etext;  // A source pointer to the address where initialized data is stored in flash memory